@@ -31,7 +31,7 @@ THREE.WebAR.MAX_FLOAT32_VALUE = 3.4028e38;
 /**
 * A class that allows to manage the point cloud acquisition and representation in ThreeJS. A buffer geometry is generated to represent the point cloud. The point cloud is provided using a VRDisplay instance that shows the capability to do so. The point cloud is actually exposed using a TypedArray. The array includes 3 values per point in the cloud. There are 2 ways of exposing this array:
 * 1.- Using a new TypedArray for every frame/update. The advantage is that the TypedArray is always of the correct size depending on the number of points detected. The disadvantage is that there is a performance hit from the creation and copying of the array (and future garbage collection).
-* 2.- Using the same reference to a single TypedArray. The advantage is that the performance is as good as it can get with no creation/destruction and copy penalties. The disadvantage is that the size of the array is the biggest possible point cloud provided by the underlying hardware. The non used values are filled with THREE.WebAR.MAX_FLOAT32_VALUE.
+* 2.- Using the same reference to a single TypedArray. The advantage is that the performance is as good as it can get with no creation/destruction and copy penalties. The disadvantage is that the size of the array is the biggest possible point cloud provided by the underlying hardware. The draw range of the buffer geometry is set to the number of points so the non used values are neither drawn nor uploaded.
 * @constructor
 * @param {window.VRDisplay} vrDisplay The reference to the VRDisplay instance that is capable of providing the point cloud.
 *
@@ -50,7 +50,11 @@ THREE.WebAR.VRPointCloud = function(vrDisplay) {
   if (vrDisplay) {
     this._pointCloud = new VRPointCloud();
     vrDisplay.getPointCloud(this._pointCloud, false, 0);
+    // The points of the VRPointCloud are allocated once with the maximum
+    // number of points and reused by every update. The geometry uses them
+    // directly and only draws the first numberOfPoints.
     positions = this._pointCloud.points;
+    this._bufferGeometry.setDrawRange(0, this._pointCloud.numberOfPoints);
   }
   else {
     positions = new Float32Array(
@@ -61,11 +65,6 @@ THREE.WebAR.VRPointCloud = function(vrDisplay) {
   var color = new THREE.Color();
 
   for ( var i = 0; i < colors.length; i += 3 ) {
-    if (vrDisplay) {
-      positions[ i ]     = THREE.WebAR.MAX_FLOAT32_VALUE;
-      positions[ i + 1 ] = THREE.WebAR.MAX_FLOAT32_VALUE;
-      positions[ i + 2 ] = THREE.WebAR.MAX_FLOAT32_VALUE;
-    }
     color.setRGB( 1, 1, 1 );
     colors[ i ]     = color.r;
     colors[ i + 1 ] = color.g;
@@ -107,7 +106,18 @@ THREE.WebAR.VRPointCloud.prototype.update = function(updateBufferGeometry, point
     !updateBufferGeometry, typeof(pointsToSkip) === "number" ? 
       pointsToSkip : 0);
   if (!updateBufferGeometry) return;
-  if (this._pointCloud.numberOfPoints > 0) {
+  var points = this._pointCloud.points;
+  if (points !== this._positions.array) {
+    // The maximum number of points has changed (VRDisplay.configureSensors).
+    this._positions.setArray(points);
+    this._colors.setArray(new Float32Array(this._positions.array.length).fill(1));
+  }
+  var numberOfPoints = this._pointCloud.numberOfPoints;
+  this._bufferGeometry.setDrawRange(0, numberOfPoints);
+  if (numberOfPoints > 0) {
+    // Only upload the points that are drawn.
+    this._positions.updateRange.offset = 0;
+    this._positions.updateRange.count = numberOfPoints * 3;
     this._positions.needsUpdate = true;
   }
 };
@@ -257,6 +267,9 @@ THREE.WebAR.createVRSeeThroughCameraMesh = function(vrDisplay,
   videoTexture.magFilter = THREE.NearestFilter;
   videoTexture.format = THREE.RGBFormat;
   videoTexture.flipY = false;
+  // The see through camera can only be uploaded into a camera texture bound
+  // to TEXTURE_EXTERNAL_OES, the WebAR three.js build creates one for it.
+  videoTexture.WebAR_isSeeThroughCamera = !!vrDisplay;
 
   // The material is different if the see through camera is provided inside the vrDisplay or not.
   var material;
@@ -343,6 +356,21 @@ THREE.WebAR.createVRSeeThroughCamera = function(vrDisplay, near, far) {
   return camera;
 };
 
+/**
+* Applies the render scale of the VRDisplay adaptive resolution (see VRDisplay.enableAdaptiveResolution) to the size of the drawing buffer of the renderer. The canvas keeps its size on the page, only its resolution changes. Call it at the start of each frame.
+* @param {VRDisplay} vrDisplay The VRDisplay that adjusts the render scale. It could be null/undefined.
+* @param {THREE.WebGLRenderer} renderer The ThreeJS renderer to update.
+* @return {number} The render scale that was applied, 1 if there is no VRDisplay.
+*/
+THREE.WebAR.updateRendererScale = function(vrDisplay, renderer) {
+  var renderScale = vrDisplay ? vrDisplay.renderScale : 1;
+  var pixelRatio = window.devicePixelRatio * renderScale;
+  if (renderer.getPixelRatio() !== pixelRatio) {
+    renderer.setPixelRatio(pixelRatio);
+  }
+  return renderScale;
+};
+
 /**
 * Recalculate a camera projection matrix depending on the current device and see through camera orientation and specification.
 * @param {VRDisplay} vrDisplay The VRDisplay that handles the see through camera.
@@ -439,15 +467,18 @@ THREE.WebAR.rotateObject3D = function(normal1, normal2, object3d) {
 
 /**
 * Transform a given THREE.Object3D instance to be correctly oriented according to a given plane normal.
-* @param {THREE.Vector3|THREE.Vector4|Float32Array} plane A vector that represents the normal of the plane to be used to orient the object3d.
+* @param {THREE.Vector3|THREE.Vector4|Float32Array|Float64Array} plane A vector that represents the normal of the plane to be used to orient the object3d.
 * @param {THREE.Object3D} object3d The object3d to be transformed so it is oriented according to the given plane.
+* @param {number} [offset=0] Where the normal starts in a typed array plane, for example 3 in the results of VRDisplay.getPickingPointAndPlaneInPointCloudInto.
 */
-THREE.WebAR.rotateObject3DWithPickingPlane = function(plane, object3d) {
+THREE.WebAR.rotateObject3DWithPickingPlane = function(plane, object3d, offset) {
   if (plane instanceof THREE.Vector3 || plane instanceof THREE.Vector4) {
     THREE.WebAR._planeNormal.set(plane.x, plane.y, plane.z);
   }
-  else if (plane instanceof Float32Array) {
-    THREE.WebAR._planeNormal.set(plane[0], plane[1], plane[2]);
+  else if (plane instanceof Float32Array || plane instanceof Float64Array) {
+    offset = offset || 0;
+    THREE.WebAR._planeNormal.set(plane[offset], plane[offset + 1], 
+      plane[offset + 2]);
   }
   else {
     throw "Unknown plane type.";
@@ -476,15 +507,18 @@ THREE.WebAR.rotateObject3DWithPickingPlane = function(plane, object3d) {
 
 /**
 * Transform a given THREE.Object3D instance to be correctly positioned according to a given point position.
-* @param {THREE.Vector3|THREE.Vector4|Float32Array} point A vector that represents the position where the object3d should be positioned.
+* @param {THREE.Vector3|THREE.Vector4|Float32Array|Float64Array} point A vector that represents the position where the object3d should be positioned.
 * @param {THREE.Object3D} object3d The object3d to be transformed so it is positioned according to the given point.
+* @param {number} [offset=0] Where the point starts in a typed array point.
 */
-THREE.WebAR.positionObject3DWithPickingPoint = function(point, object3d) {
+THREE.WebAR.positionObject3DWithPickingPoint = function(point, object3d, 
+  offset) {
   if (point instanceof THREE.Vector3 || point instanceof THREE.Vector4) {
     object3d.position.set(point.x, point.y, point.z);
   }
-  else if (point instanceof Float32Array) {
-    object3d.position.set(point[0], point[1], point[2]);
+  else if (point instanceof Float32Array || point instanceof Float64Array) {
+    offset = offset || 0;
+    object3d.position.set(point[offset], point[offset + 1], point[offset + 2]);
   }
   else {
     throw "Unknown point type.";
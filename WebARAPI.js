@@ -47,6 +47,58 @@
 * @description WebAR devices will be exposed as VRDisplay instances. The pose estimation is exposed using the exact same methods as in any other VR display, although in the case of the Tango underlying implementation, the pose will be 6DOF (position and orientation). Some new methods have been added though to the VRDisplay class of the WebVR spec to provide new functionalities {@link https://w3c.github.io/webvr/#interface-vrdisplay}.
 */
 
+/**
+* @name VRDisplay#connectionState
+* @type {string}
+* @description The state of the connection to the underlying hardware: "connecting", "connected", "disconnected" (for example while the page is paused) or "failed".
+* @see VRDisplay#waitForConnectionStateChange
+* @readonly
+*/
+
+/**
+* @name VRDisplay#connectionError
+* @type {string}
+* @description The reason the connection failed, or null if the connectionState is not "failed".
+* @readonly
+*/
+
+/**
+* @name VRDisplay#animationFrameMode
+* @type {string}
+* @description When the requestAnimationFrame callbacks run. "display" (the default) runs them at the display rate with the pose of the latest camera frame. "camera" only runs them when there is a new camera frame, which is about half the display rate, so the GPU does not redraw the same camera image. "interpolated" runs them at the display rate, but the frames in between camera frames get the latest pose instead, which does not match any camera frame. If no camera frame arrives within 100 ms, "camera" runs the callbacks anyway.
+*/
+
+/**
+* @method VRDisplay#enableAdaptiveResolution
+* @description Measures the GPU time of the requestAnimationFrame callbacks that render into the canvas and adjusts renderScale for it to stay within the budget. The scale goes down after a few frames over the budget and only goes back up after a longer run of frames well under it, so it does not keep changing. The page applies renderScale to the size of its drawing buffer (see THREE.WebAR.updateRendererScale) and can use it to keep its UI readable. Calling it again replaces the previous configuration.
+* @param {HTMLCanvasElement} source - The canvas with the WebGL context the page renders with.
+* @param {VRAdaptiveResolutionConfiguration} configuration - The bounds of the scale and the budget. Omitted members take their default values.
+* @throws {RangeError} If the scales do not satisfy 0 < minScale <= maxScale <= 1 or if targetFrameTime is not positive.
+* @throws {InvalidStateError} If the canvas does not have a WebGL context.
+* @throws {NotSupportedError} If the GPU does not support timestamp queries (EXT_disjoint_timer_query with GL_TIMESTAMP_EXT). The frame is timed with timestamps, so the page can still use its own GL_TIME_ELAPSED_EXT queries in its callbacks.
+*/
+
+/**
+* @method VRDisplay#disableAdaptiveResolution
+* @description Stops adjusting the render scale, renderScale goes back to 1.
+*/
+
+/**
+* @name VRDisplay#renderScale
+* @type {number}
+* @description The scale to apply to the full resolution of the canvas, between the minScale and maxScale of the adaptive resolution configuration. It only changes in between animation frames. 1 while the adaptive resolution is disabled.
+* @readonly
+*/
+
+/**
+* @name VRAdaptiveResolutionConfiguration
+* @class
+* @description The dictionary passed to {@link VRDisplay#enableAdaptiveResolution}.
+* @property {number} minScale - The lowest render scale. 0.5 by default.
+* @property {number} maxScale - The highest render scale, which is also the initial one. 1 by default.
+* @property {number} targetFrameTime - The GPU time budget of an animation frame, in milliseconds. 12 by default.
+*/
+
 /**
 * @method VRDisplay#getMaxNumberOfPointsInPointCloud
 * @description Returns the maximum number of points/vertices that the VRDisplay is able to represent. This value will be bigger than 0 only if the VRDisplay is able to provide a point cloud. 
@@ -73,13 +125,96 @@
 * @returns {VRPickingPointAndPlane} - An instance of a {@link VRPickingPointAndPlane} to represent the collision point and plane normal of the ray traced from the passed (x, y) 2D position into the 3D mesh represented by the point cloud. null is returned if no support for point cloud is provided by the VRDisplay or if no colission has been detected.
 */
 
+/**
+* @method VRDisplay#getPickingPointAndPlaneInPointCloudInto
+* @description The same as getPickingPointAndPlaneInPointCloud, but the result is written into an array of the caller instead of a {@link VRPickingPointAndPlane}, so picking every frame does not allocate any object. 7 values are written from the offset on: the point (x, y, z) followed by the plane (a, b, c, d). The array is not modified if no collision has been detected.
+* @param {float} x - The horizontal normalized value (0-1) of the screen position.
+* @param {float} y - The vertival normalized value (0-1) of the screen position.
+* @param {Float32Array|Float64Array} result - The array to write the point and the plane into. A TypeError is thrown for any other type of array and a RangeError if the 7 values do not fit from the offset on.
+* @param {number} [offset=0] - The index of the array where the point starts.
+* @returns {boolean} - true if a collision has been detected and written into the array.
+*/
+
+/**
+* @method VRDisplay#getPickingPointsAndPlanesInPointCloud
+* @description Picks several screen positions at once, with a single request to the underlying VRDisplay, and writes the results into an array of the caller. For each position, 7 values are written one after the other from the offset on: the point (x, y, z) followed by the plane (a, b, c, d). They are all NaN for the positions where no collision has been detected.
+* @param {Float32Array} coordinates - The normalized (0-1) screen positions, as (x, y) pairs.
+* @param {Float32Array|Float64Array} results - The array to write the points and the planes into. A TypeError is thrown for any other type of array and a RangeError if the results do not fit from the offset on.
+* @param {number} [offset=0] - The index of the array where the first point starts.
+* @returns {number} - The number of positions where a collision has been detected.
+*/
+
 /**
 * @method VRDisplay#getSeeThroughCamera
-* @description Returns an instance of {@link VRSeeThroughCamera} that represents a see through camera (both for AR or VR). The underlying VRDisplay needs to be able to provide such a camera or this method will return null.
+* @description Returns an instance of {@link VRSeeThroughCamera} that represents a see through camera (both for AR or VR). The underlying VRDisplay needs to be able to provide such a camera or this method will return null. The camera information is kept up to date by the browser (it changes on reconnection or device rotation) so this method is cheap and can be called every frame.
 * @see VRDisplayCapabilities
 * @returns {VRSeeThroughCamera} - An instance of a {@link VRSeeThroughCamera} to represent a see through camera or null if no camera is supported.
 */
 
+/**
+* @method VRDisplay#waitForPointCloud
+* @description Returns a promise that is resolved when the VRDisplay has a new point cloud. Depth is acquired at a much lower rate than the display refresh rate, so pages that only need the point cloud when it changes can wait for it instead of calling getPointCloud every frame. The browser only notifies the page while there are pending promises.
+* @returns {Promise} - A promise resolved with the timestamp (in seconds) of the new point cloud. It is rejected if the VRDisplay is not available, or stops being available before it is resolved.
+*/
+
+/**
+* @method VRDisplay#waitForTrackingStateChange
+* @description Returns a promise that is resolved the next time the underlying hardware loses or recovers the motion tracking.
+* @returns {Promise} - A promise resolved with true if the device is tracking and false if the tracking has been lost. It is rejected if the VRDisplay is not available, or stops being available before it is resolved.
+*/
+
+/**
+* @method VRDisplay#waitForConnectionStateChange
+* @description Returns a promise that is resolved the next time the connection state of the VRDisplay changes. The underlying hardware connects in the background when the page starts and when it resumes, so the poses, the point cloud and the see through camera are not available until the state becomes "connected".
+* @returns {Promise} - A promise resolved with the new connectionState. It is rejected if the VRDisplay is not available, or stops being available before it is resolved.
+*/
+
+/**
+* @method VRDisplay#requestPointCloud
+* @description The asynchronous version of getPointCloud. It does not block the page while the point cloud is retrieved, so it can be requested early in a frame and used later on, or in the next frame.
+* @param {VRPointCloud} pointCloud - The {@link VRPointCloud} instance to be updated when the point cloud arrives. It should not be read until the promise is resolved.
+* @param {boolean} justUpdatePointCloud - The same as in getPointCloud.
+* @param {number} pointsToSkip - The same as in getPointCloud.
+* @returns {Promise} - A promise resolved with the given {@link VRPointCloud} once it has been updated. It is rejected if the VRDisplay is not available, or stops being available before it is resolved.
+*/
+
+/**
+* @method VRDisplay#requestPickingPointAndPlaneInPointCloud
+* @description The asynchronous version of getPickingPointAndPlaneInPointCloud.
+* @param {float} x - The horizontal normalized value (0-1) of the screen position.
+* @param {float} y - The vertival normalized value (0-1) of the screen position.
+* @returns {Promise} - A promise resolved with a new {@link VRPickingPointAndPlane} instance or null if no collision has been detected. It is rejected if the VRDisplay is not available, or stops being available before it is resolved.
+*/
+
+/**
+* @method VRDisplay#requestSeeThroughCamera
+* @description The promise based version of getSeeThroughCamera, provided for consistency with the other request methods.
+* @returns {Promise} - A promise resolved with the {@link VRSeeThroughCamera} or null if no camera is supported. It is rejected if the VRDisplay is not available.
+*/
+
+/**
+* @method VRDisplay#requestADFs
+* @description Returns a promise that is resolved with the area description files (ADFs) stored in the device, without blocking the page while they are listed.
+* @returns {Promise} - A promise resolved with an array of VRADF instances. It is rejected if the VRDisplay is not available, or stops being available before it is resolved.
+*/
+
+/**
+* @method VRDisplay#configureSensors
+* @description Chooses how much work the underlying hardware does to acquire the point cloud and the camera image, so pages that need less detail put less load on the device. The configuration is applied without interrupting the motion tracking. Independently of the configuration, depth is only acquired while the page uses the point cloud: it is turned off about 5 seconds after the last point cloud request, whether the page keeps requesting poses or not, and the first point clouds take a moment to arrive when it is turned back on. The color camera cannot be turned off without interrupting the motion tracking, so it keeps running while the VRDisplay is connected even if the page never uses the camera image. Only the camera frames stop being held for the page 5 seconds after it last used them. When the maximum number of points changes, the points array of the {@link VRPointCloud} instances is replaced with a new one of the new size on their next update.
+* @param {VRSensorConfiguration} configuration - The configuration to apply. Omitted members take their default values.
+* @returns {Promise} - A promise resolved once the configuration is applied. It is rejected with a NotSupportedError that explains why if the VRDisplay does not support the configuration, in which case nothing changes. It is also rejected if the VRDisplay stops being available before the configuration is applied.
+*/
+
+/**
+* @name VRSensorConfiguration
+* @class
+* @description The dictionary passed to {@link VRDisplay#configureSensors}.
+* @property {number} depthFramerate - The number of point clouds acquired per second, between 0 and 5. 0 turns depth off. 5 by default.
+* @property {number} maxNumberOfPointsInPointCloud - The maximum number of points in the point cloud. The points are skipped evenly to stay within the limit. 0, the default, means as many points as the hardware supports. Must be 0 when depth is turned off.
+* @property {number} cameraImageWidth - The width of the camera image. 0, the default, means the native width. The color camera only supports its native resolution at the moment.
+* @property {number} cameraImageHeight - The height of the camera image. 0, the default, means the native height.
+*/
+
 // ==================================================================================
 // ==================================================================================
 
@@ -110,9 +245,10 @@
 /**
 * @name VRPointCloud
 * @class
-* @description A class that represents the point cloud acquired by the underlying VRDisplay when a call to getPointCloud is made. A point cloud is just a set of triplets (x, y, z) that represent each 3D position of each vertex/point in the point cloud. In order to make this structure as fast as possible, the Float32Array is always of the maximum vertex count possible depending on the underlywing VRDisplay. Of course, the exact number of points that have been correctly acquired is also provided in the VRPointCloud instance.
-* NOTE: In order to improve performance, a single Float32Array instance is allocated with the maximum capacity of points that the underlying SDK could provide. This is why the numberOfPoints property is also passed along with the points property. It is up to the developer to correctly use/copy the values.
+* @description A class that represents the point cloud acquired by the underlying VRDisplay when a call to getPointCloud is made. A point cloud is just a set of triplets (x, y, z) that represent each 3D position of each vertex/point in the point cloud. In order to make this structure as fast as possible, the points are stored in a single Float32Array with room for the maximum number of points the underlying VRDisplay can provide. Only its first numberOfPoints points are valid, numberOfPoints is the range to draw.
+* NOTE: In order to improve performance, the array is allocated once and reused by every update, it is not allocated again when the number of points changes. It is up to the developer to correctly use/copy the values.
 * To be able to use this structure, just create an instance of it and update it using the getPointCloud method described in the VRDisplay structure.
+* It can also be created in a DedicatedWorker, where there is no VRDisplay to update it, to pass it to bufferSubData on an OffscreenCanvas WebGL context. The main thread posts the numberOfPoints to draw.
 */
 
 /**
@@ -125,10 +261,87 @@
 /**
 * @name VRPointCloud#points
 * @type {Float32Array}
-* @description An array of triplets representing each 3D vertices of the point cloud. The size of this array is always of the maximum number of points the underlying platform can provide in order to improvde performance. The real number of points is provided in the numberOfPoints property. The remaining points when the real number of points is less than the maximum possible is filled with the maximum possible float value so they can be discarded.
+* @description An array of triplets representing each 3D vertices of the point cloud. It has room for the maximum number of points the underlying platform can provide and is reused by every update, only the first numberOfPoints points are valid. The values beyond numberOfPoints are left over from previous updates and are not meaningful, they are not filled with any sentinel value. A renderer keeps the array and only draws (and uploads) the first numberOfPoints points. A new array is only allocated when the maximum number of points changes (see VRDisplay.configureSensors).
+* @readonly
+*/
+
+/**
+* @name VRPointCloud#generation
+* @type {long}
+* @description A number that changes every time the point cloud is updated, so the renderer can skip the upload when the points have not changed.
 * @readonly
 */
 
+// ==================================================================================
+// WebGLRenderingContext
+// ==================================================================================
+
+/**
+* @name WebGLRenderingContext
+* @class
+* @description Added a see through camera texture and overloads of bufferSubData and texImage2D to the WebGLRenderingContext and WebGL2RenderingContext classes {@link https://www.khronos.org/registry/webgl/specs/latest/1.0/}.
+*/
+
+/**
+* @method WebGLRenderingContext#bufferSubData
+* @description Fills the buffer bound to the target, from the offset to the end of the buffer, with the latest point cloud acquired by the underlying VRDisplay. Each point is 3 floats (x, y, z). The points are written by the GPU directly, so they never go through JavaScript memory. If there are fewer points than fit in the buffer, the remaining points hold the maximum float value so they are out of sight and the whole range can be drawn (VRPointCloud.points has no such values, it is drawn up to its numberOfPoints). Only the valid points are uploaded: the remaining points are set the first time the range is written and afterwards only when the point cloud has fewer points than the previous one, so the range has to be passed the same way (same buffer and offset) on every call. Writing other data to the buffer with bufferData or bufferSubData makes the next call set all the remaining points again. If more points were acquired than fit in the buffer, points are skipped evenly. The number of points is only known to the GPU when the points are written, so it is not returned, and the numberOfPoints and points properties of the given VRPointCloud are not updated.
+* @param {GLenum} target - The buffer target, for example gl.ARRAY_BUFFER.
+* @param {number} offset - The offset in bytes where the points start.
+* @param {VRPointCloud} pointCloud - A {@link VRPointCloud} instance that identifies the point cloud source.
+*/
+
+/**
+* @name WebGLRenderingContext#TEXTURE_EXTERNAL_OES
+* @type {GLenum}
+* @description The texture target of the camera textures. Shaders sample it with a samplerExternalOES after declaring "#extension GL_OES_EGL_image_external : require".
+* @readonly
+*/
+
+/**
+* @name WebGLRenderingContext#TEXTURE_BINDING_EXTERNAL_OES
+* @type {GLenum}
+* @description The getParameter name that returns the camera texture bound to the active texture unit.
+* @readonly
+*/
+
+/**
+* @method WebGLRenderingContext#createCameraTexture
+* @description Creates a texture to hold the see through camera image. It can only be bound to TEXTURE_EXTERNAL_OES. The camera image is sampled directly from this texture, without any copy.
+* @return {WebGLTexture} The new camera texture.
+*/
+
+/**
+* @method WebGLRenderingContext#texImage2D
+* @description Updates the texture bound to the target with the camera frame that matches the latest pose from VRDisplay.getFrameData. The target has to be TEXTURE_EXTERNAL_OES with a texture created by createCameraTexture bound to it. TEXTURE_2D generates an INVALID_OPERATION error, a 2D texture cannot hold the camera image. The level, internalformat, format and type parameters are ignored.
+* @param {GLenum} target - TEXTURE_EXTERNAL_OES.
+* @param {GLint} level - Ignored.
+* @param {GLint} internalformat - Ignored.
+* @param {GLenum} format - Ignored.
+* @param {GLenum} type - Ignored.
+* @param {VRSeeThroughCamera} seeThroughCamera - The see through camera to get the image from.
+*/
+
+/**
+* @method WebGLRenderingContext#updateCameraTexture
+* @description The same as texImage2D with a VRSeeThroughCamera but with the id of the camera frame to upload. The VRDisplay is only available on the main document, so a DedicatedWorker that renders into an OffscreenCanvas receives VRSeeThroughCamera.frameId from the main thread, posted along with the pose, and updates its camera texture with it. The camera frame that matches the pose is uploaded in the same way.
+* @param {GLenum} target - TEXTURE_EXTERNAL_OES.
+* @param {number} cameraFrameId - The value of VRSeeThroughCamera.frameId that matches the pose used to render the frame.
+*/
+
+/**
+* @method WebGLRenderingContext#updateCameraUnderlay
+* @description Has the browser draw the camera frame beneath the page, so the page renders only the virtual content. The browser draws the camera image with the GPU, as the page would, and the transparent canvas is blended over it, so it does not save fill rate: on the software GL implementation a 1920x1080 frame takes about 7% longer than drawing the camera into an opaque canvas (tango_camera_underlay_perftests). It has to be called in every frame, the browser stops drawing the camera shortly after the page stops calling it. The canvas needs to be created with alpha and cleared to a transparent color, and the page background (html and body) has to be transparent too. The underlay covers the whole browser viewport, so the canvas is expected to be full screen. The browser draws the latest camera frame the page has given when it composites the page, which is not tied to the page frame being composited: when the page renders ahead of the compositor, the camera image can be a frame newer than the virtual content. Pages that need the camera image to match the pose exactly draw it into the canvas with a camera texture (see createCameraTexture) instead.
+* @param {number} cameraFrameId - The value of VRSeeThroughCamera.frameId that matches the pose used to render the frame.
+*/
+
+/**
+* @method WebGL2RenderingContext#latchPose
+* @description Writes the pose of the device into the buffer bound to the target when the GPU reaches this call, instead of when the page renders the frame, so the virtual content lags less behind the camera image. The data is the pose matrix (camera to world) followed by the view matrix (world to camera), both column major, that is a uniform block of two mat4 in the std140 layout (128 bytes). It is meant to be called on a UNIFORM_BUFFER right before the draw calls that read it. The matrices are built from the same orientation and position as a VRPose. If there is no pose, the buffer keeps the last one. Only available in WebGL 2.
+* @param {GLenum} target - The buffer target, usually gl.UNIFORM_BUFFER.
+* @param {number} offset - The offset in bytes where the matrices start.
+* @param {boolean} [cameraFrame=true] - Whether to latch the pose of the latest camera frame handed out with the poses (VRDisplay.getFrameData), or the latest pose if there is none yet. No camera frame is taken for the latch itself. A camera texture or underlay updated afterwards with a camera frame id of 0 then shows that same frame, so the camera image and the virtual content stay in sync. Pass false to latch the latest pose instead, for pages that do not show the camera.
+*/
+
 // ==================================================================================
 // VRSeeThroughCamera
 // ==================================================================================
@@ -201,3 +414,39 @@
 * @description The orientation of the camera.
 * @readonly
 */
+
+/**
+* @name VRSeeThroughCamera#frameId
+* @type {long}
+* @description The identifier of the camera frame that matches the pose returned by the latest call to getFrameData/getPose. Passing this VRSeeThroughCamera instance to texImage2D uploads exactly that camera frame so the camera image and the pose always match. 0 means that the latest pose does not correspond to any camera frame.
+* @readonly
+*/
+
+/**
+* @name VRSeeThroughCamera#undistortionLUTWidth
+* @type {long}
+* @description The number of columns of the undistortion lookup table.
+* @readonly
+*/
+
+/**
+* @name VRSeeThroughCamera#undistortionLUTHeight
+* @type {long}
+* @description The number of rows of the undistortion lookup table.
+* @readonly
+*/
+
+/**
+* @name VRSeeThroughCamera#undistortionLUT
+* @type {Float32Array}
+* @description A undistortionLUTWidth x undistortionLUTHeight grid of (u, v) pairs (row major, 2 floats per entry). The entry at column i and row j is the normalized coordinate in the camera image that corresponds to the undistorted normalized coordinate (i / (undistortionLUTWidth - 1), j / (undistortionLUTHeight - 1)). It can be used as the texture coordinates of a grid mesh or uploaded as a 2 channel float texture so undistorting the camera image is a single texture fetch. The table is calculated once every time the camera intrinsics change. It is null if the camera is not available.
+* @readonly
+*/
+
+/**
+* @method VRSeeThroughCamera#getProjectionMatrix
+* @description Returns a column major projection matrix that matches the camera image for the current display rotation. It is calculated from the camera intrinsics once the display rotation has been applied.
+* @param {number} depthNear - The near plane distance.
+* @param {number} depthFar - The far plane distance.
+* @returns {Float32Array} - The projection matrix or null if the camera is not available.
+*/
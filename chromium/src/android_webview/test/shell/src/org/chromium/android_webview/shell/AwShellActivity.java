@@ -557,6 +557,14 @@ public class AwShellActivity extends Activity implements OnRequestPermissionsRes
             TraceEvent.setATraceEnabled(true);
         }
 
+        if (CommandLine.getInstance().hasSwitch(AwShellSwitches.TANGO_SESSION_RECORDING_PATH)) {
+            String path = CommandLine.getInstance().getSwitchValue(
+                    AwShellSwitches.TANGO_SESSION_RECORDING_PATH);
+            if (!TangoJniNative.startRecording(path)) {
+                Log.e(TAG, "Could not record the Tango session to " + path);
+            }
+        }
+
         setContentView(R.layout.testshell_activity);
 
         mAwTestContainerView = createAwTestContainerView();
@@ -618,6 +626,7 @@ public class AwShellActivity extends Activity implements OnRequestPermissionsRes
             return;
         }
 
+        TangoJniNative.stopRecording();
         TangoJniNative.onDestroy();
 
         if (mDevToolsServer != null) {
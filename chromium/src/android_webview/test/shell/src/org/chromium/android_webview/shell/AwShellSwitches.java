@@ -12,6 +12,9 @@ public abstract class AwShellSwitches {
     // Enables Android systrace path for Chrome traces.
     public static final String ENABLE_ATRACE = "enable-atrace";
 
+    // Records the Tango session into the given file.
+    public static final String TANGO_SESSION_RECORDING_PATH = "tango-session-recording-path";
+
     // Prevent instantiation.
     private AwShellSwitches() {}
 }
@@ -28,6 +28,8 @@ import android.util.Log;
  */
 public class TangoJniNative {
 
+    private static boolean sInitialized;
+
     public static boolean initialize()
     {
         // This project depends on tango_client_api, so we need to make sure we load
@@ -38,9 +40,19 @@ public class TangoJniNative {
             return false;
         }
         System.loadLibrary("tango_chromium");
+        sInitialized = true;
         return true;
     }
 
+    /**
+     * Whether the native library is loaded, the native methods cannot be
+     * called before.
+     */
+    public static boolean isInitialized()
+    {
+        return sInitialized;
+    }
+
     /**
      * Check if the Tango Core version is compatible with this app.
      * If not, the application will exit.
@@ -64,4 +76,25 @@ public class TangoJniNative {
     public static native void onDestroy();
 
     public static native void onConfigurationChanged(int activityOrientation, int sensorOrientation);
+
+    /**
+     * Record the Tango session (poses, point clouds, camera frames and events)
+     * into a file that can be replayed later.
+     *
+     * @param path The path of the session file to create.
+     * @return Whether the recording could be started.
+     */
+    public static native boolean startRecording(String path);
+
+    public static native void stopRecording();
+
+    /**
+     * Draw the camera image beneath the web contents on the current GL
+     * context, if a page asked for the camera underlay lately.
+     *
+     * @param width The width of the viewport.
+     * @param height The height of the viewport.
+     * @return Whether the camera underlay was drawn.
+     */
+    public static native boolean drawCameraUnderlay(int width, int height);
 }
@@ -8,6 +8,7 @@ import android.content.Context;
 import android.content.Intent;
 import android.content.res.Configuration;
 import android.graphics.Canvas;
+import android.graphics.Color;
 import android.graphics.PixelFormat;
 import android.graphics.Rect;
 import android.opengl.GLSurfaceView;
@@ -23,6 +24,7 @@ import android.widget.FrameLayout;
 
 import org.chromium.android_webview.AwContents;
 import org.chromium.android_webview.shell.DrawGL;
+import org.chromium.android_webview.shell.TangoJniNative;
 import org.chromium.content.browser.ContentViewCore;
 
 import javax.microedition.khronos.egl.EGLConfig;
@@ -40,6 +42,12 @@ public class AwTestContainerView extends FrameLayout {
     private HardwareView mHardwareView;
     private boolean mAttachedContents;
 
+    // The background color of the web contents, white by default as in
+    // AwContents. It is replaced with a transparent one while the camera
+    // underlay is shown and restored afterwards. Only accessed on the UI thread.
+    private int mBackgroundColor = Color.WHITE;
+    private boolean mCameraUnderlayShown;
+
     private class HardwareView extends GLSurfaceView {
         private static final int MODE_DRAW = 0;
         private static final int MODE_PROCESS = 1;
@@ -69,6 +77,10 @@ public class AwTestContainerView extends FrameLayout {
         private long mDrawGL;
         private long mViewContext;
 
+        // Only used by drawGL on render thread. Whether the camera underlay was
+        // drawn beneath the web contents in the previous frame.
+        private boolean mCameraUnderlayDrawn;
+
         public HardwareView(Context context) {
             super(context);
             setEGLContextClientVersion(2); // GLES2
@@ -219,6 +231,7 @@ public class AwTestContainerView extends FrameLayout {
                 DrawGL.drawGL(mDrawGL, viewContext, width, height, 0, 0, MODE_PROCESS);
             }
             if (process || draw) {
+                drawCameraUnderlay(width, height);
                 DrawGL.drawGL(mDrawGL, viewContext, width, height, mCommittedScrollX,
                         mCommittedScrollY, MODE_DRAW);
             }
@@ -230,6 +243,22 @@ public class AwTestContainerView extends FrameLayout {
                 }
             }
         }
+
+        // Draws the latest camera image the page asked for, if any, right
+        // beneath the web contents. The web contents background is made
+        // transparent for as long as the underlay is drawn.
+        private void drawCameraUnderlay(int width, int height) {
+            if (!TangoJniNative.isInitialized()) return;
+            final boolean drawn = TangoJniNative.drawCameraUnderlay(width, height);
+            if (drawn == mCameraUnderlayDrawn) return;
+            mCameraUnderlayDrawn = drawn;
+            post(new Runnable() {
+                @Override
+                public void run() {
+                    setCameraUnderlayShown(drawn);
+                }
+            });
+        }
     }
 
     private static boolean sCreatedOnce;
@@ -260,6 +289,7 @@ public class AwTestContainerView extends FrameLayout {
 
     public void initialize(AwContents awContents) {
         mAwContents = awContents;
+        if (mBackgroundColor != Color.WHITE) mAwContents.setBackgroundColor(mBackgroundColor);
         if (isBackedByHardwareView()) {
             mHardwareView.initialize(AwContents.getAwDrawGLFunction());
         }
@@ -289,6 +319,21 @@ public class AwTestContainerView extends FrameLayout {
         mAwContents.destroy();
     }
 
+    /**
+     * Sets the background color of the web contents, like WebView does.
+     */
+    @Override
+    public void setBackgroundColor(int color) {
+        mBackgroundColor = color;
+        if (mAwContents != null && !mCameraUnderlayShown) mAwContents.setBackgroundColor(color);
+    }
+
+    private void setCameraUnderlayShown(boolean shown) {
+        mCameraUnderlayShown = shown;
+        if (mAwContents == null) return;
+        mAwContents.setBackgroundColor(shown ? Color.TRANSPARENT : mBackgroundColor);
+    }
+
     @Override
     public void onConfigurationChanged(Configuration newConfig) {
         super.onConfigurationChanged(newConfig);
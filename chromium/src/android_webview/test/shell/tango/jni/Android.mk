@@ -45,6 +45,8 @@ LOCAL_C_INCLUDES := \
 	../../../../../third_party/tango/libtango_client_api \
 	../../../../../third_party/tango/libtango_support_api
 LOCAL_SRC_FILES := TangoHandler.cpp \
+                   TangoCameraUnderlay.cpp \
+                   TangoSessionRecorder.cpp \
                    TangoHandlerJNIInterface.cpp
 LOCAL_CFLAGS := -std=gnu++11 -Werror -fexceptions
 LOCAL_SHARED_LIBRARIES := tango_client_api tango_support_api
@@ -0,0 +1,301 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TANGO_BACKEND_H_
+#define _TANGO_BACKEND_H_
+
+#include "tango_client_api.h"   // NOLINT
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+// The highest depth framerate the Tango devices support.
+#define TANGO_MAX_DEPTH_FRAMERATE 5
+
+namespace tango_chromium {
+
+// The sensor settings a page can choose with VRDisplay.configureSensors.
+struct TangoSensorConfiguration {
+	// Depth frames per second, 0 turns depth off.
+	int depthFramerate;
+	// 0 means as many points as the device supports.
+	unsigned maxNumberOfPointsInPointCloud;
+	// 0 x 0 means the native resolution of the color camera.
+	uint32_t cameraImageWidth;
+	uint32_t cameraImageHeight;
+};
+
+// The backend connects to the Tango service in the background so the startup
+// and the resume do not block the thread that requests them.
+enum TangoConnectionState {
+	TANGO_CONNECTION_STATE_DISCONNECTED,
+	TANGO_CONNECTION_STATE_CONNECTING,
+	TANGO_CONNECTION_STATE_CONNECTED,
+	TANGO_CONNECTION_STATE_FAILED
+};
+
+class ADF {
+public:
+	ADF(const std::string& uuid, const std::string& name, unsigned long long creationTime): uuid(uuid), name(name), creationTime(creationTime)
+	{
+	}
+
+	inline const std::string& getUUID() const
+	{
+		return uuid;
+	}
+
+	inline const std::string& getName() const
+	{
+		return name;
+	}
+
+	inline unsigned long long getCreationTime() const
+	{
+		return creationTime;
+	}
+private:
+	std::string uuid;
+	std::string name;
+	unsigned long long creationTime;
+};
+
+// Receives the data that is pushed by the backend instead of being polled.
+// The methods are called on the Tango callback threads.
+class TangoBackendListener {
+public:
+	virtual ~TangoBackendListener() {}
+
+	virtual void onPointCloudAvailable(double timestamp) = 0;
+	// A new color camera image can be retrieved with getPose. Not all the
+	// backends notify it.
+	virtual void onCameraFrameAvailable() = 0;
+	virtual void onTrackingStateChanged(bool tracking) = 0;
+	// The value returned by getCameraIntrinsicsGeneration changed.
+	virtual void onCameraIntrinsicsChanged() = 0;
+	// error is only set for TANGO_CONNECTION_STATE_FAILED.
+	virtual void onConnectionStateChanged(TangoConnectionState state, const std::string& error) = 0;
+};
+
+// TangoBackend is everything the browser (device/vr) and the GPU process
+// (the camera texture update) need from Tango. The Android build implements
+// it with TangoHandler on top of the Tango service. Other platforms use
+// TangoReplayBackend that serves a recorded session (see
+// TangoSessionRecorder).
+class TangoBackend {
+public:
+	// Returns the backend of the current build.
+	static TangoBackend* getInstance();
+
+	TangoBackend(): listener(0)
+	{
+		pthread_mutex_init(&listenerMutex, 0);
+	}
+
+	virtual ~TangoBackend()
+	{
+		pthread_mutex_destroy(&listenerMutex);
+	}
+
+	// Once this call returns the previous listener will not be called
+	// anymore. Pass 0 to remove the listener.
+	void setListener(TangoBackendListener* listener)
+	{
+		pthread_mutex_lock(&listenerMutex);
+		this->listener = listener;
+		pthread_mutex_unlock(&listenerMutex);
+	}
+
+	virtual bool isConnected() const = 0;
+	// The reason of the last failure is returned in error (if not 0) when the
+	// state is TANGO_CONNECTION_STATE_FAILED.
+	virtual TangoConnectionState getConnectionState(std::string* error) const = 0;
+
+	// Returns the pose that matches the latest camera frame. The id of that
+	// camera frame is returned in cameraFrameId (0 if the pose does not
+	// correspond to any camera frame).
+	virtual bool getPose(TangoPoseData* tangoPoseData, uint32_t* cameraFrameId) = 0;
+	// Returns the latest pose, which does not match any camera frame. It is
+	// used to render in between camera frames.
+	virtual bool getLatestPose(TangoPoseData* tangoPoseData) = 0;
+	// Returns the pose and the id of the latest camera frame handed out by
+	// getPose, or false if there is none. Unlike getPose it never locks nor
+	// consumes a camera frame, so it can be called from any thread (the GPU
+	// thread latches the pose with it) without taking frames away from the
+	// pose requests of the pages.
+	virtual bool getLatestCameraFramePose(TangoPoseData* tangoPoseData, uint32_t* cameraFrameId) = 0;
+
+	virtual unsigned getMaxNumberOfPointsInPointCloud() const = 0;
+	// Returns a number that changes with every new point cloud, or 0 if the
+	// backend cannot tell when the point cloud changes. It changes once the
+	// new point cloud can be retrieved, so a point cloud retrieved while it
+	// stays the same belongs to that generation.
+	virtual uint32_t getPointCloudGeneration() const = 0;
+	// The id of the camera frame the picking is calculated for.
+	virtual uint32_t getLatestCameraFrameId() const = 0;
+	// points has room for maxNumberOfPoints (x, y, z) points. The limit
+	// returned by getMaxNumberOfPointsInPointCloud can change in between
+	// (configureSensors), so the points are skipped to fit whichever is
+	// smaller.
+	virtual bool getPointCloud(uint32_t* numberOfPoints, float* points, unsigned maxNumberOfPoints, bool justUpdatePointCloud, unsigned pointsToSkip) = 0;
+	virtual bool getPickingPointAndPlaneInPointCloud(float x, float y, double* point, double* plane) = 0;
+
+	virtual bool getCameraImageSize(uint32_t* width, uint32_t* height) = 0;
+	virtual bool getCameraImageTextureSize(uint32_t* width, uint32_t* height) = 0;
+	virtual bool getCameraFocalLength(double* focalLengthX, double* focalLengthY) = 0;
+	virtual bool getCameraPoint(double* x, double* y) = 0;
+	// Returns a number that changes every time the camera intrinsics, the
+	// camera image size or the orientation change (connection, disconnection
+	// and device rotation). The listener is notified of every change.
+	virtual uint32_t getCameraIntrinsicsGeneration() const = 0;
+	// The color camera intrinsics with the current display rotation applied.
+	virtual bool getRotatedCameraIntrinsics(uint32_t* width, uint32_t* height, double* focalLengthX, double* focalLengthY, double* pointX, double* pointY) = 0;
+	// A width x height grid of (u, v) pairs. The entry at (i, j) is the
+	// normalized coordinate in the distorted camera image that corresponds to
+	// the normalized undistorted coordinate (i / (width - 1), j / (height - 1)).
+	virtual bool getCameraUndistortionLUT(uint32_t* width, uint32_t* height, std::vector<float>& lut) const = 0;
+	// Updates the texture with the camera frame identified by cameraFrameId.
+	// If the frame id is 0 or unknown, the oldest available frame is used.
+	virtual bool updateCameraImageIntoTexture(uint32_t textureId, uint32_t cameraFrameId) = 0;
+	// The camera underlay (see TangoCameraUnderlay). The pages set the camera
+	// frame of each of their frames from the GPU thread. The embedder calls
+	// drawCameraUnderlay on its own GL context before compositing the web
+	// contents: it draws the latest frame set over the whole viewport, or
+	// returns false without drawing anything while no page uses the underlay.
+	virtual void setCameraUnderlayFrameId(uint32_t cameraFrameId) = 0;
+	virtual bool drawCameraUnderlay(int width, int height) = 0;
+
+	virtual int getSensorOrientation() const = 0;
+	// The time, in seconds, the depth and the color camera streams have been
+	// enabled. The streams are only enabled while they are used (see
+	// TangoLazySensor) so pose only pages do not pay for them.
+	virtual void getSensorUsage(double* depthTime, double* cameraTime) const = 0;
+	// Turns off the streams that have not been used for
+	// TANGO_SENSOR_IDLE_TIMEOUT. Called regularly by the device, whether the
+	// pages request poses or not.
+	virtual void updateSensors() = 0;
+
+	virtual bool getADFs(std::vector<ADF>& adfs) const = 0;
+	virtual void enableADF(const std::string& uuid) = 0;
+	virtual void disableADF() = 0;
+
+	// Applies the configuration without reconnecting. Returns false with the
+	// reason in error if the configuration is not supported, in which case
+	// nothing changes.
+	virtual bool configureSensors(const TangoSensorConfiguration& configuration, std::string* error) = 0;
+
+protected:
+	// The checks all the backends share. maxNumberOfPointsInPointCloud and
+	// the camera image size are the limits of the device.
+	static bool validateSensorConfiguration(const TangoSensorConfiguration& configuration, unsigned maxNumberOfPointsInPointCloud,
+		uint32_t cameraImageWidth, uint32_t cameraImageHeight, std::string* error)
+	{
+		char message[256];
+		if (configuration.depthFramerate < 0 || configuration.depthFramerate > TANGO_MAX_DEPTH_FRAMERATE)
+		{
+			snprintf(message, sizeof(message), "depthFramerate must be between 0 and %d.", TANGO_MAX_DEPTH_FRAMERATE);
+			*error = message;
+			return false;
+		}
+		if (configuration.depthFramerate == 0 && configuration.maxNumberOfPointsInPointCloud > 0)
+		{
+			*error = "maxNumberOfPointsInPointCloud cannot be set when depth is turned off.";
+			return false;
+		}
+		if (configuration.maxNumberOfPointsInPointCloud > maxNumberOfPointsInPointCloud)
+		{
+			snprintf(message, sizeof(message), "maxNumberOfPointsInPointCloud cannot be greater than %u.", maxNumberOfPointsInPointCloud);
+			*error = message;
+			return false;
+		}
+		if ((configuration.cameraImageWidth == 0) != (configuration.cameraImageHeight == 0))
+		{
+			*error = "cameraImageWidth and cameraImageHeight must be either both set or both 0.";
+			return false;
+		}
+		// The resolution of the color camera is fixed by the Tango service.
+		if (configuration.cameraImageWidth != 0 &&
+			(configuration.cameraImageWidth != cameraImageWidth || configuration.cameraImageHeight != cameraImageHeight))
+		{
+			snprintf(message, sizeof(message), "The color camera only supports its native resolution (%ux%u).", cameraImageWidth, cameraImageHeight);
+			*error = message;
+			return false;
+		}
+		return true;
+	}
+
+	void notifyPointCloudAvailable(double timestamp)
+	{
+		pthread_mutex_lock(&listenerMutex);
+		if (listener != 0)
+		{
+			listener->onPointCloudAvailable(timestamp);
+		}
+		pthread_mutex_unlock(&listenerMutex);
+	}
+
+	void notifyCameraFrameAvailable()
+	{
+		pthread_mutex_lock(&listenerMutex);
+		if (listener != 0)
+		{
+			listener->onCameraFrameAvailable();
+		}
+		pthread_mutex_unlock(&listenerMutex);
+	}
+
+	void notifyTrackingStateChanged(bool tracking)
+	{
+		pthread_mutex_lock(&listenerMutex);
+		if (listener != 0)
+		{
+			listener->onTrackingStateChanged(tracking);
+		}
+		pthread_mutex_unlock(&listenerMutex);
+	}
+
+	void notifyCameraIntrinsicsChanged()
+	{
+		pthread_mutex_lock(&listenerMutex);
+		if (listener != 0)
+		{
+			listener->onCameraIntrinsicsChanged();
+		}
+		pthread_mutex_unlock(&listenerMutex);
+	}
+
+	void notifyConnectionStateChanged(TangoConnectionState state, const std::string& error)
+	{
+		pthread_mutex_lock(&listenerMutex);
+		if (listener != 0)
+		{
+			listener->onConnectionStateChanged(state, error);
+		}
+		pthread_mutex_unlock(&listenerMutex);
+	}
+
+private:
+	pthread_mutex_t listenerMutex;
+	TangoBackendListener* listener;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _TANGO_BACKEND_H_
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TangoCameraUnderlay.h"
+
+#include "TangoLog.h"
+
+// Inside Chromium the GL calls need to go through the GL bindings of the
+// current context.
+#ifdef TANGO_REPLAY_USE_CHROMIUM_GL
+#include "ui/gl/gl_bindings.h"
+#else
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#endif
+
+#include <string>
+
+namespace {
+
+// A full screen triangle strip.
+const GLfloat kPositions[] = {
+  -1.0f,  1.0f,
+  -1.0f, -1.0f,
+   1.0f,  1.0f,
+   1.0f, -1.0f
+};
+
+// The texture coordinates of kPositions for each of the 4 orientations, the
+// same as in THREE.WebAR.createVRSeeThroughCameraMesh. 1 stands for u or v.
+const GLfloat kTextureCoords[4][8] = {
+  { 0, 0,  0, 1,  1, 0,  1, 1 },
+  { 1, 0,  0, 0,  1, 1,  0, 1 },
+  { 1, 1,  1, 0,  0, 1,  0, 0 },
+  { 0, 1,  1, 1,  0, 0,  1, 0 }
+};
+
+const char* kVertexShaderSource =
+  "attribute vec2 position;\n"
+  "attribute vec2 textureCoord;\n"
+  "varying vec2 vTextureCoord;\n"
+  "void main() {\n"
+  "  gl_Position = vec4(position, 0.0, 1.0);\n"
+  "  vTextureCoord = textureCoord;\n"
+  "}\n";
+
+const char* kExternalFragmentShaderHeader =
+  "#extension GL_OES_EGL_image_external : require\n"
+  "precision mediump float;\n"
+  "uniform samplerExternalOES sampler;\n";
+
+const char* k2DFragmentShaderHeader =
+  "precision mediump float;\n"
+  "uniform sampler2D sampler;\n";
+
+const char* kFragmentShaderBody =
+  "varying vec2 vTextureCoord;\n"
+  "void main() {\n"
+  "  gl_FragColor = texture2D(sampler, vTextureCoord);\n"
+  "}\n";
+
+GLuint compileShader(GLenum type, const std::string& source)
+{
+  GLuint shader = glCreateShader(type);
+  const char* sourceChars = source.c_str();
+  glShaderSource(shader, 1, &sourceChars, nullptr);
+  glCompileShader(shader);
+  GLint compiled = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+  if (compiled != GL_TRUE)
+  {
+    char log[512];
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    LOGE("TangoCameraUnderlay: failed to compile a shader: %s", log);
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+} // namespace
+
+namespace tango_chromium {
+
+TangoCameraUnderlay::TangoCameraUnderlay(): cameraFrameId(0)
+  , usage(TANGO_CAMERA_UNDERLAY_IDLE_TIMEOUT)
+  , target(0)
+  , program(0)
+  , texture(0)
+  , positionAttribute(-1)
+  , textureCoordAttribute(-1)
+  , uploadedCameraFrameId(0)
+{
+}
+
+void TangoCameraUnderlay::setCameraFrameId(uint32_t cameraFrameId)
+{
+  this->cameraFrameId = cameraFrameId;
+  usage.use();
+}
+
+bool TangoCameraUnderlay::isInUse()
+{
+  usage.update();
+  return usage.isEnabled();
+}
+
+uint32_t TangoCameraUnderlay::getTexture(uint32_t target)
+{
+  // The embedder may have lost its context since the last draw.
+  if (program == 0 || this->target != target || !glIsProgram(program))
+  {
+    if (!createGLResources(target))
+    {
+      return 0;
+    }
+  }
+  return texture;
+}
+
+uint32_t TangoCameraUnderlay::getCameraFrameIdToUpload()
+{
+  uint32_t cameraFrameId = this->cameraFrameId;
+  if (cameraFrameId == uploadedCameraFrameId)
+  {
+    return 0;
+  }
+  uploadedCameraFrameId = cameraFrameId;
+  return cameraFrameId;
+}
+
+void TangoCameraUnderlay::draw(int width, int height, int activityOrientation, int sensorOrientation, float u, float v)
+{
+  GLfloat textureCoords[8];
+  int orientationIndex = (activityOrientation - sensorOrientation / 90 + 4) % 4;
+  const GLfloat* orientedTextureCoords = kTextureCoords[orientationIndex];
+  for (int i = 0; i < 8; i += 2)
+  {
+    textureCoords[i] = orientedTextureCoords[i] * u;
+    textureCoords[i + 1] = orientedTextureCoords[i + 1] * v;
+  }
+
+  glViewport(0, 0, width, height);
+  glDisable(GL_BLEND);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_SCISSOR_TEST);
+  glUseProgram(program);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(target, texture);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glEnableVertexAttribArray(positionAttribute);
+  glVertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, 0, kPositions);
+  glEnableVertexAttribArray(textureCoordAttribute);
+  glVertexAttribPointer(textureCoordAttribute, 2, GL_FLOAT, GL_FALSE, 0, textureCoords);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glDisableVertexAttribArray(positionAttribute);
+  glDisableVertexAttribArray(textureCoordAttribute);
+  glBindTexture(target, 0);
+  glUseProgram(0);
+}
+
+bool TangoCameraUnderlay::createGLResources(uint32_t target)
+{
+  // The objects of a lost context are gone with it, they are only forgotten.
+  this->target = target;
+  program = 0;
+  texture = 0;
+  uploadedCameraFrameId = 0;
+
+  GLuint vertexShader = compileShader(GL_VERTEX_SHADER, kVertexShaderSource);
+  GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER,
+    std::string(target == GL_TEXTURE_EXTERNAL_OES ? kExternalFragmentShaderHeader : k2DFragmentShaderHeader) + kFragmentShaderBody);
+  if (vertexShader == 0 || fragmentShader == 0)
+  {
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return false;
+  }
+  program = glCreateProgram();
+  glAttachShader(program, vertexShader);
+  glAttachShader(program, fragmentShader);
+  glLinkProgram(program);
+  glDeleteShader(vertexShader);
+  glDeleteShader(fragmentShader);
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (linked != GL_TRUE)
+  {
+    LOGE("TangoCameraUnderlay: failed to link the program.");
+    glDeleteProgram(program);
+    program = 0;
+    return false;
+  }
+  positionAttribute = glGetAttribLocation(program, "position");
+  textureCoordAttribute = glGetAttribLocation(program, "textureCoord");
+  glUseProgram(program);
+  glUniform1i(glGetUniformLocation(program, "sampler"), 0);
+  glUseProgram(0);
+
+  GLuint textureId;
+  glGenTextures(1, &textureId);
+  glBindTexture(target, textureId);
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(target, 0);
+  texture = textureId;
+  return true;
+}
+
+}  // namespace tango_chromium
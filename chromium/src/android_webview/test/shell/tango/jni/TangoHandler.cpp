@@ -14,15 +14,19 @@
  * limitations under the License.
  */
 
+#include <cstdarg>
 #include <cstdlib>
+#include <cstring>
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
 
 #include <cassert>
 
 #include <cmath>
+#include <algorithm>
 
 #include "TangoHandler.h"
 
@@ -37,6 +41,11 @@ void onPointCloudAvailable(void* context, const TangoPointCloud* pointCloud)
   tango_chromium::TangoHandler::getInstance()->onPointCloudAvailable(pointCloud);
 }
 
+void onPoseAvailable(void* context, const TangoPoseData* pose)
+{
+  tango_chromium::TangoHandler::getInstance()->onPoseAvailable(pose);
+}
+
 void onCameraFrameAvailable(void* context, TangoCameraId tangoCameraId, const TangoImageBuffer* buffer) 
 {
   tango_chromium::TangoHandler::getInstance()->onCameraFrameAvailable(buffer);
@@ -44,8 +53,24 @@ void onCameraFrameAvailable(void* context, TangoCameraId tangoCameraId, const Ta
 
 void onTextureAvailable(void* context, TangoCameraId tangoCameraId) 
 {
+  tango_chromium::TangoHandler::getInstance()->onTextureAvailable();
+}
+
+void* connectThreadMain(void* context)
+{
+  static_cast<tango_chromium::TangoHandler*>(context)->runConnectThread();
+  return 0;
+}
+
+#ifdef TANGO_USE_SESSION_RECORDING
+
+void onTangoEventAvailable(void* context, const TangoEvent* event) 
+{
+  tango_chromium::TangoHandler::getInstance()->onTangoEventAvailable(event);
 }
 
+#endif
+
 inline void multiplyMatrixWithVector(const float* m, const double* v, double* vr, bool addTranslation = true) {
   double v0 = v[0];
   double v1 = v[1];
@@ -237,6 +262,11 @@ namespace tango_chromium {
 
 TangoHandler* TangoHandler::instance = 0;
 
+TangoBackend* TangoBackend::getInstance()
+{
+  return TangoHandler::getInstance();
+}
+
 TangoHandler* TangoHandler::getInstance()
 {
   if (instance == 0)
@@ -252,29 +282,55 @@ void TangoHandler::releaseInstance()
   instance = 0;
 }
 
-TangoHandler::TangoHandler(): connected(false)
-  , tangoConfig(nullptr)
-  , lastTangoImageBufferTimestamp(0)
-  , latestTangoPointCloud(0)
-  , latestTangoPointCloudRetrieved(false)
-  , maxNumberOfPointsInPointCloud(0)
-  , pointCloudManager(0)
+TangoHandlerState::TangoHandlerState(): connectionState(TANGO_CONNECTION_STATE_DISCONNECTED)
+  , connected(false)
+  , activityOrientation(0)
+  , sensorOrientation(0)
   , cameraImageWidth(0)
   , cameraImageHeight(0)
   , cameraImageTextureWidth(0)
   , cameraImageTextureHeight(0)
+  , cameraIntrinsicsGeneration(0)
+{
+  memset(&cameraIntrinsics, 0, sizeof(cameraIntrinsics));
+  memset(&rotatedCameraIntrinsics, 0, sizeof(rotatedCameraIntrinsics));
+}
+
+TangoHandler::TangoHandler(): state(std::make_shared<TangoHandlerState>())
+  , connectThreadRunning(false)
+  , tracking(false)
+  , tangoConfig(nullptr)
+  , lastTangoImageBufferTimestamp(0)
+  , lastTangoImagebufferTimestampTime(0)
+  , maxNumberOfPointsInPointCloud(0)
+  , pointCloudManager(0)
+  , pointCloudGeneration(0)
   , textureIdConnected(false)
+  , nextCameraFrameId(1)
+  , underlayTangoBufferId(0)
+  , hasUnderlayTangoBuffer(false)
+  , depthFramerate(TANGO_DEPTH_FRAMERATE)
+  , maxNumberOfPointsInPointCloudLimit(0)
 {
     pthread_mutexattr_t attr;
     pthread_mutexattr_init( &attr );
     pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_ERRORCHECK );
-    pthread_mutex_init( &tangoBufferIdsMutex, &attr );
+    pthread_mutex_init( &tangoFramePairsMutex, &attr );
+    pthread_mutex_init( &connectionMutex, &attr );
+    pthread_mutex_init( &stateWriteMutex, &attr );
+    pthread_mutex_init( &pointCloudManagerMutex, &attr );
     pthread_mutexattr_destroy( &attr ); 
 }
 
 TangoHandler::~TangoHandler() 
 {
-    pthread_mutex_destroy( &tangoBufferIdsMutex );
+    pthread_mutex_lock( &connectionMutex );
+    joinConnectThread();
+    pthread_mutex_unlock( &connectionMutex );
+    pthread_mutex_destroy( &tangoFramePairsMutex );
+    pthread_mutex_destroy( &connectionMutex );
+    pthread_mutex_destroy( &stateWriteMutex );
+    pthread_mutex_destroy( &pointCloudManagerMutex );
 
 #ifdef TANGO_USE_POINT_CLOUD
 
@@ -305,47 +361,70 @@ void TangoHandler::onCreate(JNIEnv* env, jobject activity, int activityOrientati
     std::exit (EXIT_SUCCESS);
   }
 
-  this->activityOrientation = activityOrientation;
-  this->sensorOrientation = sensorOrientation;
+  std::shared_ptr<TangoHandlerState> newState = beginStateUpdate();
+  newState->activityOrientation = activityOrientation;
+  newState->sensorOrientation = sensorOrientation;
+  publishState(newState);
 }
 
 void TangoHandler::onTangoServiceConnected(JNIEnv* env, jobject binder) 
 {
   if (TangoService_setBinder(env, binder) != TANGO_SUCCESS) {
     LOGE("TangoHandler::onTangoServiceConnected, TangoService_setBinder error");
-    std::exit (EXIT_SUCCESS);
+    setConnectionState(TANGO_CONNECTION_STATE_FAILED, "TangoHandler::onTangoServiceConnected, TangoService_setBinder error.");
+    return;
   }
 
-  connect("");
+  // Connecting takes hundreds of milliseconds, do not block the UI thread.
+  pthread_mutex_lock( &connectionMutex );
+  connectAsync(lastEnabledADFUUID);
+  pthread_mutex_unlock( &connectionMutex );
 }
 
 
-void TangoHandler::connect(const std::string& uuid)
+bool TangoHandler::createConfig(const std::string& uuid, std::string* error)
 {
-  TangoErrorType result;
+  if (tangoConfig != nullptr)
+  {
+    TangoConfig_free(tangoConfig);
+  }
+  tangoConfigUUID = "";
 
   // TANGO_CONFIG_DEFAULT is enabling Motion Tracking and disabling Depth
   // Perception.
   tangoConfig = TangoService_getConfig(TANGO_CONFIG_DEFAULT);
   if (tangoConfig == nullptr) 
   {
-    LOGE("TangoHandler::onTangoServiceConnected, TangoService_getConfig error.");
-    std::exit (EXIT_SUCCESS);
+    return connectionFailed(error, "TangoHandler::createConfig, TangoService_getConfig error.");
+  }
+
+  if (!setUpConfig(uuid, error))
+  {
+    // A half configured configuration must not be reused by the next
+    // connection.
+    TangoConfig_free(tangoConfig);
+    tangoConfig = nullptr;
+    return false;
   }
+  tangoConfigUUID = uuid;
+  return true;
+}
+
+bool TangoHandler::setUpConfig(const std::string& uuid, std::string* error)
+{
+  TangoErrorType result;
 
   // Enable Depth Perception.
   result = TangoConfig_setBool(tangoConfig, "config_enable_depth", true);
   if (result != TANGO_SUCCESS) 
   {
-    LOGE("TangoHandler::onTangoServiceConnected, config_enable_depth activation failed with error code: %d.", result);
-    std::exit(EXIT_SUCCESS);
+    return connectionFailed(error, "TangoHandler::createConfig, config_enable_depth activation failed with error code: %d.", result);
   }
 
   // Setup depth perception
   if (TangoConfig_setInt32(tangoConfig, "config_depth_mode", TANGO_POINTCLOUD_XYZC) != TANGO_SUCCESS) 
   {
-    LOGE("TangoHandler::onTangoServiceConnected, TangoConfig_setInt32(\"config_depth_mode\", %d): Failed\n", 0);
-    std::exit(EXIT_SUCCESS);
+    return connectionFailed(error, "TangoHandler::createConfig, TangoConfig_setInt32(\"config_depth_mode\", %d): Failed\n", 0);
   }
 
   // Note that it is super important for AR applications that we enable low
@@ -354,8 +433,7 @@ void TangoHandler::connect(const std::string& uuid)
   // invalid poses when calling getPoseAtTime() for an image.
   result = TangoConfig_setBool(tangoConfig, "config_enable_low_latency_imu_integration", true);
   if (result != TANGO_SUCCESS) {
-    LOGE("TangoHandler::onTangoServiceConnected, failed to enable low latency imu integration.");
-    std::exit(EXIT_SUCCESS);
+    return connectionFailed(error, "TangoHandler::createConfig, failed to enable low latency imu integration.");
   }
 
 #ifdef TANGO_USE_DRIFT_CORRECTION
@@ -365,13 +443,48 @@ void TangoHandler::connect(const std::string& uuid)
   // base frame AREA_DESCRIPTION and target frame DEVICE.
   result = TangoConfig_setBool(tangoConfig, "config_enable_drift_correction", true);
   if (result != TANGO_SUCCESS) {
-    LOGE("TangoHandler::onTangoServiceConnected, enabling config_enable_drift_correction "
+    return connectionFailed(error, "TangoHandler::createConfig, enabling config_enable_drift_correction "
       "failed with error code: %d", result);
-    std::exit(EXIT_SUCCESS);
   }
 
 #endif  
 
+#ifdef TANGO_USE_CAMERA 
+
+  // Enable color camera from config.
+  result = TangoConfig_setBool(tangoConfig, "config_enable_color_camera", true);
+  if (result != TANGO_SUCCESS) {
+    return connectionFailed(error, "TangoHandler::createConfig, config_enable_color_camera() failed with error code: %d", result);
+  }
+
+#endif
+
+  // If there is a uuid, then activate it
+  if (uuid != "")
+  {
+    result = TangoConfig_setString(tangoConfig, "config_load_area_description_UUID", uuid.c_str());
+    if (result != TANGO_SUCCESS) 
+    {
+      LOGE("TangoHandler::createConfig: setup the UUID(%s) failed with error code: %d", uuid.c_str(), result);
+    }
+  }
+  return true;
+}
+
+bool TangoHandler::connect(const std::string& uuid, std::string* error)
+{
+  TangoErrorType result;
+
+  // The configuration is kept across pause and resume, it is only created
+  // again when the area description changes.
+  if (tangoConfig == nullptr || tangoConfigUUID != uuid)
+  {
+    if (!createConfig(uuid, error))
+    {
+      return false;
+    }
+  }
+
 #ifdef TANGO_USE_POINT_CLOUD
 
   if (pointCloudManager == 0)
@@ -380,24 +493,21 @@ void TangoHandler::connect(const std::string& uuid)
     result = TangoConfig_getInt32(tangoConfig, "max_point_cloud_elements", &maxPointCloudVertexCount_temp);
     if (result != TANGO_SUCCESS) 
     {
-      LOGE("TangoHandler::onTangoServiceConnected, Get max_point_cloud_elements failed");
-      std::exit(EXIT_SUCCESS);
+      return connectionFailed(error, "TangoHandler::connect, Get max_point_cloud_elements failed");
     }
     maxNumberOfPointsInPointCloud = static_cast<uint32_t>(maxPointCloudVertexCount_temp);
 
     result = TangoSupport_createPointCloudManager(maxNumberOfPointsInPointCloud, &pointCloudManager);
     if (result != TANGO_SUCCESS) 
     {
-      LOGE("TangoHandler::onTangoServiceConnected, TangoSupport_createPointCloudManager failed");
-      std::exit(EXIT_SUCCESS);
+      return connectionFailed(error, "TangoHandler::connect, TangoSupport_createPointCloudManager failed");
     }
 
   #ifdef TANGO_USE_POINT_CLOUD_CALLBACK
 
     result = TangoService_connectOnPointCloudAvailable(::onPointCloudAvailable);
     if (result != TANGO_SUCCESS) {
-      LOGE("TangoHandler::onTangoServiceConnected, Failed to connect to point cloud callback with error code: %d", result);
-      std::exit(EXIT_SUCCESS);
+      return connectionFailed(error, "TangoHandler::connect, Failed to connect to point cloud callback with error code: %d", result);
     }
 
   #endif
@@ -406,147 +516,416 @@ void TangoHandler::connect(const std::string& uuid)
 
 #endif
 
-#ifdef TANGO_USE_CAMERA 
-
-  // Enable color camera from config.
-  result = TangoConfig_setBool(tangoConfig, "config_enable_color_camera", true);
-  if (result != TANGO_SUCCESS) {
-    LOGE("TangoHandler::onTangoServiceConnected, config_enable_color_camera() failed with error code: %d", result);
-    std::exit(EXIT_SUCCESS);
+  // The poses are queried when needed, the callback is only used to notify
+  // the tracking state changes and to record the poses.
+  TangoCoordinateFramePair trackingFramePair;
+  trackingFramePair.base = TANGO_COORDINATE_FRAME;
+  trackingFramePair.target = TANGO_COORDINATE_FRAME_DEVICE;
+  result = TangoService_connectOnPoseAvailable(1, &trackingFramePair, ::onPoseAvailable);
+  if (result != TANGO_SUCCESS) 
+  {
+    LOGE("TangoHandler::connect, failed to connect the pose callback with error code: %d", result);
   }
 
+#ifdef TANGO_USE_CAMERA 
+
   result = TangoService_connectOnTextureAvailable(TANGO_CAMERA_COLOR, this, ::onTextureAvailable);
   if (result != TANGO_SUCCESS) 
   {
-    LOGE("TangoHandler::connect, failed to connect texture callback with error code: %d", result);
-    std::exit(EXIT_SUCCESS);
+    return connectionFailed(error, "TangoHandler::connect, failed to connect texture callback with error code: %d", result);
+  }
+
+#ifdef TANGO_USE_SESSION_RECORDING
+
+  // The pixels of the camera frames are only needed to record them.
+  if (sessionRecorder.isRecording())
+  {
+    result = TangoService_connectOnFrameAvailable(TANGO_CAMERA_COLOR, this, ::onCameraFrameAvailable);
+    if (result != TANGO_SUCCESS) 
+    {
+      LOGE("TangoHandler::connect, failed to connect the camera frame callback for the session recording with error code: %d", result);
+    }
   }
 
 #endif
 
-  // If there is a uuid, then activate it
-  if (uuid != "")
+#endif
+
+#ifdef TANGO_USE_SESSION_RECORDING
+
+  if (sessionRecorder.isRecording())
   {
-    result = TangoConfig_setString(tangoConfig, "config_load_area_description_UUID", uuid.c_str());
+    result = TangoService_connectOnTangoEvent(::onTangoEventAvailable);
     if (result != TANGO_SUCCESS) 
     {
-      LOGE("TangoHandler::connect: setup the UUID(%s) failed with error code: %d", uuid.c_str(), result);
+      LOGE("TangoHandler::connect, failed to connect the Tango event callback for the session recording with error code: %d", result);
     }
   }
-  lastEnabledADFUUID = uuid;
+
+#endif
 
   // Connect the tango service.
   if (TangoService_connect(this, tangoConfig) != TANGO_SUCCESS) 
   {
-    LOGE("TangoHandler::connect, TangoService_connect error.");
-    std::exit (EXIT_SUCCESS);
+    return connectionFailed(error, "TangoHandler::connect, TangoService_connect error.");
   }
 
   // Get the intrinsics for the color camera and pass them on to the depth
   // image. We need these to know how to project the point cloud into the color
   // camera frame.
-  result = TangoService_getCameraIntrinsics(TANGO_CAMERA_COLOR, &tangoCameraIntrinsics);
+  TangoCameraIntrinsics connectedTangoCameraIntrinsics;
+  result = TangoService_getCameraIntrinsics(TANGO_CAMERA_COLOR, &connectedTangoCameraIntrinsics);
   if (result != TANGO_SUCCESS) {
-    LOGE("TangoHandler::connect: Failed to get the intrinsics for the color camera.");
-    std::exit(EXIT_SUCCESS);
+    TangoService_disconnect();
+    return connectionFailed(error, "TangoHandler::connect: Failed to get the intrinsics for the color camera.");
   }
 
-  // By default, use the camera width and height retrieved from the tango camera intrinsics.
-  cameraImageWidth = cameraImageTextureWidth = tangoCameraIntrinsics.width;
-  cameraImageHeight = cameraImageTextureHeight = tangoCameraIntrinsics.height;
-
   // Initialize TangoSupport context.
   // TangoSupport_initialize(TangoService_getPoseAtTime);
   TangoSupport_initializeLibrary();
 
-  connected = true;
+  // Depth has to be enabled in the configuration to be able to turn it on at
+  // runtime, but it stays off until the first getPointCloud.
+  depthSensor.reset();
+  cameraSensor.reset();
+  setDepthFramerate(0);
+
+  std::shared_ptr<TangoHandlerState> newState = beginStateUpdate();
+
+  // The intrinsics do not change when resuming, so the undistortion lookup
+  // table calculated on the previous connection is still valid.
+  bool cameraIntrinsicsChanged = !newState->cameraUndistortionLUT ||
+    std::memcmp(&connectedTangoCameraIntrinsics, &newState->cameraIntrinsics, sizeof(TangoCameraIntrinsics)) != 0;
+  newState->cameraIntrinsics = connectedTangoCameraIntrinsics;
+
+  // By default, use the camera width and height retrieved from the tango camera intrinsics.
+  newState->cameraImageWidth = newState->cameraImageTextureWidth = connectedTangoCameraIntrinsics.width;
+  newState->cameraImageHeight = newState->cameraImageTextureHeight = connectedTangoCameraIntrinsics.height;
+
+  updateRotatedCameraIntrinsics(*newState);
+  if (cameraIntrinsicsChanged)
+  {
+    newState->cameraUndistortionLUT = calculateCameraUndistortionLUT(connectedTangoCameraIntrinsics);
+  }
+
+#ifdef TANGO_USE_SESSION_RECORDING
+  // Timestamp 0 marks the values that apply from the connection on.
+  sessionRecorder.recordCameraIntrinsics(0.0, connectedTangoCameraIntrinsics);
+  sessionRecorder.recordDisplayRotation(0.0, newState->activityOrientation, newState->sensorOrientation);
+#endif
+
+  newState->connected = true;
+  newState->areaDescriptionUUID = uuid;
+  newState->cameraIntrinsicsGeneration++;
+  publishState(newState);
+  notifyCameraIntrinsicsChanged();
+  return true;
+}
+
+bool TangoHandler::connectionFailed(std::string* error, const char* format, ...)
+{
+  char message[512];
+  va_list arguments;
+  va_start(arguments, format);
+  vsnprintf(message, sizeof(message), format, arguments);
+  va_end(arguments);
+  LOGE("%s", message);
+  *error = message;
+  return false;
+}
+
+void TangoHandler::connectAsync(const std::string& uuid)
+{
+  // Only one connection at a time. The connection thread does not take
+  // connectionMutex so it can be joined with the mutex held.
+  if (isConnected() || connectThreadRunning)
+  {
+    disconnect();
+  }
+
+  lastEnabledADFUUID = uuid;
+  connectUUID = uuid;
+  setConnectionState(TANGO_CONNECTION_STATE_CONNECTING, "");
+  if (pthread_create(&connectThread, 0, ::connectThreadMain, this) != 0)
+  {
+    setConnectionState(TANGO_CONNECTION_STATE_FAILED, "TangoHandler::connectAsync, could not create the connection thread.");
+    return;
+  }
+  connectThreadRunning = true;
+}
+
+void TangoHandler::runConnectThread()
+{
+  std::string error;
+  if (connect(connectUUID, &error))
+  {
+    setConnectionState(TANGO_CONNECTION_STATE_CONNECTED, "");
+  }
+  else
+  {
+    setConnectionState(TANGO_CONNECTION_STATE_FAILED, error);
+  }
+}
+
+void TangoHandler::joinConnectThread()
+{
+  if (connectThreadRunning)
+  {
+    pthread_join(connectThread, 0);
+    connectThreadRunning = false;
+  }
+}
+
+void TangoHandler::setConnectionState(TangoConnectionState state, const std::string& error)
+{
+  std::shared_ptr<TangoHandlerState> newState = beginStateUpdate();
+  newState->connectionState = state;
+  newState->connectionError = error;
+  publishState(newState);
+  notifyConnectionStateChanged(state, error);
+}
+
+TangoConnectionState TangoHandler::getConnectionState(std::string* error) const
+{
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  if (error != 0)
+  {
+    *error = currentState->connectionError;
+  }
+  return currentState->connectionState;
 }
 
 void TangoHandler::disconnect() 
 {
+  joinConnectThread();
   TangoService_disconnect();
 
-  cameraImageWidth = cameraImageHeight = 
-    cameraImageTextureWidth = cameraImageTextureHeight = 0;
+  // The locked camera buffers are not valid anymore after disconnecting. The
+  // state is published with the queue locked so a pose request never locks a
+  // buffer for a disconnected service.
+  // The undistortion lookup table is kept for the next connection, it is not
+  // served while disconnected.
+  pthread_mutex_lock( &tangoFramePairsMutex );
+  tangoFramePairs.clear();
+  hasUnderlayTangoBuffer = false;
+  std::shared_ptr<TangoHandlerState> newState = beginStateUpdate();
+  newState->cameraImageWidth = newState->cameraImageHeight = 
+    newState->cameraImageTextureWidth = newState->cameraImageTextureHeight = 0;
+  newState->connected = false;
+  newState->cameraIntrinsicsGeneration++;
+  newState->latestFramePair.reset();
+  publishState(newState);
+  pthread_mutex_unlock( &tangoFramePairsMutex );
+  notifyCameraIntrinsicsChanged();
 
   textureIdConnected = false;
 
-  connected = false;
+  depthSensor.reset();
+  cameraSensor.reset();
+  LOGI("TangoHandler::disconnect, depth enabled for %lf seconds, camera enabled for %lf seconds.",
+    depthSensor.getEnabledTime(), cameraSensor.getEnabledTime());
+
+  // The pose callback may still be running, only the one that changes the
+  // state notifies it.
+  if (tracking.exchange(false))
+  {
+    notifyTrackingStateChanged(false);
+  }
+
+  setConnectionState(TANGO_CONNECTION_STATE_DISCONNECTED, "");
 }
 
 void TangoHandler::onPause() 
 {
+  pthread_mutex_lock( &connectionMutex );
   disconnect();
+  pthread_mutex_unlock( &connectionMutex );
 }
 
 void TangoHandler::onDeviceRotationChanged(int activityOrientation, int sensorOrientation)
 {
-  this->activityOrientation = activityOrientation;
-  this->sensorOrientation = sensorOrientation;
+  std::shared_ptr<TangoHandlerState> newState = beginStateUpdate();
+  newState->activityOrientation = activityOrientation;
+  newState->sensorOrientation = sensorOrientation;
+  if (newState->connected)
+  {
+    updateRotatedCameraIntrinsics(*newState);
+  }
+  newState->cameraIntrinsicsGeneration++;
+  publishState(newState);
+  notifyCameraIntrinsicsChanged();
+
+#ifdef TANGO_USE_SESSION_RECORDING
+  // The rotation applies from the latest camera frame on.
+  sessionRecorder.recordDisplayRotation(lastTangoImageBufferTimestamp, activityOrientation, sensorOrientation);
+#endif
 }
 
 bool TangoHandler::isConnected() const
 {
-  return connected;
+  return getState()->connected;
 }
 
-bool TangoHandler::getPose(TangoPoseData* tangoPoseData) 
+std::shared_ptr<const TangoHandlerState> TangoHandler::getState() const
 {
-  bool result = connected;
-  if (connected)
+  return std::atomic_load(&state);
+}
+
+std::shared_ptr<TangoHandlerState> TangoHandler::beginStateUpdate()
+{
+  pthread_mutex_lock( &stateWriteMutex );
+  return std::make_shared<TangoHandlerState>(*getState());
+}
+
+void TangoHandler::publishState(const std::shared_ptr<TangoHandlerState>& newState)
+{
+  std::atomic_store(&state, std::shared_ptr<const TangoHandlerState>(newState));
+  pthread_mutex_unlock( &stateWriteMutex );
+}
+
+bool TangoHandler::getPose(TangoPoseData* tangoPoseData, uint32_t* cameraFrameId) 
+{
+  *cameraFrameId = 0;
+
+  // The same snapshot is used for the whole pose calculation.
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  if (!currentState->connected)
   {
-    bool lockNewTangoBufferId;
-    pthread_mutex_lock( &tangoBufferIdsMutex );
-    lockNewTangoBufferId = tangoBufferIds.size() < MAX_NUMBER_OF_TANGO_BUFFER_IDS;
-    pthread_mutex_unlock( &tangoBufferIdsMutex );
+    return false;
+  }
+
+  // Pages that do not show the camera only need the latest pose.
+  if (!cameraSensor.isEnabled())
+  {
+    return getPoseAtTime(0, *currentState, tangoPoseData);
+  }
 
-    TangoBufferId tangoBufferId;
-    if (lockNewTangoBufferId)
+  std::shared_ptr<const TangoFramePair> framePair;
+  pthread_mutex_lock( &tangoFramePairsMutex );
+  if (tangoFramePairs.size() < MAX_NUMBER_OF_TANGO_FRAME_PAIRS)
+  {
+    framePair = lockFramePair();
+    if (!framePair)
     {
-      result = TangoService_lockCameraBuffer(TANGO_CAMERA_COLOR, &lastTangoImageBufferTimestamp, &tangoBufferId) == TANGO_SUCCESS;
+      pthread_mutex_unlock( &tangoFramePairsMutex );
+      return false;
     }
-  
-    if (result)
-    {
-      if (lockNewTangoBufferId)
-      {
-        pthread_mutex_lock( &tangoBufferIdsMutex );
-        tangoBufferIds.push(tangoBufferId);
-        pthread_mutex_unlock( &tangoBufferIdsMutex );
-      }
+  }
+  else
+  {
+    framePair = getState()->latestFramePair;
+  }
+  pthread_mutex_unlock( &tangoFramePairsMutex );
 
-      double timestamp = hasLastTangoImageBufferTimestampChangedLately() ? lastTangoImageBufferTimestamp : 0;
+  // If the camera image has not been used lately, there is no point in
+  // returning the pose of an old camera frame. Return the latest pose
+  // instead that does not match any camera frame.
+  if (!framePair || !hasLastTangoImageBufferTimestampChangedLately())
+  {
+    return getPoseAtTime(0, *currentState, tangoPoseData);
+  }
 
-      if (lastEnabledADFUUID != "")
-      {
-        result = TangoSupport_getPoseAtTime(
-          timestamp, TANGO_COORDINATE_FRAME_AREA_DESCRIPTION,
-          TANGO_COORDINATE_FRAME_CAMERA_COLOR, TANGO_SUPPORT_ENGINE_OPENGL,
-          TANGO_SUPPORT_ENGINE_OPENGL, 
-          static_cast<TangoSupportRotation>(activityOrientation), tangoPoseData) == TANGO_SUCCESS;
-        if (!result) 
-        {
-          LOGE("TangoHandler::getPose: Failed to get the pose for area description.");
-        }
-        else if (tangoPoseData->status_code != TANGO_POSE_VALID) 
-        {
-          LOGE("TangoHandler::getPose: Getting the Area Description pose did not work. Falling back to device pose estimation.");
-        }
-      }
+  *tangoPoseData = framePair->pose;
+  *cameraFrameId = framePair->frameId;
 
-      if (lastEnabledADFUUID == "" || tangoPoseData->status_code != TANGO_POSE_VALID)
-      {
-        result = TangoSupport_getPoseAtTime(
-          timestamp, TANGO_COORDINATE_FRAME,
-          TANGO_COORDINATE_FRAME_CAMERA_COLOR, TANGO_SUPPORT_ENGINE_OPENGL, 
-          TANGO_SUPPORT_ENGINE_OPENGL, static_cast<TangoSupportRotation>(activityOrientation), tangoPoseData) == TANGO_SUCCESS;
-        if (!result) 
-        {
-          LOGE("TangoHandler::getPose: Failed to get the pose.");
-        }
-      }
+  return true;
+}
+
+std::shared_ptr<const TangoFramePair> TangoHandler::lockFramePair()
+{
+  // The state is read again under the queue lock, disconnect publishes the
+  // disconnection with it held.
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  if (!currentState->connected)
+  {
+    return std::shared_ptr<const TangoFramePair>();
+  }
+
+  std::shared_ptr<TangoFramePair> framePair = std::make_shared<TangoFramePair>();
+  if (TangoService_lockCameraBuffer(TANGO_CAMERA_COLOR, &framePair->timestamp, &framePair->bufferId) != TANGO_SUCCESS)
+  {
+    return std::shared_ptr<const TangoFramePair>();
+  }
+  lastTangoImageBufferTimestamp = framePair->timestamp;
+
+  // The pose is calculated only once, at the exact timestamp of the locked
+  // camera buffer. Any other request for this camera frame will be served
+  // from the frame pair.
+  if (!getPoseAtTime(framePair->timestamp, *currentState, &framePair->pose))
+  {
+    TangoService_unlockCameraBuffer(TANGO_CAMERA_COLOR, framePair->bufferId);
+    return std::shared_ptr<const TangoFramePair>();
+  }
+  framePair->frameId = nextCameraFrameId++;
+  // 0 means "no camera frame" so skip it when the ids wrap around.
+  if (nextCameraFrameId == 0)
+  {
+    nextCameraFrameId = 1;
+  }
+
+  tangoFramePairs.push_back(*framePair);
+  std::shared_ptr<TangoHandlerState> newState = beginStateUpdate();
+  newState->latestFramePair = framePair;
+  publishState(newState);
+  return framePair;
+}
+
+bool TangoHandler::getLatestPose(TangoPoseData* tangoPoseData)
+{
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  if (!currentState->connected)
+  {
+    return false;
+  }
+  return getPoseAtTime(0, *currentState, tangoPoseData);
+}
+
+bool TangoHandler::getLatestCameraFramePose(TangoPoseData* tangoPoseData, uint32_t* cameraFrameId)
+{
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  if (!currentState->connected || !currentState->latestFramePair)
+  {
+    return false;
+  }
+  *tangoPoseData = currentState->latestFramePair->pose;
+  *cameraFrameId = currentState->latestFramePair->frameId;
+  return true;
+}
+
+bool TangoHandler::getPoseAtTime(double timestamp, const TangoHandlerState& state, TangoPoseData* tangoPoseData)
+{
+  bool result = false;
+  int activityOrientation = state.activityOrientation;
+
+  if (!state.areaDescriptionUUID.empty())
+  {
+    result = TangoSupport_getPoseAtTime(
+      timestamp, TANGO_COORDINATE_FRAME_AREA_DESCRIPTION,
+      TANGO_COORDINATE_FRAME_CAMERA_COLOR, TANGO_SUPPORT_ENGINE_OPENGL,
+      TANGO_SUPPORT_ENGINE_OPENGL, 
+      static_cast<TangoSupportRotation>(activityOrientation), tangoPoseData) == TANGO_SUCCESS;
+    if (!result) 
+    {
+      LOGE("TangoHandler::getPoseAtTime: Failed to get the pose for area description.");
+    }
+    else if (tangoPoseData->status_code != TANGO_POSE_VALID) 
+    {
+      LOGE("TangoHandler::getPoseAtTime: Getting the Area Description pose did not work. Falling back to device pose estimation.");
+    }
+  }
+
+  if (state.areaDescriptionUUID.empty() || !result || tangoPoseData->status_code != TANGO_POSE_VALID)
+  {
+    result = TangoSupport_getPoseAtTime(
+      timestamp, TANGO_COORDINATE_FRAME,
+      TANGO_COORDINATE_FRAME_CAMERA_COLOR, TANGO_SUPPORT_ENGINE_OPENGL, 
+      TANGO_SUPPORT_ENGINE_OPENGL, static_cast<TangoSupportRotation>(activityOrientation), tangoPoseData) == TANGO_SUCCESS;
+    if (!result) 
+    {
+      LOGE("TangoHandler::getPoseAtTime: Failed to get the pose.");
     }
   }
+
   return result;
 }
 
@@ -554,7 +933,8 @@ bool TangoHandler::getPoseMatrix(float* matrix)
 {
   bool result = false;
 
-  double timestamp = hasLastTangoImageBufferTimestampChangedLately() ? lastTangoImageBufferTimestamp : 0.0;
+  double timestamp = hasLastTangoImageBufferTimestampChangedLately() ? lastTangoImageBufferTimestamp.load() : 0.0;
+  int activityOrientation = getState()->activityOrientation;
 
   TangoMatrixTransformData tangoMatrixTransformData;
   TangoSupport_getMatrixTransformAtTime(
@@ -572,38 +952,78 @@ bool TangoHandler::getPoseMatrix(float* matrix)
 
 unsigned TangoHandler::getMaxNumberOfPointsInPointCloud() const
 {
-  return maxNumberOfPointsInPointCloud;
+  unsigned limit = maxNumberOfPointsInPointCloudLimit;
+  return limit != 0 ? std::min(limit, maxNumberOfPointsInPointCloud) : maxNumberOfPointsInPointCloud;
 }
 
-bool TangoHandler::getPointCloud(uint32_t* numberOfPoints, float* points, bool justUpdatePointCloud, unsigned pointsToSkip)
+uint32_t TangoHandler::getPointCloudGeneration() const
+{
+#ifdef TANGO_USE_POINT_CLOUD_CALLBACK
+  return pointCloudGeneration;
+#else
+  return 0;
+#endif
+}
+
+uint32_t TangoHandler::getLatestCameraFrameId() const
+{
+  std::shared_ptr<const TangoFramePair> framePair = getState()->latestFramePair;
+  return framePair ? framePair->frameId : 0;
+}
+
+bool TangoHandler::getPointCloud(uint32_t* numberOfPoints, float* points, unsigned maxNumberOfPoints, bool justUpdatePointCloud, unsigned pointsToSkip)
 {
   // In case the point cloud retrieval fails, 0 points should be returned.
   *numberOfPoints = 0;
 
   pointsToSkip += 1;
 
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  bool connected = currentState->connected;
+
+  int framerate = depthFramerate;
+  if (connected && framerate > 0 && depthSensor.use())
+  {
+    // The first point clouds take a while to arrive after depth is enabled.
+    setDepthFramerate(framerate);
+  }
+
   if (connected)
   {
+    pthread_mutex_lock( &pointCloudManagerMutex );
+    TangoPointCloud* latestTangoPointCloud = 0;
     TangoErrorType result = TangoSupport_getLatestPointCloud(pointCloudManager, &latestTangoPointCloud);
     if (result == TANGO_SUCCESS)
     {
-      latestTangoPointCloudRetrieved = true;
-
       // If only the update was requested, return with 0 points.
       if (justUpdatePointCloud) 
       {
+        pthread_mutex_unlock( &pointCloudManagerMutex );
         return true;
       }
 
+      // Skip as many points as needed to stay within the configured limit
+      // and the room in points.
+      unsigned limit = std::min(getMaxNumberOfPointsInPointCloud(), maxNumberOfPoints);
+      if (limit == 0)
+      {
+        pthread_mutex_unlock( &pointCloudManagerMutex );
+        return true;
+      }
+      if (latestTangoPointCloud->num_points > limit * pointsToSkip)
+      {
+        pointsToSkip = (latestTangoPointCloud->num_points + limit - 1) / limit;
+      }
+
       // It is possible that the transform matrix retrieval fails but the count is already there/correct.
       // TODO: Soon, the transformation of the points should be done in a shader in the application side, so the matrix retrieval could inside this method will be avoided.
-      *numberOfPoints = std::ceil(latestTangoPointCloud->num_points / pointsToSkip);
+      *numberOfPoints = (latestTangoPointCloud->num_points + pointsToSkip - 1) / pointsToSkip;
 
       TangoMatrixTransformData depthCameraMatrixTransform;
       TangoSupport_getMatrixTransformAtTime(
         latestTangoPointCloud->timestamp, TANGO_COORDINATE_FRAME,
         TANGO_COORDINATE_FRAME_CAMERA_DEPTH, TANGO_SUPPORT_ENGINE_OPENGL,
-        TANGO_SUPPORT_ENGINE_TANGO, static_cast<TangoSupportRotation>(activityOrientation), &depthCameraMatrixTransform);
+        TANGO_SUPPORT_ENGINE_TANGO, static_cast<TangoSupportRotation>(currentState->activityOrientation), &depthCameraMatrixTransform);
       if (depthCameraMatrixTransform.status_code == TANGO_POSE_VALID) 
       {
         TangoPointCloud tangoPointCloud;
@@ -642,6 +1062,7 @@ bool TangoHandler::getPointCloud(uint32_t* numberOfPoints, float* points, bool j
     {
       LOGE("TangoHandler::getPointCloud, retrieving the latest point cloud failed.");
     }
+    pthread_mutex_unlock( &pointCloudManagerMutex );
   }
 
   return connected;
@@ -651,36 +1072,55 @@ bool TangoHandler::getPickingPointAndPlaneInPointCloud(float x, float y, double*
 {
   bool result = false;
 
-  if (connected)
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  bool connected = currentState->connected;
+  int activityOrientation = currentState->activityOrientation;
+
+  // The picking needs the point cloud too.
+  int framerate = depthFramerate;
+  if (connected && framerate > 0 && depthSensor.use())
   {
-  
-    double timestamp = hasLastTangoImageBufferTimestampChangedLately() ? lastTangoImageBufferTimestamp : 0.0;
+    setDepthFramerate(framerate);
+  }
 
-    TangoPoseData tangoPose;
-    if (TangoSupport_calculateRelativePose(
-      latestTangoPointCloud->timestamp, 
-      TANGO_COORDINATE_FRAME_CAMERA_DEPTH,
-      timestamp,
-      TANGO_COORDINATE_FRAME_CAMERA_COLOR,
-      &tangoPose) != TANGO_SUCCESS) 
-    {
-      LOGE("%s: could not calculate relative pose", __func__);
-      return result;
-    }
-    float uv[] = {x, y};
-    double identity_translation[3] = {0.0, 0.0, 0.0};
-    double identity_orientation[4] = {0.0, 0.0, 0.0, 1.0};
-    if (TangoSupport_fitPlaneModelNearPoint(
-      latestTangoPointCloud, identity_translation, identity_orientation,
-      uv, static_cast<TangoSupportRotation>(activityOrientation),
-      tangoPose.translation,
-      tangoPose.orientation,
-      point, plane) != TANGO_SUCCESS)
-    {
-      LOGE("%s: could not calculate picking point and plane", __func__);
-      return result;
-    }
-    TangoMatrixTransformData tangoDepthCameraTranformMatrix;
+  if (!connected)
+  {
+    return result;
+  }
+
+  double timestamp = hasLastTangoImageBufferTimestampChangedLately() ? lastTangoImageBufferTimestamp.load() : 0.0;
+
+  pthread_mutex_lock( &pointCloudManagerMutex );
+  TangoPointCloud* latestTangoPointCloud = 0;
+  TangoPoseData tangoPose;
+  float uv[] = {x, y};
+  double identity_translation[3] = {0.0, 0.0, 0.0};
+  double identity_orientation[4] = {0.0, 0.0, 0.0, 1.0};
+  TangoMatrixTransformData tangoDepthCameraTranformMatrix;
+  if (TangoSupport_getLatestPointCloud(pointCloudManager, &latestTangoPointCloud) != TANGO_SUCCESS)
+  {
+    LOGE("%s: could not retrieve the latest point cloud", __func__);
+  }
+  else if (TangoSupport_calculateRelativePose(
+    latestTangoPointCloud->timestamp, 
+    TANGO_COORDINATE_FRAME_CAMERA_DEPTH,
+    timestamp,
+    TANGO_COORDINATE_FRAME_CAMERA_COLOR,
+    &tangoPose) != TANGO_SUCCESS) 
+  {
+    LOGE("%s: could not calculate relative pose", __func__);
+  }
+  else if (TangoSupport_fitPlaneModelNearPoint(
+    latestTangoPointCloud, identity_translation, identity_orientation,
+    uv, static_cast<TangoSupportRotation>(activityOrientation),
+    tangoPose.translation,
+    tangoPose.orientation,
+    point, plane) != TANGO_SUCCESS)
+  {
+    LOGE("%s: could not calculate picking point and plane", __func__);
+  }
+  else
+  {
     TangoSupport_getMatrixTransformAtTime(
       latestTangoPointCloud->timestamp, TANGO_COORDINATE_FRAME,
       TANGO_COORDINATE_FRAME_CAMERA_DEPTH, TANGO_SUPPORT_ENGINE_OPENGL,
@@ -688,16 +1128,19 @@ bool TangoHandler::getPickingPointAndPlaneInPointCloud(float x, float y, double*
     if (tangoDepthCameraTranformMatrix.status_code != TANGO_POSE_VALID) {
       LOGE("TangoHandler::getPickingPointAndPlaneInPointCloud: Could not find a valid matrix transform at "
       "time %lf for the depth camera.", latestTangoPointCloud->timestamp);
-      return result;
     }
-    multiplyMatrixWithVector(tangoDepthCameraTranformMatrix.matrix, point, point);
+    else
+    {
+      multiplyMatrixWithVector(tangoDepthCameraTranformMatrix.matrix, point, point);
 
-  //  LOGI("Before: %f, %f, %f, %f", plane[0], plane[1], plane[2], plane[3]);
-    transformPlane(plane, tangoDepthCameraTranformMatrix.matrix, plane);
-  //  LOGI("After: %f, %f, %f, %f", plane[0], plane[1], plane[2], plane[3]);
+    //  LOGI("Before: %f, %f, %f, %f", plane[0], plane[1], plane[2], plane[3]);
+      transformPlane(plane, tangoDepthCameraTranformMatrix.matrix, plane);
+    //  LOGI("After: %f, %f, %f, %f", plane[0], plane[1], plane[2], plane[3]);
 
-    result = true;
+      result = true;
+    }
   }
+  pthread_mutex_unlock( &pointCloudManagerMutex );
 
   return result;
 }
@@ -706,8 +1149,9 @@ bool TangoHandler::getCameraImageSize(uint32_t* width, uint32_t* height)
 {
   bool result = true;
 
-  *width = cameraImageWidth;
-  *height = cameraImageHeight;    
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  *width = currentState->cameraImageWidth;
+  *height = currentState->cameraImageHeight;    
 
   return result;
 }
@@ -716,8 +1160,9 @@ bool TangoHandler::getCameraImageTextureSize(uint32_t* width, uint32_t* height)
 {
   bool result = true;
 
-  *width = cameraImageTextureWidth;
-  *height = cameraImageTextureHeight;
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  *width = currentState->cameraImageTextureWidth;
+  *height = currentState->cameraImageTextureHeight;
 
   return result;
 }
@@ -725,23 +1170,107 @@ bool TangoHandler::getCameraImageTextureSize(uint32_t* width, uint32_t* height)
 bool TangoHandler::getCameraFocalLength(double* focalLengthX, double* focalLengthY)
 {
   bool result = true;
-  *focalLengthX = tangoCameraIntrinsics.fx;
-  *focalLengthY = tangoCameraIntrinsics.fy;
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  *focalLengthX = currentState->cameraIntrinsics.fx;
+  *focalLengthY = currentState->cameraIntrinsics.fy;
   return result;
 }
 
 bool TangoHandler::getCameraPoint(double* x, double* y)
 {
   bool result = true;
-  *x = tangoCameraIntrinsics.cx;
-  *y = tangoCameraIntrinsics.cy;
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  *x = currentState->cameraIntrinsics.cx;
+  *y = currentState->cameraIntrinsics.cy;
   return result;
 }
 
 
-bool TangoHandler::updateCameraImageIntoTexture(uint32_t textureId)
+uint32_t TangoHandler::getCameraIntrinsicsGeneration() const
+{
+  return getState()->cameraIntrinsicsGeneration;
+}
+
+bool TangoHandler::getRotatedCameraIntrinsics(uint32_t* width, uint32_t* height, double* focalLengthX, double* focalLengthY, double* pointX, double* pointY)
+{
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  if (!currentState->connected) return false;
+  const TangoCameraIntrinsics& rotatedCameraIntrinsics = currentState->rotatedCameraIntrinsics;
+  *width = rotatedCameraIntrinsics.width;
+  *height = rotatedCameraIntrinsics.height;
+  *focalLengthX = rotatedCameraIntrinsics.fx;
+  *focalLengthY = rotatedCameraIntrinsics.fy;
+  *pointX = rotatedCameraIntrinsics.cx;
+  *pointY = rotatedCameraIntrinsics.cy;
+  return true;
+}
+
+bool TangoHandler::getCameraUndistortionLUT(uint32_t* width, uint32_t* height, std::vector<float>& lut) const
+{
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  if (!currentState->connected || !currentState->cameraUndistortionLUT) return false;
+  *width = CAMERA_UNDISTORTION_LUT_WIDTH;
+  *height = CAMERA_UNDISTORTION_LUT_HEIGHT;
+  lut = *currentState->cameraUndistortionLUT;
+  return true;
+}
+
+void TangoHandler::updateRotatedCameraIntrinsics(TangoHandlerState& state)
+{
+  TangoErrorType result = TangoSupport_getCameraIntrinsicsBasedOnDisplayRotation(
+    TANGO_CAMERA_COLOR, static_cast<TangoSupportRotation>(state.activityOrientation), 
+    &state.rotatedCameraIntrinsics);
+  if (result != TANGO_SUCCESS)
+  {
+    LOGE("TangoHandler::updateRotatedCameraIntrinsics: Failed to get the rotated intrinsics for the color camera with error code: %d. Using the unrotated intrinsics.", result);
+    state.rotatedCameraIntrinsics = state.cameraIntrinsics;
+  }
+}
+
+std::shared_ptr<const std::vector<float> > TangoHandler::calculateCameraUndistortionLUT(const TangoCameraIntrinsics& tangoCameraIntrinsics)
+{
+  std::shared_ptr<std::vector<float> > cameraUndistortionLUT = std::make_shared<std::vector<float> >(
+    CAMERA_UNDISTORTION_LUT_WIDTH * CAMERA_UNDISTORTION_LUT_HEIGHT * 2);
+  float width = tangoCameraIntrinsics.width;
+  float height = tangoCameraIntrinsics.height;
+  float cameraPoint[3];
+  float pixel[2];
+  int isDistortedPixelInImage;
+  cameraPoint[2] = 1.0f;
+  float* lut = &((*cameraUndistortionLUT)[0]);
+  for (uint32_t j = 0; j < CAMERA_UNDISTORTION_LUT_HEIGHT; j++)
+  {
+    float v = j / (CAMERA_UNDISTORTION_LUT_HEIGHT - 1.0f);
+    for (uint32_t i = 0; i < CAMERA_UNDISTORTION_LUT_WIDTH; i++, lut += 2)
+    {
+      float u = i / (CAMERA_UNDISTORTION_LUT_WIDTH - 1.0f);
+      // Unproject the undistorted pixel using the pinhole model and project
+      // it back applying the camera distortion.
+      cameraPoint[0] = (u * width - tangoCameraIntrinsics.cx) / tangoCameraIntrinsics.fx;
+      cameraPoint[1] = (v * height - tangoCameraIntrinsics.cy) / tangoCameraIntrinsics.fy;
+      if (TangoSupport_projectCameraPointToDistortedPixel(TANGO_CAMERA_COLOR, 
+        cameraPoint, pixel, &isDistortedPixelInImage) == TANGO_SUCCESS)
+      {
+        lut[0] = pixel[0] / width;
+        lut[1] = pixel[1] / height;
+      }
+      else
+      {
+        lut[0] = u;
+        lut[1] = v;
+      }
+    }
+  }
+  return cameraUndistortionLUT;
+}
+
+bool TangoHandler::updateCameraImageIntoTexture(uint32_t textureId, uint32_t cameraFrameId)
 {
-  if (!connected) return false;
+  if (!isConnected()) return false;
+
+  // The camera buffers are locked with the poses from now on. This frame
+  // still shows the latest image.
+  cameraSensor.use();
 
   if (!textureIdConnected)
   {
@@ -754,51 +1283,232 @@ bool TangoHandler::updateCameraImageIntoTexture(uint32_t textureId)
     textureIdConnected = true;
   }
 
+  pthread_mutex_lock( &tangoFramePairsMutex );
   TangoBufferId tangoBufferId;
-  pthread_mutex_lock( &tangoBufferIdsMutex );
+  std::vector<TangoBufferId> skippedTangoBufferIds;
+  bool hasFramePair = takeFramePair(cameraFrameId, &tangoBufferId, &skippedTangoBufferIds);
+  pthread_mutex_unlock( &tangoFramePairsMutex );
 
-  if (tangoBufferIds.empty()) 
+  for (size_t i = 0; i < skippedTangoBufferIds.size(); i++)
   {
-      pthread_mutex_unlock( &tangoBufferIdsMutex );
+    TangoService_unlockCameraBuffer(TANGO_CAMERA_COLOR, skippedTangoBufferIds[i]);
+  }
 
+  if (!hasFramePair)
+  {
       // TODO: It makes some sense to add this call but it completely breaks
       // in the ASUS (Pistachio) device. 
       TangoErrorType result = TANGO_SUCCESS;
       // If there were no buffer ids locked, just update the texture.
       // TangoErrorType result = TangoService_updateTextureExternalOes(TANGO_CAMERA_COLOR, textureId, &lastTangoImageBufferTimestamp);
-      std::time(&lastTangoImagebufferTimestampTime);  
+      lastTangoImagebufferTimestampTime = std::time(0);
       return result == TANGO_SUCCESS;
   }
 
-  // Unlock the oldest locked buffer.
-  tangoBufferId = tangoBufferIds.front();
-  tangoBufferIds.pop();
-
-  pthread_mutex_unlock( &tangoBufferIdsMutex );
-
-  // LOGI("TangoHandler::updateCameraImageIntoTexture: TangoBufferId removed. Number of TangoBufferIds remaining = %d", tangoBufferIds.size());
-
   TangoErrorType result = TangoService_updateTextureExternalOesForBuffer(
     TANGO_CAMERA_COLOR, textureId, tangoBufferId);
   TangoService_unlockCameraBuffer(TANGO_CAMERA_COLOR, tangoBufferId);
 
-  std::time(&lastTangoImagebufferTimestampTime);  
+  lastTangoImagebufferTimestampTime = std::time(0);
 
   return result == TANGO_SUCCESS;
 }
 
+bool TangoHandler::takeFramePair(uint32_t cameraFrameId, TangoBufferId* tangoBufferId, std::vector<TangoBufferId>* skippedTangoBufferIds)
+{
+  if (tangoFramePairs.empty()) return false;
+
+  // Look for the frame pair that was handed out with the pose. If it cannot
+  // be found, use the oldest locked one. The frame pairs older than the
+  // resolved one will never be rendered so they are released too.
+  std::deque<TangoFramePair>::iterator it = tangoFramePairs.begin();
+  if (cameraFrameId != 0)
+  {
+    while (it != tangoFramePairs.end() && it->frameId != cameraFrameId)
+    {
+      ++it;
+    }
+    if (it == tangoFramePairs.end())
+    {
+      it = tangoFramePairs.begin();
+    }
+  }
+  for (std::deque<TangoFramePair>::iterator skipped = tangoFramePairs.begin(); skipped != it; ++skipped)
+  {
+    skippedTangoBufferIds->push_back(skipped->bufferId);
+  }
+  *tangoBufferId = it->bufferId;
+  tangoFramePairs.erase(tangoFramePairs.begin(), it + 1);
+  return true;
+}
+
+void TangoHandler::setCameraUnderlayFrameId(uint32_t cameraFrameId)
+{
+  cameraUnderlay.setCameraFrameId(cameraFrameId);
+  if (!isConnected()) return;
+
+  // The camera buffers are locked with the poses while the underlay is used,
+  // the same as for a camera texture.
+  cameraSensor.use();
+
+  // The frame pair is taken out of the queue here, on the GPU thread, like
+  // the camera textures do. The embedder thread only uploads the buffer it is
+  // handed, so the queue keeps a single consumer.
+  std::vector<TangoBufferId> unlockedTangoBufferIds;
+  pthread_mutex_lock( &tangoFramePairsMutex );
+  TangoBufferId tangoBufferId;
+  if (takeFramePair(cameraFrameId, &tangoBufferId, &unlockedTangoBufferIds))
+  {
+    // A buffer that the embedder has not drawn yet is replaced by the newer
+    // one.
+    if (hasUnderlayTangoBuffer)
+    {
+      unlockedTangoBufferIds.push_back(underlayTangoBufferId);
+    }
+    underlayTangoBufferId = tangoBufferId;
+    hasUnderlayTangoBuffer = true;
+  }
+  pthread_mutex_unlock( &tangoFramePairsMutex );
+
+  for (size_t i = 0; i < unlockedTangoBufferIds.size(); i++)
+  {
+    TangoService_unlockCameraBuffer(TANGO_CAMERA_COLOR, unlockedTangoBufferIds[i]);
+  }
+  lastTangoImagebufferTimestampTime = std::time(0);
+}
+
+bool TangoHandler::drawCameraUnderlay(int width, int height)
+{
+  if (!cameraUnderlay.isInUse()) return false;
+
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  if (!currentState->connected || currentState->cameraImageTextureWidth == 0) return false;
+
+  uint32_t textureId = cameraUnderlay.getTexture(GL_TEXTURE_EXTERNAL_OES);
+  if (textureId == 0) return false;
+  pthread_mutex_lock( &tangoFramePairsMutex );
+  TangoBufferId tangoBufferId = underlayTangoBufferId;
+  bool hasTangoBuffer = hasUnderlayTangoBuffer;
+  hasUnderlayTangoBuffer = false;
+  pthread_mutex_unlock( &tangoFramePairsMutex );
+  // Without a new buffer, the texture still holds the latest one.
+  if (hasTangoBuffer)
+  {
+    TangoService_updateTextureExternalOesForBuffer(TANGO_CAMERA_COLOR, textureId, tangoBufferId);
+    TangoService_unlockCameraBuffer(TANGO_CAMERA_COLOR, tangoBufferId);
+  }
+  cameraUnderlay.draw(width, height, currentState->activityOrientation, currentState->sensorOrientation,
+    static_cast<float>(currentState->cameraImageWidth) / currentState->cameraImageTextureWidth,
+    static_cast<float>(currentState->cameraImageHeight) / currentState->cameraImageTextureHeight);
+  return true;
+}
+
 #ifdef TANGO_USE_POINT_CLOUD_CALLBACK
 
 void TangoHandler::onPointCloudAvailable(const TangoPointCloud* pointCloud)
 {
   TangoSupport_updatePointCloud(pointCloudManager, pointCloud);
+  // 0 means "unknown generation" so skip it when wrapping around.
+  if (++pointCloudGeneration == 0)
+  {
+    ++pointCloudGeneration;
+  }
+
+#ifdef TANGO_USE_SESSION_RECORDING
+  if (sessionRecorder.isRecording())
+  {
+    // Record the same transform getPointCloud uses so the replay does not
+    // need the Tango support library.
+    TangoMatrixTransformData depthCameraMatrixTransform;
+    TangoSupport_getMatrixTransformAtTime(
+      pointCloud->timestamp, TANGO_COORDINATE_FRAME,
+      TANGO_COORDINATE_FRAME_CAMERA_DEPTH, TANGO_SUPPORT_ENGINE_OPENGL,
+      TANGO_SUPPORT_ENGINE_TANGO, static_cast<TangoSupportRotation>(getState()->activityOrientation), &depthCameraMatrixTransform);
+    if (depthCameraMatrixTransform.status_code != TANGO_POSE_VALID)
+    {
+      float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+      memcpy(depthCameraMatrixTransform.matrix, identity, sizeof(identity));
+    }
+    sessionRecorder.recordPointCloud(*pointCloud, depthCameraMatrixTransform.matrix);
+  }
+#endif
+
+  notifyPointCloudAvailable(pointCloud->timestamp);
+}
+
+#endif
+
+void TangoHandler::onPoseAvailable(const TangoPoseData* pose)
+{
+  bool isTracking = pose->status_code == TANGO_POSE_VALID;
+  if (tracking.exchange(isTracking) != isTracking)
+  {
+    notifyTrackingStateChanged(isTracking);
+  }
+
+#ifdef TANGO_USE_SESSION_RECORDING
+  // Every pose the service produces is recorded, not only the ones the page
+  // happens to query, as the pose served to the pages (see
+  // TangoSessionPose).
+  if (sessionRecorder.isRecording())
+  {
+    TangoPoseData servedPose;
+    if (getPoseAtTime(pose->timestamp, *getState(), &servedPose))
+    {
+      sessionRecorder.recordPose(servedPose);
+    }
+  }
+#endif
+}
+
+void TangoHandler::onCameraFrameAvailable(const TangoImageBuffer* buffer)
+{
+#ifdef TANGO_USE_SESSION_RECORDING
+  sessionRecorder.recordCameraFrame(*buffer);
+#endif
+}
+
+void TangoHandler::onTextureAvailable()
+{
+  // Lets the pages that render at the camera rate know there is a new frame
+  // to lock with the next pose.
+  notifyCameraFrameAvailable();
+}
+
+#ifdef TANGO_USE_SESSION_RECORDING
+
+bool TangoHandler::startRecording(const std::string& path)
+{
+  if (!sessionRecorder.start(path, TANGO_SESSION_RECORDING_MAX_QUEUED_BYTES, TANGO_SESSION_RECORDING_CAMERA_FRAME_DOWNSCALE))
+  {
+    return false;
+  }
+  // The camera frame and event callbacks are connected along with the
+  // service.
+  pthread_mutex_lock( &connectionMutex );
+  if (isConnected() || connectThreadRunning)
+  {
+    connectAsync(lastEnabledADFUUID);
+  }
+  pthread_mutex_unlock( &connectionMutex );
+  return true;
+}
+
+void TangoHandler::stopRecording()
+{
+  sessionRecorder.stop();
+}
+
+void TangoHandler::onTangoEventAvailable(const TangoEvent* event)
+{
+  sessionRecorder.recordEvent(event->timestamp, event->event_key, event->event_value);
 }
 
 #endif
 
 int TangoHandler::getSensorOrientation() const
 {
-  return sensorOrientation;
+  return getState()->sensorOrientation;
 }
 
 bool TangoHandler::getADFs(std::vector<ADF>& adfs) const
@@ -848,25 +1558,127 @@ bool TangoHandler::getADFs(std::vector<ADF>& adfs) const
 
 void TangoHandler::enableADF(const std::string& uuid)
 {
+  pthread_mutex_lock( &connectionMutex );
   if (lastEnabledADFUUID != uuid)
   {
-    if (connected)
-    {
-      disconnect();
-    }
-    connect(uuid);
+#ifdef TANGO_USE_SESSION_RECORDING
+    sessionRecorder.recordEvent(0.0, "ADFEnabled", uuid);
+#endif
+    connectAsync(uuid);
   }
+  pthread_mutex_unlock( &connectionMutex );
 }
 
 void TangoHandler::disableADF()
 {
+  pthread_mutex_lock( &connectionMutex );
   if (lastEnabledADFUUID != "")
   {
-    if (connected)
+#ifdef TANGO_USE_SESSION_RECORDING
+    sessionRecorder.recordEvent(0.0, "ADFDisabled", lastEnabledADFUUID);
+#endif
+    connectAsync("");
+  }
+  pthread_mutex_unlock( &connectionMutex );
+}
+
+bool TangoHandler::configureSensors(const TangoSensorConfiguration& configuration, std::string* error)
+{
+  std::shared_ptr<const TangoHandlerState> currentState = getState();
+  if (!currentState->connected)
+  {
+    *error = "The Tango service is not connected.";
+    return false;
+  }
+  if (!validateSensorConfiguration(configuration, maxNumberOfPointsInPointCloud,
+    currentState->cameraIntrinsics.width, currentState->cameraIntrinsics.height, error))
+  {
+    return false;
+  }
+
+  maxNumberOfPointsInPointCloudLimit = configuration.maxNumberOfPointsInPointCloud;
+  depthFramerate = configuration.depthFramerate;
+  // The new framerate is applied right away if depth is in use, otherwise
+  // with the next point cloud request.
+  if (depthSensor.isEnabled())
+  {
+    setDepthFramerate(configuration.depthFramerate);
+    if (configuration.depthFramerate == 0)
     {
-      disconnect();
+      depthSensor.reset();
     }
-    connect("");
+  }
+  return true;
+}
+
+void TangoHandler::getSensorUsage(double* depthTime, double* cameraTime) const
+{
+  *depthTime = depthSensor.getEnabledTime();
+  *cameraTime = cameraSensor.getEnabledTime();
+}
+
+void TangoHandler::updateSensors()
+{
+  // Skipped while the service is being connected or disconnected, the
+  // streams are reset by the connection anyway.
+  if (pthread_mutex_trylock( &connectionMutex ) != 0)
+  {
+    return;
+  }
+  if (isConnected())
+  {
+    if (depthSensor.update())
+    {
+      setDepthFramerate(0);
+    }
+    // The color camera stays on, only its buffers are released.
+    if (cameraSensor.update())
+    {
+      unlockCameraBuffers();
+    }
+  }
+  pthread_mutex_unlock( &connectionMutex );
+}
+
+void TangoHandler::setDepthFramerate(int framerate)
+{
+  TangoConfig runtimeConfig = TangoService_getConfig(TANGO_CONFIG_RUNTIME);
+  if (runtimeConfig == nullptr)
+  {
+    LOGE("TangoHandler::setDepthFramerate, TangoService_getConfig error.");
+    return;
+  }
+  TangoErrorType result = TangoConfig_setInt32(runtimeConfig, "config_runtime_depth_framerate", framerate);
+  if (result == TANGO_SUCCESS)
+  {
+    result = TangoService_setRuntimeConfig(runtimeConfig);
+  }
+  if (result != TANGO_SUCCESS)
+  {
+    LOGE("TangoHandler::setDepthFramerate, setting the depth framerate to %d failed with error code: %d", framerate, result);
+  }
+  TangoConfig_free(runtimeConfig);
+}
+
+void TangoHandler::unlockCameraBuffers()
+{
+  pthread_mutex_lock( &tangoFramePairsMutex );
+  std::deque<TangoFramePair> lockedTangoFramePairs;
+  lockedTangoFramePairs.swap(tangoFramePairs);
+  bool hasTangoBuffer = hasUnderlayTangoBuffer;
+  hasUnderlayTangoBuffer = false;
+  std::shared_ptr<TangoHandlerState> newState = beginStateUpdate();
+  newState->latestFramePair.reset();
+  publishState(newState);
+  pthread_mutex_unlock( &tangoFramePairsMutex );
+
+  for (size_t i = 0; i < lockedTangoFramePairs.size(); i++)
+  {
+    TangoService_unlockCameraBuffer(TANGO_CAMERA_COLOR, lockedTangoFramePairs[i].bufferId);
+  }
+  if (hasTangoBuffer)
+  {
+    TangoService_unlockCameraBuffer(TANGO_CAMERA_COLOR, underlayTangoBufferId);
   }
 }
 
@@ -874,7 +1686,7 @@ bool TangoHandler::hasLastTangoImageBufferTimestampChangedLately()
 {
   std::time_t currentTime;
   std::time(&currentTime);
-  return std::difftime(currentTime, lastTangoImagebufferTimestampTime) < 1.0;
+  return std::difftime(currentTime, lastTangoImagebufferTimestampTime.load()) < 1.0;
 }
 
 }  // namespace tango_chromium
@@ -54,6 +54,27 @@ Java_org_chromium_android_1webview_shell_TangoJniNative_onConfigurationChanged(J
 	TangoHandler::getInstance()->onDeviceRotationChanged(activityOrientation, sensorOrientation);
 }
 
+JNIEXPORT jboolean JNICALL
+Java_org_chromium_android_1webview_shell_TangoJniNative_startRecording(JNIEnv* env, jobject, jstring path) 
+{
+	const char* pathChars = env->GetStringUTFChars(path, nullptr);
+	bool result = TangoHandler::getInstance()->startRecording(pathChars);
+	env->ReleaseStringUTFChars(path, pathChars);
+	return result;
+}
+
+JNIEXPORT void JNICALL
+Java_org_chromium_android_1webview_shell_TangoJniNative_stopRecording(JNIEnv*, jobject) 
+{
+	TangoHandler::getInstance()->stopRecording();
+}
+
+JNIEXPORT jboolean JNICALL
+Java_org_chromium_android_1webview_shell_TangoJniNative_drawCameraUnderlay(JNIEnv*, jobject, jint width, jint height) 
+{
+	return TangoHandler::getInstance()->drawCameraUnderlay(width, height);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,732 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TangoReplayBackend.h"
+
+#include "TangoLog.h"
+
+// Inside Chromium the GL calls need to go through the GL bindings of the
+// current context.
+#ifdef TANGO_REPLAY_USE_CHROMIUM_GL
+#include "ui/gl/gl_bindings.h"
+#else
+#include <GLES2/gl2.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// The radius (in normalized image coordinates) around the picking position
+// that is used to gather the points to fit the plane to.
+constexpr float kPickingRadius = 0.05f;
+constexpr size_t kMinimumNumberOfPointsToFitAPlane = 3;
+
+inline void multiplyMatrixWithVector(const float* m, const double* v, double* vr, bool addTranslation = true)
+{
+  double v0 = v[0];
+  double v1 = v[1];
+  double v2 = v[2];
+  vr[0] = m[ 0] * v0 + m[ 4] * v1 + m[ 8] * v2 + (addTranslation ? m[12] : 0);
+  vr[1] = m[ 1] * v0 + m[ 5] * v1 + m[ 9] * v2 + (addTranslation ? m[13] : 0);
+  vr[2] = m[ 2] * v0 + m[ 6] * v1 + m[10] * v2 + (addTranslation ? m[14] : 0);
+}
+
+// Transforms a plane (normal, distance) with a rigid transform matrix.
+inline void transformPlane(const double* p, const float* m, double* pr)
+{
+  double pointInPlane[3] = { p[0] * -p[3], p[1] * -p[3], p[2] * -p[3] };
+  double normal[3];
+  multiplyMatrixWithVector(m, pointInPlane, pointInPlane);
+  multiplyMatrixWithVector(m, p, normal, false);
+  pr[0] = normal[0];
+  pr[1] = normal[1];
+  pr[2] = normal[2];
+  pr[3] = -(normal[0] * pointInPlane[0] + normal[1] * pointInPlane[1] + normal[2] * pointInPlane[2]);
+}
+
+// Least squares plane fit (see "Fitting a plane to many points in 3D" by
+// Emil Ernerfeldt): the normal is calculated solving the system for the axis
+// with the largest determinant.
+bool fitPlane(const std::vector<double>& points, const double* centroid, double* plane)
+{
+  double xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+  for (size_t i = 0; i < points.size(); i += 3)
+  {
+    double x = points[i] - centroid[0];
+    double y = points[i + 1] - centroid[1];
+    double z = points[i + 2] - centroid[2];
+    xx += x * x; xy += x * y; xz += x * z;
+    yy += y * y; yz += y * z; zz += z * z;
+  }
+  double detX = yy * zz - yz * yz;
+  double detY = xx * zz - xz * xz;
+  double detZ = xx * yy - xy * xy;
+  double detMax = std::max(detX, std::max(detY, detZ));
+  if (detMax <= 0.0)
+  {
+    return false;
+  }
+  double normal[3];
+  if (detMax == detX)
+  {
+    normal[0] = detX;
+    normal[1] = xz * yz - xy * zz;
+    normal[2] = xy * yz - xz * yy;
+  }
+  else if (detMax == detY)
+  {
+    normal[0] = xz * yz - xy * zz;
+    normal[1] = detY;
+    normal[2] = xy * xz - yz * xx;
+  }
+  else
+  {
+    normal[0] = xy * yz - xz * yy;
+    normal[1] = xy * xz - yz * xx;
+    normal[2] = detZ;
+  }
+  double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+  // Make the normal face the camera (that is at the origin).
+  if (normal[0] * centroid[0] + normal[1] * centroid[1] + normal[2] * centroid[2] > 0)
+  {
+    length = -length;
+  }
+  plane[0] = normal[0] / length;
+  plane[1] = normal[1] / length;
+  plane[2] = normal[2] / length;
+  plane[3] = -(plane[0] * centroid[0] + plane[1] * centroid[1] + plane[2] * centroid[2]);
+  return true;
+}
+
+double secondsBetween(const struct timespec& start, const struct timespec& end)
+{
+  return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+}  // namespace
+
+namespace tango_chromium {
+
+// The Android build uses the Tango service through TangoHandler, everywhere
+// else the session replay is used.
+#ifndef __ANDROID__
+TangoBackend* TangoBackend::getInstance()
+{
+  return TangoReplayBackend::getInstance();
+}
+#endif
+
+TangoReplayBackend* TangoReplayBackend::getInstance()
+{
+  // The initialization of a function local static is thread safe, the other
+  // callers wait for it to return.
+  static TangoReplayBackend* instance = createInstance();
+  return instance;
+}
+
+TangoReplayBackend* TangoReplayBackend::createInstance()
+{
+  TangoReplayBackend* instance = new TangoReplayBackend();
+  const char* path = std::getenv(TANGO_SESSION_REPLAY_PATH_VARIABLE);
+  const char* rate = std::getenv(TANGO_SESSION_REPLAY_RATE_VARIABLE);
+  if (path != nullptr)
+  {
+    instance->open(path, rate != nullptr ? std::atof(rate) : 1.0);
+  }
+  else
+  {
+    LOGI("TangoReplayBackend::getInstance, %s is not set, no session is replayed.", TANGO_SESSION_REPLAY_PATH_VARIABLE);
+  }
+  return instance;
+}
+
+TangoReplayBackend::TangoReplayBackend(double sensorIdleTimeout): rate(1.0)
+  , activityOrientation(0)
+  , sensorOrientation(0)
+  , cameraImageTextureWidth(0)
+  , cameraImageTextureHeight(0)
+  , maxNumberOfPointsInPointCloud(0)
+  , cameraIntrinsicsGeneration(0)
+  , lastUploadedTextureId(0)
+  , lastUploadedCameraFrameId(0)
+  , depthSensor(sensorIdleTimeout)
+  , cameraSensor(sensorIdleTimeout)
+  , depthFramerate(TANGO_MAX_DEPTH_FRAMERATE)
+  , maxNumberOfPointsInPointCloudLimit(0)
+{
+  std::memset(&cameraIntrinsics, 0, sizeof(cameraIntrinsics));
+  std::memset(&startTime, 0, sizeof(startTime));
+}
+
+TangoReplayBackend::~TangoReplayBackend()
+{
+  close();
+}
+
+bool TangoReplayBackend::open(const std::string& path, double rate)
+{
+  close();
+  if (!reader.open(path))
+  {
+    return false;
+  }
+  this->rate = rate > 0.0 ? rate : 1.0;
+  clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+  // The intrinsics and the display rotation do not change during a session
+  // (the replay does not rotate) so the first ones are used.
+  const TangoSessionRecordHeader* record = reader.getRecord(TANGO_SESSION_RECORD_CAMERA_INTRINSICS, 0);
+  if (record != nullptr)
+  {
+    cameraIntrinsics = *TangoSessionReader::getPayload<TangoSessionCameraIntrinsics>(record);
+  }
+  record = reader.getRecord(TANGO_SESSION_RECORD_DISPLAY_ROTATION, 0);
+  if (record != nullptr)
+  {
+    const TangoSessionDisplayRotation* displayRotation = TangoSessionReader::getPayload<TangoSessionDisplayRotation>(record);
+    activityOrientation = displayRotation->activityOrientation;
+    sensorOrientation = displayRotation->sensorOrientation;
+  }
+  record = reader.getRecord(TANGO_SESSION_RECORD_CAMERA_FRAME, 0);
+  if (record != nullptr)
+  {
+    const TangoSessionCameraFrame* cameraFrame = TangoSessionReader::getPayload<TangoSessionCameraFrame>(record);
+    cameraImageTextureWidth = cameraFrame->width;
+    cameraImageTextureHeight = cameraFrame->height;
+  }
+  for (size_t i = 0; i < reader.getNumberOfRecords(TANGO_SESSION_RECORD_POINT_CLOUD); i++)
+  {
+    const TangoSessionPointCloud* pointCloud = TangoSessionReader::getPayload<TangoSessionPointCloud>(
+      reader.getRecord(TANGO_SESSION_RECORD_POINT_CLOUD, i));
+    maxNumberOfPointsInPointCloud = std::max(maxNumberOfPointsInPointCloud, pointCloud->numberOfPoints);
+  }
+  cameraIntrinsicsGeneration++;
+  lastUploadedCameraFrameId = 0;
+
+  LOGI("TangoReplayBackend::open, replaying '%s' (%lf seconds) at %lfx.", path.c_str(),
+    reader.getLastTimestamp() - reader.getFirstTimestamp(), this->rate);
+  notifyCameraIntrinsicsChanged();
+  notifyConnectionStateChanged(TANGO_CONNECTION_STATE_CONNECTED, "");
+  return true;
+}
+
+void TangoReplayBackend::close()
+{
+  if (reader.isOpen())
+  {
+    reader.close();
+    depthSensor.reset();
+    cameraSensor.reset();
+    cameraImageTextureWidth = cameraImageTextureHeight = 0;
+    maxNumberOfPointsInPointCloud = 0;
+    cameraIntrinsicsGeneration++;
+    notifyCameraIntrinsicsChanged();
+    notifyConnectionStateChanged(TANGO_CONNECTION_STATE_DISCONNECTED, "");
+  }
+}
+
+double TangoReplayBackend::getSessionTimestamp() const
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double firstTimestamp = reader.getFirstTimestamp();
+  double duration = reader.getLastTimestamp() - firstTimestamp;
+  if (duration <= 0.0)
+  {
+    return firstTimestamp;
+  }
+  return firstTimestamp + std::fmod(secondsBetween(startTime, now) * rate, duration);
+}
+
+bool TangoReplayBackend::isConnected() const
+{
+  return reader.isOpen();
+}
+
+TangoConnectionState TangoReplayBackend::getConnectionState(std::string* error) const
+{
+  // Opening the session file is synchronous, there is no connecting state.
+  return reader.isOpen() ? TANGO_CONNECTION_STATE_CONNECTED : TANGO_CONNECTION_STATE_DISCONNECTED;
+}
+
+bool TangoReplayBackend::getPose(TangoPoseData* tangoPoseData, uint32_t* cameraFrameId)
+{
+  if (!isConnected()) return false;
+
+  double timestamp = getSessionTimestamp();
+  // Same as the live session: the pose is the one of the latest camera frame
+  // if the camera is used, the latest one otherwise.
+  long cameraFrameIndex = cameraSensor.isEnabled() ? reader.findRecord(TANGO_SESSION_RECORD_CAMERA_FRAME, timestamp) : -1;
+  if (cameraFrameIndex >= 0)
+  {
+    *cameraFrameId = cameraFrameIndex + 1;
+    timestamp = reader.getRecord(TANGO_SESSION_RECORD_CAMERA_FRAME, cameraFrameIndex)->timestamp;
+  }
+  else
+  {
+    *cameraFrameId = 0;
+  }
+  return getPoseAtTime(timestamp, tangoPoseData);
+}
+
+bool TangoReplayBackend::getLatestPose(TangoPoseData* tangoPoseData)
+{
+  if (!isConnected()) return false;
+
+  return getPoseAtTime(getSessionTimestamp(), tangoPoseData);
+}
+
+bool TangoReplayBackend::getLatestCameraFramePose(TangoPoseData* tangoPoseData, uint32_t* cameraFrameId)
+{
+  // The camera frames of the session are not locked, the frame getPose
+  // hands out is the one being replayed.
+  if (!isConnected() || !cameraSensor.isEnabled()) return false;
+
+  long cameraFrameIndex = reader.findRecord(TANGO_SESSION_RECORD_CAMERA_FRAME, getSessionTimestamp());
+  if (cameraFrameIndex < 0) return false;
+  if (!getPoseAtTime(reader.getRecord(TANGO_SESSION_RECORD_CAMERA_FRAME, cameraFrameIndex)->timestamp, tangoPoseData)) return false;
+  *cameraFrameId = cameraFrameIndex + 1;
+  return true;
+}
+
+bool TangoReplayBackend::getPoseAtTime(double timestamp, TangoPoseData* tangoPoseData) const
+{
+  size_t numberOfPoses = reader.getNumberOfRecords(TANGO_SESSION_RECORD_POSE);
+  if (numberOfPoses == 0) return false;
+
+  long index = std::max(reader.findRecord(TANGO_SESSION_RECORD_POSE, timestamp), 0L);
+  const TangoSessionRecordHeader* record0 = reader.getRecord(TANGO_SESSION_RECORD_POSE, index);
+  const TangoSessionRecordHeader* record1 = reader.getRecord(TANGO_SESSION_RECORD_POSE, std::min<size_t>(index + 1, numberOfPoses - 1));
+  const TangoSessionPose* pose0 = TangoSessionReader::getPayload<TangoSessionPose>(record0);
+  const TangoSessionPose* pose1 = TangoSessionReader::getPayload<TangoSessionPose>(record1);
+
+  double interval = record1->timestamp - record0->timestamp;
+  double alpha = interval > 0.0 ? std::min(std::max((timestamp - record0->timestamp) / interval, 0.0), 1.0) : 0.0;
+
+  std::memset(tangoPoseData, 0, sizeof(TangoPoseData));
+  tangoPoseData->timestamp = record0->timestamp + alpha * interval;
+  tangoPoseData->status_code = static_cast<TangoPoseStatusType>(pose0->statusCode);
+  for (int i = 0; i < 3; i++)
+  {
+    tangoPoseData->translation[i] = pose0->translation[i] + alpha * (pose1->translation[i] - pose0->translation[i]);
+  }
+  // Normalized linear interpolation of the orientation taking the shortest
+  // path.
+  double dot = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    dot += pose0->orientation[i] * pose1->orientation[i];
+  }
+  double sign = dot < 0 ? -1.0 : 1.0;
+  double length = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    tangoPoseData->orientation[i] = pose0->orientation[i] + alpha * (sign * pose1->orientation[i] - pose0->orientation[i]);
+    length += tangoPoseData->orientation[i] * tangoPoseData->orientation[i];
+  }
+  length = std::sqrt(length);
+  if (length > 0)
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      tangoPoseData->orientation[i] /= length;
+    }
+  }
+  return true;
+}
+
+unsigned TangoReplayBackend::getMaxNumberOfPointsInPointCloud() const
+{
+  unsigned limit = maxNumberOfPointsInPointCloudLimit;
+  return limit != 0 ? std::min(limit, maxNumberOfPointsInPointCloud) : maxNumberOfPointsInPointCloud;
+}
+
+uint32_t TangoReplayBackend::getPointCloudGeneration() const
+{
+  // The point clouds of the session are the generations.
+  return reader.findRecord(TANGO_SESSION_RECORD_POINT_CLOUD, getSessionTimestamp()) + 1;
+}
+
+uint32_t TangoReplayBackend::getLatestCameraFrameId() const
+{
+  return reader.findRecord(TANGO_SESSION_RECORD_CAMERA_FRAME, getSessionTimestamp()) + 1;
+}
+
+const TangoSessionRecordHeader* TangoReplayBackend::getLatestPointCloud() const
+{
+  long index = reader.findRecord(TANGO_SESSION_RECORD_POINT_CLOUD, getSessionTimestamp());
+  return index >= 0 ? reader.getRecord(TANGO_SESSION_RECORD_POINT_CLOUD, index) : nullptr;
+}
+
+bool TangoReplayBackend::getPointCloud(uint32_t* numberOfPoints, float* points, unsigned maxNumberOfPoints, bool justUpdatePointCloud, unsigned pointsToSkip)
+{
+  if (!isConnected()) return false;
+
+  *numberOfPoints = 0;
+  // The recorded point clouds are served at their recorded rate, only
+  // turning depth off is honored.
+  if (depthFramerate == 0) return true;
+  depthSensor.use();
+  const TangoSessionRecordHeader* record = getLatestPointCloud();
+  if (record == nullptr || justUpdatePointCloud)
+  {
+    return true;
+  }
+
+  pointsToSkip += 1;
+  const TangoSessionPointCloud* pointCloud = TangoSessionReader::getPayload<TangoSessionPointCloud>(record);
+  unsigned limit = std::min(getMaxNumberOfPointsInPointCloud(), maxNumberOfPoints);
+  if (limit == 0) return true;
+  if (pointCloud->numberOfPoints > limit * pointsToSkip)
+  {
+    pointsToSkip = (pointCloud->numberOfPoints + limit - 1) / limit;
+  }
+  const float* recordedPoints = reinterpret_cast<const float*>(pointCloud + 1);
+  const float* m = pointCloud->depthCameraTransform;
+  uint32_t j = 0;
+  for (uint32_t i = 0; i < pointCloud->numberOfPoints; i += pointsToSkip, j += 3)
+  {
+    const float* p = recordedPoints + i * 4;
+    points[j    ] = m[ 0] * p[0] + m[ 4] * p[1] + m[ 8] * p[2] + m[12];
+    points[j + 1] = m[ 1] * p[0] + m[ 5] * p[1] + m[ 9] * p[2] + m[13];
+    points[j + 2] = m[ 2] * p[0] + m[ 6] * p[1] + m[10] * p[2] + m[14];
+  }
+  *numberOfPoints = j / 3;
+  return true;
+}
+
+bool TangoReplayBackend::getPickingPointAndPlaneInPointCloud(float x, float y, double* point, double* plane)
+{
+  if (!isConnected() || cameraIntrinsics.width == 0 || depthFramerate == 0) return false;
+
+  depthSensor.use();
+  const TangoSessionRecordHeader* record = getLatestPointCloud();
+  if (record == nullptr) return false;
+  const TangoSessionPointCloud* pointCloud = TangoSessionReader::getPayload<TangoSessionPointCloud>(record);
+  const float* recordedPoints = reinterpret_cast<const float*>(pointCloud + 1);
+
+  // The extrinsics between the depth and the color cameras are not recorded
+  // so the points are projected as if both cameras were the same one.
+  std::vector<double> neighbours;
+  double closestDistance = std::numeric_limits<double>::max();
+  double closestPoint[3] = {0, 0, 0};
+  double centroid[3] = {0, 0, 0};
+  float radius2 = kPickingRadius * kPickingRadius;
+  for (uint32_t i = 0; i < pointCloud->numberOfPoints; i++)
+  {
+    const float* p = recordedPoints + i * 4;
+    if (p[2] <= 0) continue;
+    double u = (cameraIntrinsics.focalLengthX * p[0] / p[2] + cameraIntrinsics.pointX) / cameraIntrinsics.width;
+    double v = (cameraIntrinsics.focalLengthY * p[1] / p[2] + cameraIntrinsics.pointY) / cameraIntrinsics.height;
+    double distance = (u - x) * (u - x) + (v - y) * (v - y);
+    if (distance > radius2) continue;
+    neighbours.push_back(p[0]);
+    neighbours.push_back(p[1]);
+    neighbours.push_back(p[2]);
+    centroid[0] += p[0];
+    centroid[1] += p[1];
+    centroid[2] += p[2];
+    if (distance < closestDistance)
+    {
+      closestDistance = distance;
+      closestPoint[0] = p[0];
+      closestPoint[1] = p[1];
+      closestPoint[2] = p[2];
+    }
+  }
+  size_t numberOfNeighbours = neighbours.size() / 3;
+  if (numberOfNeighbours < kMinimumNumberOfPointsToFitAPlane) return false;
+  for (int i = 0; i < 3; i++)
+  {
+    centroid[i] /= numberOfNeighbours;
+  }
+  if (!fitPlane(neighbours, centroid, plane)) return false;
+
+  // Project the closest point onto the plane.
+  double distanceToPlane = plane[0] * closestPoint[0] + plane[1] * closestPoint[1] + plane[2] * closestPoint[2] + plane[3];
+  for (int i = 0; i < 3; i++)
+  {
+    point[i] = closestPoint[i] - distanceToPlane * plane[i];
+  }
+
+  multiplyMatrixWithVector(pointCloud->depthCameraTransform, point, point);
+  transformPlane(plane, pointCloud->depthCameraTransform, plane);
+  return true;
+}
+
+bool TangoReplayBackend::getCameraImageSize(uint32_t* width, uint32_t* height)
+{
+  *width = isConnected() ? cameraIntrinsics.width : 0;
+  *height = isConnected() ? cameraIntrinsics.height : 0;
+  return true;
+}
+
+bool TangoReplayBackend::getCameraImageTextureSize(uint32_t* width, uint32_t* height)
+{
+  *width = cameraImageTextureWidth;
+  *height = cameraImageTextureHeight;
+  return true;
+}
+
+bool TangoReplayBackend::getCameraFocalLength(double* focalLengthX, double* focalLengthY)
+{
+  *focalLengthX = cameraIntrinsics.focalLengthX;
+  *focalLengthY = cameraIntrinsics.focalLengthY;
+  return true;
+}
+
+bool TangoReplayBackend::getCameraPoint(double* x, double* y)
+{
+  *x = cameraIntrinsics.pointX;
+  *y = cameraIntrinsics.pointY;
+  return true;
+}
+
+uint32_t TangoReplayBackend::getCameraIntrinsicsGeneration() const
+{
+  return cameraIntrinsicsGeneration;
+}
+
+bool TangoReplayBackend::getRotatedCameraIntrinsics(uint32_t* width, uint32_t* height, double* focalLengthX, double* focalLengthY, double* pointX, double* pointY)
+{
+  if (!isConnected()) return false;
+
+  const TangoSessionCameraIntrinsics& c = cameraIntrinsics;
+  // activityOrientation follows the Android display rotation (0, 90, 180
+  // and 270 degrees).
+  switch (activityOrientation)
+  {
+    case 1:
+      *width = c.height; *height = c.width;
+      *focalLengthX = c.focalLengthY; *focalLengthY = c.focalLengthX;
+      *pointX = c.height - c.pointY; *pointY = c.pointX;
+      break;
+    case 2:
+      *width = c.width; *height = c.height;
+      *focalLengthX = c.focalLengthX; *focalLengthY = c.focalLengthY;
+      *pointX = c.width - c.pointX; *pointY = c.height - c.pointY;
+      break;
+    case 3:
+      *width = c.height; *height = c.width;
+      *focalLengthX = c.focalLengthY; *focalLengthY = c.focalLengthX;
+      *pointX = c.pointY; *pointY = c.width - c.pointX;
+      break;
+    default:
+      *width = c.width; *height = c.height;
+      *focalLengthX = c.focalLengthX; *focalLengthY = c.focalLengthY;
+      *pointX = c.pointX; *pointY = c.pointY;
+      break;
+  }
+  return true;
+}
+
+void TangoReplayBackend::distort(double x, double y, double* distortedX, double* distortedY) const
+{
+  const double* k = cameraIntrinsics.distortion;
+  double r2 = x * x + y * y;
+  switch (cameraIntrinsics.calibrationType)
+  {
+    case TANGO_CALIBRATION_POLYNOMIAL_2_PARAMETERS:
+    case TANGO_CALIBRATION_POLYNOMIAL_3_PARAMETERS:
+    {
+      double factor = 1.0 + r2 * (k[0] + r2 * (k[1] + r2 * k[2]));
+      *distortedX = x * factor;
+      *distortedY = y * factor;
+      break;
+    }
+    case TANGO_CALIBRATION_POLYNOMIAL_5_PARAMETERS:
+    {
+      // k1, k2, p1, p2, k3
+      double factor = 1.0 + r2 * (k[0] + r2 * (k[1] + r2 * k[4]));
+      *distortedX = x * factor + 2.0 * k[2] * x * y + k[3] * (r2 + 2.0 * x * x);
+      *distortedY = y * factor + k[2] * (r2 + 2.0 * y * y) + 2.0 * k[3] * x * y;
+      break;
+    }
+    case TANGO_CALIBRATION_EQUIDISTANT:
+    {
+      // The FOV model, w = k[0].
+      double r = std::sqrt(r2);
+      double w = k[0];
+      double factor = (r > 0.0 && w != 0.0) ? std::atan(2.0 * r * std::tan(w / 2.0)) / (w * r) : 1.0;
+      *distortedX = x * factor;
+      *distortedY = y * factor;
+      break;
+    }
+    default:
+      *distortedX = x;
+      *distortedY = y;
+      break;
+  }
+}
+
+bool TangoReplayBackend::getCameraUndistortionLUT(uint32_t* width, uint32_t* height, std::vector<float>& lut) const
+{
+  if (!isConnected() || cameraIntrinsics.width == 0) return false;
+
+  // Same sampling as the live session.
+  const uint32_t lutWidth = 32;
+  const uint32_t lutHeight = 24;
+  *width = lutWidth;
+  *height = lutHeight;
+  lut.resize(lutWidth * lutHeight * 2);
+  const TangoSessionCameraIntrinsics& c = cameraIntrinsics;
+  float* entry = &lut[0];
+  for (uint32_t j = 0; j < lutHeight; j++)
+  {
+    double v = j / (lutHeight - 1.0);
+    for (uint32_t i = 0; i < lutWidth; i++, entry += 2)
+    {
+      double u = i / (lutWidth - 1.0);
+      double distortedX, distortedY;
+      distort((u * c.width - c.pointX) / c.focalLengthX, (v * c.height - c.pointY) / c.focalLengthY, &distortedX, &distortedY);
+      entry[0] = (distortedX * c.focalLengthX + c.pointX) / c.width;
+      entry[1] = (distortedY * c.focalLengthY + c.pointY) / c.height;
+    }
+  }
+  return true;
+}
+
+uint32_t TangoReplayBackend::resolveCameraFrameId(uint32_t cameraFrameId) const
+{
+  size_t numberOfCameraFrames = reader.getNumberOfRecords(TANGO_SESSION_RECORD_CAMERA_FRAME);
+  if (numberOfCameraFrames == 0) return 0;
+  if (cameraFrameId == 0 || cameraFrameId > numberOfCameraFrames)
+  {
+    long index = reader.findRecord(TANGO_SESSION_RECORD_CAMERA_FRAME, getSessionTimestamp());
+    cameraFrameId = std::max(index, 0L) + 1;
+  }
+  return cameraFrameId;
+}
+
+void TangoReplayBackend::uploadCameraFrame(uint32_t textureId, uint32_t cameraFrameId) const
+{
+  const TangoSessionCameraFrame* cameraFrame = TangoSessionReader::getPayload<TangoSessionCameraFrame>(
+    reader.getRecord(TANGO_SESSION_RECORD_CAMERA_FRAME, cameraFrameId - 1));
+  // There are no external textures outside of Android, the luminance is
+  // uploaded as a regular 2D texture.
+  glBindTexture(GL_TEXTURE_2D, textureId);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, cameraFrame->width, cameraFrame->height, 0,
+    GL_LUMINANCE, GL_UNSIGNED_BYTE, cameraFrame + 1);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+bool TangoReplayBackend::updateCameraImageIntoTexture(uint32_t textureId, uint32_t cameraFrameId)
+{
+  if (!isConnected()) return false;
+
+  cameraSensor.use();
+  cameraFrameId = resolveCameraFrameId(cameraFrameId);
+  if (cameraFrameId == 0) return false;
+  // Do not upload the same frame twice.
+  if (textureId == lastUploadedTextureId && cameraFrameId == lastUploadedCameraFrameId)
+  {
+    return true;
+  }
+
+  uploadCameraFrame(textureId, cameraFrameId);
+  lastUploadedTextureId = textureId;
+  lastUploadedCameraFrameId = cameraFrameId;
+  return true;
+}
+
+void TangoReplayBackend::setCameraUnderlayFrameId(uint32_t cameraFrameId)
+{
+  cameraUnderlay.setCameraFrameId(cameraFrameId);
+}
+
+bool TangoReplayBackend::drawCameraUnderlay(int width, int height)
+{
+  // Sessions without camera frames have no texture size.
+  if (!isConnected() || cameraImageTextureWidth == 0 || !cameraUnderlay.isInUse()) return false;
+
+  // The luminance is uploaded into a regular 2D texture, the whole texture
+  // holds the (downscaled) camera frame.
+  uint32_t textureId = cameraUnderlay.getTexture(GL_TEXTURE_2D);
+  if (textureId == 0) return false;
+  // The underlay texture lives on the embedder context and is uploaded on its
+  // thread, without the upload tracking of the camera textures.
+  uint32_t cameraFrameId = cameraUnderlay.getCameraFrameIdToUpload();
+  if (cameraFrameId != 0)
+  {
+    cameraFrameId = resolveCameraFrameId(cameraFrameId);
+    if (cameraFrameId != 0) uploadCameraFrame(textureId, cameraFrameId);
+  }
+  cameraUnderlay.draw(width, height, activityOrientation, sensorOrientation, 1.0f, 1.0f);
+  return true;
+}
+
+int TangoReplayBackend::getSensorOrientation() const
+{
+  return sensorOrientation;
+}
+
+void TangoReplayBackend::getSensorUsage(double* depthTime, double* cameraTime) const
+{
+  *depthTime = depthSensor.getEnabledTime();
+  *cameraTime = cameraSensor.getEnabledTime();
+}
+
+void TangoReplayBackend::updateSensors()
+{
+  // The streams are turned on and off the same way as in a live session so
+  // the sensor usage of a page can be measured with a replay.
+  depthSensor.update();
+  cameraSensor.update();
+}
+
+bool TangoReplayBackend::getADFs(std::vector<ADF>& adfs) const
+{
+  // Area descriptions are not part of the recorded sessions.
+  adfs.clear();
+  return true;
+}
+
+void TangoReplayBackend::enableADF(const std::string& uuid)
+{
+}
+
+void TangoReplayBackend::disableADF()
+{
+}
+
+bool TangoReplayBackend::configureSensors(const TangoSensorConfiguration& configuration, std::string* error)
+{
+  if (!isConnected())
+  {
+    *error = "No Tango session is being replayed.";
+    return false;
+  }
+  if (!validateSensorConfiguration(configuration, maxNumberOfPointsInPointCloud,
+    cameraIntrinsics.width, cameraIntrinsics.height, error))
+  {
+    return false;
+  }
+  depthFramerate = configuration.depthFramerate;
+  maxNumberOfPointsInPointCloudLimit = configuration.maxNumberOfPointsInPointCloud;
+  if (depthFramerate == 0)
+  {
+    depthSensor.reset();
+  }
+  return true;
+}
+
+}  // namespace tango_chromium
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TANGO_REPLAY_BACKEND_H_
+#define _TANGO_REPLAY_BACKEND_H_
+
+#include "TangoBackend.h"
+#include "TangoCameraUnderlay.h"
+#include "TangoLazySensor.h"
+#include "TangoSessionReader.h"
+
+#include <time.h>
+
+#include <atomic>
+
+// The environment variables used to configure the replay when the backend is
+// created on demand.
+#define TANGO_SESSION_REPLAY_PATH_VARIABLE "TANGO_SESSION_REPLAY_PATH"
+#define TANGO_SESSION_REPLAY_RATE_VARIABLE "TANGO_SESSION_REPLAY_RATE"
+
+namespace tango_chromium {
+
+// TangoReplayBackend serves the poses, point clouds and camera frames of a
+// session recorded with TangoSessionRecorder. It does not need the Tango
+// service nor the Tango libraries so the WebAR stack can run (and be
+// profiled) on any platform.
+//
+// The session is replayed in a loop following the wall clock, optionally
+// accelerated. Camera frame ids are the index of the frame in the session
+// plus one, so they match across processes replaying the same file.
+class TangoReplayBackend : public TangoBackend {
+public:
+	// Creates the instance and opens the session given by the
+	// TANGO_SESSION_REPLAY_PATH environment variable, replayed at the rate
+	// given by TANGO_SESSION_REPLAY_RATE (1 by default). It is created once,
+	// even when the browser and the GPU threads ask for it at the same time,
+	// and only handed out once the session is open. It is never released as
+	// those threads can use it until the process exits.
+	static TangoReplayBackend* getInstance();
+
+	// The streams are turned off after sensorIdleTimeout seconds without use.
+	explicit TangoReplayBackend(double sensorIdleTimeout = TANGO_SENSOR_IDLE_TIMEOUT);
+	~TangoReplayBackend() override;
+
+	// A rate of 1 replays the session at the original speed, 2 twice as fast
+	// and so on.
+	bool open(const std::string& path, double rate);
+	void close();
+
+	// The session timestamp that is currently being replayed.
+	double getSessionTimestamp() const;
+
+	bool isConnected() const override;
+	TangoConnectionState getConnectionState(std::string* error) const override;
+
+	bool getPose(TangoPoseData* tangoPoseData, uint32_t* cameraFrameId) override;
+	bool getLatestPose(TangoPoseData* tangoPoseData) override;
+	bool getLatestCameraFramePose(TangoPoseData* tangoPoseData, uint32_t* cameraFrameId) override;
+
+	unsigned getMaxNumberOfPointsInPointCloud() const override;
+	uint32_t getPointCloudGeneration() const override;
+	uint32_t getLatestCameraFrameId() const override;
+	bool getPointCloud(uint32_t* numberOfPoints, float* points, unsigned maxNumberOfPoints, bool justUpdatePointCloud, unsigned pointsToSkip) override;
+	bool getPickingPointAndPlaneInPointCloud(float x, float y, double* point, double* plane) override;
+
+	bool getCameraImageSize(uint32_t* width, uint32_t* height) override;
+	bool getCameraImageTextureSize(uint32_t* width, uint32_t* height) override;
+	bool getCameraFocalLength(double* focalLengthX, double* focalLengthY) override;
+	bool getCameraPoint(double* x, double* y) override;
+	uint32_t getCameraIntrinsicsGeneration() const override;
+	bool getRotatedCameraIntrinsics(uint32_t* width, uint32_t* height, double* focalLengthX, double* focalLengthY, double* pointX, double* pointY) override;
+	bool getCameraUndistortionLUT(uint32_t* width, uint32_t* height, std::vector<float>& lut) const override;
+	bool updateCameraImageIntoTexture(uint32_t textureId, uint32_t cameraFrameId) override;
+	void setCameraUnderlayFrameId(uint32_t cameraFrameId) override;
+	bool drawCameraUnderlay(int width, int height) override;
+
+	int getSensorOrientation() const override;
+	void getSensorUsage(double* depthTime, double* cameraTime) const override;
+	void updateSensors() override;
+
+	bool getADFs(std::vector<ADF>& adfs) const override;
+	void enableADF(const std::string& uuid) override;
+	void disableADF() override;
+
+	bool configureSensors(const TangoSensorConfiguration& configuration, std::string* error) override;
+
+private:
+	bool getPoseAtTime(double timestamp, TangoPoseData* tangoPoseData) const;
+	const TangoSessionRecordHeader* getLatestPointCloud() const;
+	void distort(double x, double y, double* distortedX, double* distortedY) const;
+	// Returns the id of the camera frame to upload for cameraFrameId, the one
+	// of the session time if it is 0 or unknown, or 0 if there are none.
+	uint32_t resolveCameraFrameId(uint32_t cameraFrameId) const;
+	// Uploads the luminance of the camera frame into the 2D texture.
+	void uploadCameraFrame(uint32_t textureId, uint32_t cameraFrameId) const;
+
+	static TangoReplayBackend* createInstance();
+
+	TangoSessionReader reader;
+	double rate;
+	struct timespec startTime;
+
+	TangoSessionCameraIntrinsics cameraIntrinsics;
+	int activityOrientation;
+	int sensorOrientation;
+	uint32_t cameraImageTextureWidth;
+	uint32_t cameraImageTextureHeight;
+	unsigned maxNumberOfPointsInPointCloud;
+	uint32_t cameraIntrinsicsGeneration;
+
+	// Only accessed by the camera texture updates on the GPU thread, the
+	// underlay keeps track of its own uploads on the embedder thread.
+	uint32_t lastUploadedTextureId;
+	uint32_t lastUploadedCameraFrameId;
+
+	TangoLazySensor depthSensor;
+	TangoLazySensor cameraSensor;
+
+	TangoCameraUnderlay cameraUnderlay;
+
+	// Set with configureSensors, read from the point cloud threads.
+	std::atomic<int> depthFramerate;
+	std::atomic<unsigned> maxNumberOfPointsInPointCloudLimit;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _TANGO_REPLAY_BACKEND_H_
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TANGO_SESSION_FORMAT_H_
+#define _TANGO_SESSION_FORMAT_H_
+
+#include <stdint.h>
+
+// The binary layout of a recorded Tango session.
+//
+// A session file is append only:
+//
+//   TangoSessionFileHeader
+//   record, record, ..., index block, record, record, ..., index block, ...
+//   TangoSessionTrailer
+//
+// Every record starts with a TangoSessionRecordHeader followed by its payload.
+// Payloads are padded so every record starts at an 8 byte aligned offset and
+// the whole file can be memory mapped and read in place.
+//
+// After every TANGO_SESSION_RECORDS_PER_INDEX_BLOCK records the writer appends
+// an index block (a record of type TANGO_SESSION_RECORD_INDEX) that lists the
+// offsets of the records of that chunk and the offset of the previous index
+// block. The trailer points to the last index block so a reader can walk all
+// the chunks backwards without scanning the file. If the trailer is missing
+// (the recording was interrupted) the records can still be scanned forward
+// from the file header.
+//
+// All the values are stored in the native (little endian) byte order.
+
+namespace tango_chromium {
+
+#define TANGO_SESSION_MAGIC "TNGOSESS"
+#define TANGO_SESSION_TRAILER_MAGIC "TNGOTAIL"
+#define TANGO_SESSION_MAGIC_SIZE 8
+#define TANGO_SESSION_VERSION 1
+#define TANGO_SESSION_RECORD_ALIGNMENT 8
+#define TANGO_SESSION_RECORDS_PER_INDEX_BLOCK 256
+
+enum TangoSessionRecordType {
+	TANGO_SESSION_RECORD_INDEX = 0,
+	TANGO_SESSION_RECORD_POSE = 1,
+	TANGO_SESSION_RECORD_POINT_CLOUD = 2,
+	TANGO_SESSION_RECORD_CAMERA_FRAME = 3,
+	TANGO_SESSION_RECORD_CAMERA_INTRINSICS = 4,
+	TANGO_SESSION_RECORD_EVENT = 5,
+	TANGO_SESSION_RECORD_DISPLAY_ROTATION = 6
+};
+
+struct TangoSessionFileHeader {
+	char magic[TANGO_SESSION_MAGIC_SIZE];
+	uint32_t version;
+	uint32_t headerSize;
+	// Wall clock time (seconds since the epoch) when the recording started.
+	double creationTime;
+};
+
+struct TangoSessionRecordHeader {
+	uint32_t type;
+	// The size of the payload without the alignment padding.
+	uint32_t payloadSize;
+	// The Tango timestamp of the sample, in seconds.
+	double timestamp;
+};
+
+struct TangoSessionIndexEntry {
+	uint64_t offset;
+	double timestamp;
+	uint32_t type;
+	uint32_t payloadSize;
+};
+
+// Payload of a TANGO_SESSION_RECORD_INDEX record, followed by
+// numberOfEntries TangoSessionIndexEntry.
+struct TangoSessionIndexBlock {
+	// 0 for the first index block.
+	uint64_t previousIndexBlockOffset;
+	uint32_t numberOfEntries;
+	uint32_t padding;
+};
+
+struct TangoSessionTrailer {
+	char magic[TANGO_SESSION_MAGIC_SIZE];
+	uint64_t lastIndexBlockOffset;
+	uint64_t numberOfRecords;
+	// The number of records that were dropped because the writer could not
+	// keep up.
+	uint64_t numberOfDroppedRecords;
+};
+
+// The pose as it was served to the WebAR clients: OpenGL convention with the
+// display rotation already applied.
+struct TangoSessionPose {
+	double translation[3];
+	double orientation[4];
+	int32_t statusCode;
+	int32_t padding;
+};
+
+// Followed by numberOfPoints (x, y, z, confidence) tuples in the depth camera
+// frame.
+struct TangoSessionPointCloud {
+	// The column major depth camera to world transform at the time of the
+	// point cloud. The identity if it could not be retrieved.
+	float depthCameraTransform[16];
+	uint32_t numberOfPoints;
+	uint32_t padding;
+};
+
+// Followed by width * height bytes of the luminance (Y) plane.
+struct TangoSessionCameraFrame {
+	uint32_t width;
+	uint32_t height;
+	// The downscale factor applied to the original camera image.
+	uint32_t downscale;
+	uint32_t padding;
+};
+
+struct TangoSessionCameraIntrinsics {
+	uint32_t width;
+	uint32_t height;
+	double focalLengthX;
+	double focalLengthY;
+	double pointX;
+	double pointY;
+	double distortion[5];
+	uint32_t calibrationType;
+	uint32_t padding;
+};
+
+struct TangoSessionDisplayRotation {
+	int32_t activityOrientation;
+	int32_t sensorOrientation;
+};
+
+// Followed by keyLength + valueLength characters (not null terminated). Used
+// for the Tango service events (relocalization among others) and the ADF
+// changes.
+struct TangoSessionEvent {
+	uint32_t keyLength;
+	uint32_t valueLength;
+};
+
+inline uint32_t tangoSessionAlignedSize(uint32_t size)
+{
+	return (size + TANGO_SESSION_RECORD_ALIGNMENT - 1) & ~(TANGO_SESSION_RECORD_ALIGNMENT - 1);
+}
+
+}  // namespace tango_chromium
+
+#endif  // _TANGO_SESSION_FORMAT_H_
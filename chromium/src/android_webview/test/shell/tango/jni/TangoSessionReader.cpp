@@ -0,0 +1,304 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TangoSessionReader.h"
+
+#include "TangoLog.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// The number of record types, TANGO_SESSION_RECORD_INDEX included.
+constexpr size_t kNumberOfRecordTypes = tango_chromium::TANGO_SESSION_RECORD_DISPLAY_ROTATION + 1;
+
+bool isTimedRecordType(uint32_t type)
+{
+  return type == tango_chromium::TANGO_SESSION_RECORD_POSE ||
+    type == tango_chromium::TANGO_SESSION_RECORD_POINT_CLOUD ||
+    type == tango_chromium::TANGO_SESSION_RECORD_CAMERA_FRAME;
+}
+
+// Checks that the payload holds its struct and the data that follows it, so
+// the records can be read in place without any further check.
+bool hasValidPayload(const tango_chromium::TangoSessionRecordHeader* header)
+{
+  using namespace tango_chromium;
+  const uint8_t* payload = reinterpret_cast<const uint8_t*>(header + 1);
+  uint64_t payloadSize = header->payloadSize;
+  switch (header->type)
+  {
+    case TANGO_SESSION_RECORD_POSE:
+      return payloadSize >= sizeof(TangoSessionPose);
+    case TANGO_SESSION_RECORD_POINT_CLOUD:
+    {
+      if (payloadSize < sizeof(TangoSessionPointCloud)) return false;
+      const TangoSessionPointCloud* pointCloud = reinterpret_cast<const TangoSessionPointCloud*>(payload);
+      return payloadSize - sizeof(TangoSessionPointCloud) >= static_cast<uint64_t>(pointCloud->numberOfPoints) * 4 * sizeof(float);
+    }
+    case TANGO_SESSION_RECORD_CAMERA_FRAME:
+    {
+      if (payloadSize < sizeof(TangoSessionCameraFrame)) return false;
+      const TangoSessionCameraFrame* cameraFrame = reinterpret_cast<const TangoSessionCameraFrame*>(payload);
+      return payloadSize - sizeof(TangoSessionCameraFrame) >= static_cast<uint64_t>(cameraFrame->width) * cameraFrame->height;
+    }
+    case TANGO_SESSION_RECORD_CAMERA_INTRINSICS:
+      return payloadSize >= sizeof(TangoSessionCameraIntrinsics);
+    case TANGO_SESSION_RECORD_EVENT:
+    {
+      if (payloadSize < sizeof(TangoSessionEvent)) return false;
+      const TangoSessionEvent* event = reinterpret_cast<const TangoSessionEvent*>(payload);
+      return payloadSize - sizeof(TangoSessionEvent) >= static_cast<uint64_t>(event->keyLength) + event->valueLength;
+    }
+    case TANGO_SESSION_RECORD_DISPLAY_ROTATION:
+      return payloadSize >= sizeof(TangoSessionDisplayRotation);
+    default:
+      return false;
+  }
+}
+
+bool compareRecordTimestamps(const tango_chromium::TangoSessionRecordHeader* a, const tango_chromium::TangoSessionRecordHeader* b)
+{
+  return a->timestamp < b->timestamp;
+}
+
+}  // namespace
+
+namespace tango_chromium {
+
+TangoSessionReader::TangoSessionReader(): fileDescriptor(-1)
+  , data(nullptr)
+  , size(0)
+  , records(kNumberOfRecordTypes)
+  , firstTimestamp(0)
+  , lastTimestamp(0)
+{
+}
+
+TangoSessionReader::~TangoSessionReader()
+{
+  close();
+}
+
+bool TangoSessionReader::open(const std::string& path)
+{
+  close();
+
+  fileDescriptor = ::open(path.c_str(), O_RDONLY);
+  if (fileDescriptor < 0)
+  {
+    LOGE("TangoSessionReader::open, could not open '%s'.", path.c_str());
+    return false;
+  }
+  struct stat fileStat;
+  if (fstat(fileDescriptor, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < sizeof(TangoSessionFileHeader))
+  {
+    LOGE("TangoSessionReader::open, '%s' is not a session file.", path.c_str());
+    close();
+    return false;
+  }
+  size = fileStat.st_size;
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+  if (mapping == MAP_FAILED)
+  {
+    LOGE("TangoSessionReader::open, could not map '%s'.", path.c_str());
+    data = nullptr;
+    close();
+    return false;
+  }
+  data = static_cast<const uint8_t*>(mapping);
+
+  const TangoSessionFileHeader* fileHeader = reinterpret_cast<const TangoSessionFileHeader*>(data);
+  if (std::memcmp(fileHeader->magic, TANGO_SESSION_MAGIC, TANGO_SESSION_MAGIC_SIZE) != 0 ||
+    fileHeader->version != TANGO_SESSION_VERSION)
+  {
+    LOGE("TangoSessionReader::open, '%s' is not a supported session file.", path.c_str());
+    close();
+    return false;
+  }
+
+  if (!readIndexBlocks())
+  {
+    LOGI("TangoSessionReader::open, '%s' has no valid trailer, scanning the records.", path.c_str());
+    scanRecords();
+  }
+
+  // The records are appended as they are produced by different threads so
+  // they are not strictly ordered by timestamp.
+  firstTimestamp = std::numeric_limits<double>::max();
+  lastTimestamp = -std::numeric_limits<double>::max();
+  for (size_t type = 0; type < kNumberOfRecordTypes; type++)
+  {
+    std::stable_sort(records[type].begin(), records[type].end(), compareRecordTimestamps);
+    if (isTimedRecordType(type) && !records[type].empty())
+    {
+      firstTimestamp = std::min(firstTimestamp, records[type].front()->timestamp);
+      lastTimestamp = std::max(lastTimestamp, records[type].back()->timestamp);
+    }
+  }
+  if (firstTimestamp > lastTimestamp)
+  {
+    firstTimestamp = lastTimestamp = 0;
+  }
+  return true;
+}
+
+void TangoSessionReader::close()
+{
+  if (data != nullptr)
+  {
+    munmap(const_cast<uint8_t*>(data), size);
+    data = nullptr;
+  }
+  if (fileDescriptor >= 0)
+  {
+    ::close(fileDescriptor);
+    fileDescriptor = -1;
+  }
+  size = 0;
+  for (size_t type = 0; type < kNumberOfRecordTypes; type++)
+  {
+    records[type].clear();
+  }
+}
+
+bool TangoSessionReader::isOpen() const
+{
+  return data != nullptr;
+}
+
+size_t TangoSessionReader::getNumberOfRecords(TangoSessionRecordType type) const
+{
+  return records[type].size();
+}
+
+const TangoSessionRecordHeader* TangoSessionReader::getRecord(TangoSessionRecordType type, size_t index) const
+{
+  return index < records[type].size() ? records[type][index] : nullptr;
+}
+
+long TangoSessionReader::findRecord(TangoSessionRecordType type, double timestamp) const
+{
+  const std::vector<const TangoSessionRecordHeader*>& typeRecords = records[type];
+  TangoSessionRecordHeader key;
+  key.timestamp = timestamp;
+  std::vector<const TangoSessionRecordHeader*>::const_iterator it =
+    std::upper_bound(typeRecords.begin(), typeRecords.end(), &key, compareRecordTimestamps);
+  return static_cast<long>(it - typeRecords.begin()) - 1;
+}
+
+double TangoSessionReader::getFirstTimestamp() const
+{
+  return firstTimestamp;
+}
+
+double TangoSessionReader::getLastTimestamp() const
+{
+  return lastTimestamp;
+}
+
+bool TangoSessionReader::readIndexBlocks()
+{
+  if (size < sizeof(TangoSessionFileHeader) + sizeof(TangoSessionTrailer))
+  {
+    return false;
+  }
+  const TangoSessionTrailer* trailer = reinterpret_cast<const TangoSessionTrailer*>(data + size - sizeof(TangoSessionTrailer));
+  if (std::memcmp(trailer->magic, TANGO_SESSION_TRAILER_MAGIC, TANGO_SESSION_MAGIC_SIZE) != 0)
+  {
+    return false;
+  }
+
+  uint64_t indexBlockOffset = trailer->lastIndexBlockOffset;
+  while (indexBlockOffset != 0)
+  {
+    if (indexBlockOffset % TANGO_SESSION_RECORD_ALIGNMENT != 0 ||
+      indexBlockOffset + sizeof(TangoSessionRecordHeader) + sizeof(TangoSessionIndexBlock) > size)
+    {
+      return false;
+    }
+    const TangoSessionRecordHeader* header = reinterpret_cast<const TangoSessionRecordHeader*>(data + indexBlockOffset);
+    const TangoSessionIndexBlock* indexBlock = getPayload<TangoSessionIndexBlock>(header);
+    if (header->type != TANGO_SESSION_RECORD_INDEX ||
+      indexBlockOffset + sizeof(TangoSessionRecordHeader) + header->payloadSize > size ||
+      sizeof(TangoSessionIndexBlock) + static_cast<uint64_t>(indexBlock->numberOfEntries) * sizeof(TangoSessionIndexEntry) > header->payloadSize ||
+      // The index blocks are written in order, this also ends a cycle.
+      indexBlock->previousIndexBlockOffset >= indexBlockOffset)
+    {
+      return false;
+    }
+    const TangoSessionIndexEntry* entries = reinterpret_cast<const TangoSessionIndexEntry*>(indexBlock + 1);
+    for (uint32_t i = 0; i < indexBlock->numberOfEntries; i++)
+    {
+      addRecord(entries[i].offset);
+    }
+    indexBlockOffset = indexBlock->previousIndexBlockOffset;
+  }
+  return true;
+}
+
+void TangoSessionReader::scanRecords()
+{
+  for (size_t type = 0; type < kNumberOfRecordTypes; type++)
+  {
+    records[type].clear();
+  }
+  uint64_t offset = sizeof(TangoSessionFileHeader);
+  while (offset + sizeof(TangoSessionRecordHeader) <= size)
+  {
+    const TangoSessionRecordHeader* header = reinterpret_cast<const TangoSessionRecordHeader*>(data + offset);
+    uint64_t recordSize = sizeof(TangoSessionRecordHeader) + tangoSessionAlignedSize(header->payloadSize);
+    // Stop at the trailer or at a record that was not completely written.
+    if (header->type >= kNumberOfRecordTypes || offset + recordSize > size)
+    {
+      break;
+    }
+    addRecord(offset);
+    offset += recordSize;
+  }
+}
+
+void TangoSessionReader::addRecord(uint64_t offset)
+{
+  // The index entries of a corrupt file can point anywhere.
+  if (offset % TANGO_SESSION_RECORD_ALIGNMENT != 0 || offset < sizeof(TangoSessionFileHeader) ||
+    offset + sizeof(TangoSessionRecordHeader) > size)
+  {
+    return;
+  }
+  const TangoSessionRecordHeader* header = reinterpret_cast<const TangoSessionRecordHeader*>(data + offset);
+  if (header->type >= kNumberOfRecordTypes || header->type == TANGO_SESSION_RECORD_INDEX ||
+    offset + sizeof(TangoSessionRecordHeader) + header->payloadSize > size)
+  {
+    return;
+  }
+  if (!hasValidPayload(header))
+  {
+    LOGE("TangoSessionReader::addRecord, dropping the record of type %u at offset %llu, its payload is truncated.",
+      header->type, static_cast<unsigned long long>(offset));
+    return;
+  }
+  records[header->type].push_back(header);
+}
+
+}  // namespace tango_chromium
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TANGO_SESSION_READER_H_
+#define _TANGO_SESSION_READER_H_
+
+#include "TangoSessionFormat.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tango_chromium {
+
+// TangoSessionReader memory maps a session file written by
+// TangoSessionRecorder and gives random access to its records by type and
+// timestamp. The records are read in place, nothing is copied.
+class TangoSessionReader {
+public:
+	TangoSessionReader();
+	~TangoSessionReader();
+
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const;
+
+	size_t getNumberOfRecords(TangoSessionRecordType type) const;
+	const TangoSessionRecordHeader* getRecord(TangoSessionRecordType type, size_t index) const;
+	// Returns the index of the last record of the given type with a timestamp
+	// less or equal than the given one, or -1 if there is none.
+	long findRecord(TangoSessionRecordType type, double timestamp) const;
+
+	// The range of timestamps of the timed records (poses, point clouds and
+	// camera frames).
+	double getFirstTimestamp() const;
+	double getLastTimestamp() const;
+
+	template<typename T>
+	static const T* getPayload(const TangoSessionRecordHeader* record)
+	{
+		return reinterpret_cast<const T*>(record + 1);
+	}
+
+private:
+	bool readIndexBlocks();
+	void scanRecords();
+	void addRecord(uint64_t offset);
+
+	int fileDescriptor;
+	const uint8_t* data;
+	size_t size;
+	std::vector<std::vector<const TangoSessionRecordHeader*> > records;
+	double firstTimestamp;
+	double lastTimestamp;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _TANGO_SESSION_READER_H_
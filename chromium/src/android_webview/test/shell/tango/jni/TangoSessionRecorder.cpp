@@ -0,0 +1,432 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TangoSessionRecorder.h"
+
+#include "TangoLog.h"
+
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+// The maximum number of record buffers kept around to be reused.
+constexpr size_t kMaxNumberOfFreeRecords = 16;
+
+}  // namespace
+
+namespace tango_chromium {
+
+TangoSessionRecorder::TangoSessionRecorder(): recording(false)
+  , stopRequested(false)
+  , queuedBytes(0)
+  , maxQueuedBytes(0)
+  , numberOfDroppedRecords(0)
+  , cameraFrameDownscale(1)
+  , file(nullptr)
+  , fileOffset(0)
+  , lastIndexBlockOffset(0)
+  , numberOfRecords(0)
+{
+  pthread_mutex_init( &mutex, nullptr );
+  pthread_cond_init( &condition, nullptr );
+}
+
+TangoSessionRecorder::~TangoSessionRecorder()
+{
+  stop();
+  pthread_cond_destroy( &condition );
+  pthread_mutex_destroy( &mutex );
+}
+
+bool TangoSessionRecorder::start(const std::string& path, size_t maxQueuedBytes, uint32_t cameraFrameDownscale)
+{
+  if (isRecording())
+  {
+    LOGE("TangoSessionRecorder::start, a recording is already in progress.");
+    return false;
+  }
+
+  file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr)
+  {
+    LOGE("TangoSessionRecorder::start, could not open '%s' for writing.", path.c_str());
+    return false;
+  }
+
+  TangoSessionFileHeader fileHeader;
+  std::memset(&fileHeader, 0, sizeof(fileHeader));
+  std::memcpy(fileHeader.magic, TANGO_SESSION_MAGIC, TANGO_SESSION_MAGIC_SIZE);
+  fileHeader.version = TANGO_SESSION_VERSION;
+  fileHeader.headerSize = sizeof(TangoSessionFileHeader);
+  fileHeader.creationTime = std::time(nullptr);
+  if (std::fwrite(&fileHeader, sizeof(fileHeader), 1, file) != 1)
+  {
+    LOGE("TangoSessionRecorder::start, could not write the file header to '%s'.", path.c_str());
+    std::fclose(file);
+    file = nullptr;
+    return false;
+  }
+  fileOffset = sizeof(fileHeader);
+  lastIndexBlockOffset = 0;
+  numberOfRecords = 0;
+  indexEntries.clear();
+  indexEntries.reserve(TANGO_SESSION_RECORDS_PER_INDEX_BLOCK);
+
+  pthread_mutex_lock( &mutex );
+  this->maxQueuedBytes = maxQueuedBytes;
+  this->cameraFrameDownscale = cameraFrameDownscale > 0 ? cameraFrameDownscale : 1;
+  queuedBytes = 0;
+  numberOfDroppedRecords = 0;
+  stopRequested = false;
+  recording = true;
+  pthread_mutex_unlock( &mutex );
+
+  if (pthread_create(&writerThread, nullptr, writerThreadMain, this) != 0)
+  {
+    LOGE("TangoSessionRecorder::start, could not create the writer thread.");
+    pthread_mutex_lock( &mutex );
+    recording = false;
+    pthread_mutex_unlock( &mutex );
+    std::fclose(file);
+    file = nullptr;
+    return false;
+  }
+
+  LOGI("TangoSessionRecorder::start, recording the session to '%s'.", path.c_str());
+  return true;
+}
+
+void TangoSessionRecorder::stop()
+{
+  pthread_mutex_lock( &mutex );
+  if (!recording || stopRequested)
+  {
+    pthread_mutex_unlock( &mutex );
+    return;
+  }
+  stopRequested = true;
+  pthread_cond_signal( &condition );
+  pthread_mutex_unlock( &mutex );
+
+  pthread_join(writerThread, nullptr);
+
+  pthread_mutex_lock( &mutex );
+  recording = false;
+  stopRequested = false;
+  LOGI("TangoSessionRecorder::stop, %llu records written, %llu dropped.",
+    static_cast<unsigned long long>(numberOfRecords),
+    static_cast<unsigned long long>(numberOfDroppedRecords));
+  pthread_mutex_unlock( &mutex );
+}
+
+bool TangoSessionRecorder::isRecording() const
+{
+  pthread_mutex_lock( &mutex );
+  bool result = recording && !stopRequested;
+  pthread_mutex_unlock( &mutex );
+  return result;
+}
+
+uint64_t TangoSessionRecorder::getNumberOfDroppedRecords() const
+{
+  pthread_mutex_lock( &mutex );
+  uint64_t result = numberOfDroppedRecords;
+  pthread_mutex_unlock( &mutex );
+  return result;
+}
+
+void TangoSessionRecorder::recordPose(const TangoPoseData& pose)
+{
+  Record record;
+  TangoSessionPose* sessionPose = reinterpret_cast<TangoSessionPose*>(
+    acquireRecord(TANGO_SESSION_RECORD_POSE, pose.timestamp, sizeof(TangoSessionPose), record));
+  if (sessionPose == nullptr) return;
+
+  std::memcpy(sessionPose->translation, pose.translation, sizeof(sessionPose->translation));
+  std::memcpy(sessionPose->orientation, pose.orientation, sizeof(sessionPose->orientation));
+  sessionPose->statusCode = pose.status_code;
+  sessionPose->padding = 0;
+  commitRecord(record);
+}
+
+void TangoSessionRecorder::recordPointCloud(const TangoPointCloud& pointCloud, const float* depthCameraTransform)
+{
+  uint32_t pointsSize = pointCloud.num_points * 4 * sizeof(float);
+  Record record;
+  uint8_t* payload = acquireRecord(TANGO_SESSION_RECORD_POINT_CLOUD, pointCloud.timestamp,
+    sizeof(TangoSessionPointCloud) + pointsSize, record);
+  if (payload == nullptr) return;
+
+  TangoSessionPointCloud* sessionPointCloud = reinterpret_cast<TangoSessionPointCloud*>(payload);
+  std::memcpy(sessionPointCloud->depthCameraTransform, depthCameraTransform, sizeof(sessionPointCloud->depthCameraTransform));
+  sessionPointCloud->numberOfPoints = pointCloud.num_points;
+  sessionPointCloud->padding = 0;
+  if (pointsSize > 0)
+  {
+    std::memcpy(payload + sizeof(TangoSessionPointCloud), pointCloud.points[0], pointsSize);
+  }
+  commitRecord(record);
+}
+
+void TangoSessionRecorder::recordCameraFrame(const TangoImageBuffer& buffer)
+{
+  uint32_t downscale = cameraFrameDownscale;
+  uint32_t width = buffer.width / downscale;
+  uint32_t height = buffer.height / downscale;
+  Record record;
+  uint8_t* payload = acquireRecord(TANGO_SESSION_RECORD_CAMERA_FRAME, buffer.timestamp,
+    sizeof(TangoSessionCameraFrame) + width * height, record);
+  if (payload == nullptr) return;
+
+  TangoSessionCameraFrame* sessionCameraFrame = reinterpret_cast<TangoSessionCameraFrame*>(payload);
+  sessionCameraFrame->width = width;
+  sessionCameraFrame->height = height;
+  sessionCameraFrame->downscale = downscale;
+  sessionCameraFrame->padding = 0;
+
+  // The Y plane is the first plane in the buffer for all the color camera
+  // formats.
+  uint8_t* pixels = payload + sizeof(TangoSessionCameraFrame);
+  if (downscale == 1 && buffer.stride == width)
+  {
+    std::memcpy(pixels, buffer.data, width * height);
+  }
+  else
+  {
+    for (uint32_t y = 0; y < height; y++)
+    {
+      const uint8_t* row = buffer.data + y * downscale * buffer.stride;
+      for (uint32_t x = 0; x < width; x++)
+      {
+        *pixels++ = row[x * downscale];
+      }
+    }
+  }
+  commitRecord(record);
+}
+
+void TangoSessionRecorder::recordCameraIntrinsics(double timestamp, const TangoCameraIntrinsics& intrinsics)
+{
+  Record record;
+  TangoSessionCameraIntrinsics* sessionIntrinsics = reinterpret_cast<TangoSessionCameraIntrinsics*>(
+    acquireRecord(TANGO_SESSION_RECORD_CAMERA_INTRINSICS, timestamp, sizeof(TangoSessionCameraIntrinsics), record));
+  if (sessionIntrinsics == nullptr) return;
+
+  sessionIntrinsics->width = intrinsics.width;
+  sessionIntrinsics->height = intrinsics.height;
+  sessionIntrinsics->focalLengthX = intrinsics.fx;
+  sessionIntrinsics->focalLengthY = intrinsics.fy;
+  sessionIntrinsics->pointX = intrinsics.cx;
+  sessionIntrinsics->pointY = intrinsics.cy;
+  std::memcpy(sessionIntrinsics->distortion, intrinsics.distortion, sizeof(sessionIntrinsics->distortion));
+  sessionIntrinsics->calibrationType = intrinsics.calibration_type;
+  sessionIntrinsics->padding = 0;
+  commitRecord(record);
+}
+
+void TangoSessionRecorder::recordDisplayRotation(double timestamp, int activityOrientation, int sensorOrientation)
+{
+  Record record;
+  TangoSessionDisplayRotation* displayRotation = reinterpret_cast<TangoSessionDisplayRotation*>(
+    acquireRecord(TANGO_SESSION_RECORD_DISPLAY_ROTATION, timestamp, sizeof(TangoSessionDisplayRotation), record));
+  if (displayRotation == nullptr) return;
+
+  displayRotation->activityOrientation = activityOrientation;
+  displayRotation->sensorOrientation = sensorOrientation;
+  commitRecord(record);
+}
+
+void TangoSessionRecorder::recordEvent(double timestamp, const std::string& key, const std::string& value)
+{
+  Record record;
+  uint8_t* payload = acquireRecord(TANGO_SESSION_RECORD_EVENT, timestamp,
+    sizeof(TangoSessionEvent) + key.size() + value.size(), record);
+  if (payload == nullptr) return;
+
+  TangoSessionEvent* event = reinterpret_cast<TangoSessionEvent*>(payload);
+  event->keyLength = key.size();
+  event->valueLength = value.size();
+  char* characters = reinterpret_cast<char*>(payload + sizeof(TangoSessionEvent));
+  std::memcpy(characters, key.data(), key.size());
+  std::memcpy(characters + key.size(), value.data(), value.size());
+  commitRecord(record);
+}
+
+uint8_t* TangoSessionRecorder::acquireRecord(uint32_t type, double timestamp, uint32_t payloadSize, Record& record)
+{
+  size_t recordSize = sizeof(TangoSessionRecordHeader) + tangoSessionAlignedSize(payloadSize);
+
+  pthread_mutex_lock( &mutex );
+  if (!recording || stopRequested)
+  {
+    pthread_mutex_unlock( &mutex );
+    return nullptr;
+  }
+  if (queuedBytes + recordSize > maxQueuedBytes)
+  {
+    numberOfDroppedRecords++;
+    pthread_mutex_unlock( &mutex );
+    return nullptr;
+  }
+  queuedBytes += recordSize;
+  if (!freeRecords.empty())
+  {
+    record.swap(freeRecords.back());
+    freeRecords.pop_back();
+  }
+  pthread_mutex_unlock( &mutex );
+
+  record.resize(recordSize);
+  TangoSessionRecordHeader* header = reinterpret_cast<TangoSessionRecordHeader*>(&record[0]);
+  header->type = type;
+  header->payloadSize = payloadSize;
+  header->timestamp = timestamp;
+  // Clear the alignment padding as the buffers are reused.
+  uint8_t* payload = &record[0] + sizeof(TangoSessionRecordHeader);
+  std::memset(payload + payloadSize, 0, recordSize - sizeof(TangoSessionRecordHeader) - payloadSize);
+  return payload;
+}
+
+void TangoSessionRecorder::commitRecord(Record& record)
+{
+  pthread_mutex_lock( &mutex );
+  queuedRecords.push_back(Record());
+  queuedRecords.back().swap(record);
+  pthread_cond_signal( &condition );
+  pthread_mutex_unlock( &mutex );
+}
+
+void* TangoSessionRecorder::writerThreadMain(void* context)
+{
+  static_cast<TangoSessionRecorder*>(context)->writerLoop();
+  return nullptr;
+}
+
+void TangoSessionRecorder::writerLoop()
+{
+  std::deque<Record> records;
+  while (true)
+  {
+    pthread_mutex_lock( &mutex );
+    // Give the written buffers back to the pool.
+    for (std::deque<Record>::iterator it = records.begin(); it != records.end(); ++it)
+    {
+      queuedBytes -= it->size();
+      if (freeRecords.size() < kMaxNumberOfFreeRecords)
+      {
+        freeRecords.push_back(Record());
+        freeRecords.back().swap(*it);
+      }
+    }
+    records.clear();
+    while (queuedRecords.empty() && !stopRequested)
+    {
+      pthread_cond_wait( &condition, &mutex );
+    }
+    bool stopping = stopRequested;
+    records.swap(queuedRecords);
+    pthread_mutex_unlock( &mutex );
+
+    for (std::deque<Record>::const_iterator it = records.begin(); it != records.end(); ++it)
+    {
+      writeRecord(*it);
+    }
+
+    // Records committed after the stop request are not accepted, so the queue
+    // is empty once the swapped records are written.
+    if (stopping && records.empty())
+    {
+      break;
+    }
+  }
+
+  if (!indexEntries.empty())
+  {
+    writeIndexBlock();
+  }
+  writeTrailer();
+  std::fclose(file);
+  file = nullptr;
+}
+
+void TangoSessionRecorder::writeRecord(const Record& record)
+{
+  if (std::fwrite(&record[0], record.size(), 1, file) != 1)
+  {
+    LOGE("TangoSessionRecorder::writeRecord, writing a record failed.");
+    return;
+  }
+  const TangoSessionRecordHeader* header = reinterpret_cast<const TangoSessionRecordHeader*>(&record[0]);
+  TangoSessionIndexEntry entry;
+  entry.offset = fileOffset;
+  entry.timestamp = header->timestamp;
+  entry.type = header->type;
+  entry.payloadSize = header->payloadSize;
+  indexEntries.push_back(entry);
+  fileOffset += record.size();
+  numberOfRecords++;
+
+  if (indexEntries.size() == TANGO_SESSION_RECORDS_PER_INDEX_BLOCK)
+  {
+    writeIndexBlock();
+  }
+}
+
+void TangoSessionRecorder::writeIndexBlock()
+{
+  uint32_t payloadSize = sizeof(TangoSessionIndexBlock) + indexEntries.size() * sizeof(TangoSessionIndexEntry);
+  TangoSessionRecordHeader header;
+  header.type = TANGO_SESSION_RECORD_INDEX;
+  header.payloadSize = payloadSize;
+  header.timestamp = indexEntries.empty() ? 0.0 : indexEntries.back().timestamp;
+  TangoSessionIndexBlock indexBlock;
+  indexBlock.previousIndexBlockOffset = lastIndexBlockOffset;
+  indexBlock.numberOfEntries = indexEntries.size();
+  indexBlock.padding = 0;
+
+  // Both structures are multiples of the alignment so no padding is needed.
+  if (std::fwrite(&header, sizeof(header), 1, file) != 1 ||
+    std::fwrite(&indexBlock, sizeof(indexBlock), 1, file) != 1 ||
+    (!indexEntries.empty() && std::fwrite(&indexEntries[0], sizeof(TangoSessionIndexEntry), indexEntries.size(), file) != indexEntries.size()))
+  {
+    LOGE("TangoSessionRecorder::writeIndexBlock, writing the index block failed.");
+    return;
+  }
+  lastIndexBlockOffset = fileOffset;
+  fileOffset += sizeof(header) + payloadSize;
+  indexEntries.clear();
+  // Make every completed chunk reach the file so an interrupted recording can
+  // still be read.
+  std::fflush(file);
+}
+
+void TangoSessionRecorder::writeTrailer()
+{
+  TangoSessionTrailer trailer;
+  std::memcpy(trailer.magic, TANGO_SESSION_TRAILER_MAGIC, TANGO_SESSION_MAGIC_SIZE);
+  trailer.lastIndexBlockOffset = lastIndexBlockOffset;
+  trailer.numberOfRecords = numberOfRecords;
+  pthread_mutex_lock( &mutex );
+  trailer.numberOfDroppedRecords = numberOfDroppedRecords;
+  pthread_mutex_unlock( &mutex );
+  if (std::fwrite(&trailer, sizeof(trailer), 1, file) != 1)
+  {
+    LOGE("TangoSessionRecorder::writeTrailer, writing the trailer failed.");
+  }
+}
+
+}  // namespace tango_chromium
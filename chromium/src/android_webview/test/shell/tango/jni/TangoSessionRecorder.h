@@ -0,0 +1,103 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TANGO_SESSION_RECORDER_H_
+#define _TANGO_SESSION_RECORDER_H_
+
+#include "tango_client_api.h"   // NOLINT
+
+#include "TangoSessionFormat.h"
+
+#include <pthread.h>
+
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace tango_chromium {
+
+// TangoSessionRecorder streams the data of a Tango session (poses, point
+// clouds, camera frames, intrinsics and events) into a session file (see
+// TangoSessionFormat.h).
+//
+// The record methods can be called from any thread. They only serialize the
+// sample into a pooled buffer and queue it, the file is written from a
+// background thread. The amount of queued data is bounded: if the writer
+// cannot keep up, new samples are dropped (and counted) instead of blocking
+// the caller so the live session is not disturbed.
+class TangoSessionRecorder {
+public:
+	TangoSessionRecorder();
+	~TangoSessionRecorder();
+
+	// Opens the file and starts the writer thread. The camera frames are
+	// recorded using 1 out of every cameraFrameDownscale pixels in each
+	// dimension.
+	bool start(const std::string& path, size_t maxQueuedBytes, uint32_t cameraFrameDownscale);
+	// Writes all the queued records, the last index block and the trailer
+	// and closes the file.
+	void stop();
+	bool isRecording() const;
+
+	uint64_t getNumberOfDroppedRecords() const;
+
+	void recordPose(const TangoPoseData& pose);
+	void recordPointCloud(const TangoPointCloud& pointCloud, const float* depthCameraTransform);
+	void recordCameraFrame(const TangoImageBuffer& buffer);
+	void recordCameraIntrinsics(double timestamp, const TangoCameraIntrinsics& intrinsics);
+	void recordDisplayRotation(double timestamp, int activityOrientation, int sensorOrientation);
+	void recordEvent(double timestamp, const std::string& key, const std::string& value);
+
+private:
+	typedef std::vector<uint8_t> Record;
+
+	// Reserves room in the queue and hands out a buffer to serialize a record
+	// into. Returns a null pointer to the payload if the record must be
+	// dropped.
+	uint8_t* acquireRecord(uint32_t type, double timestamp, uint32_t payloadSize, Record& record);
+	void commitRecord(Record& record);
+
+	static void* writerThreadMain(void* context);
+	void writerLoop();
+	void writeRecord(const Record& record);
+	void writeIndexBlock();
+	void writeTrailer();
+
+	mutable pthread_mutex_t mutex;
+	pthread_cond_t condition;
+	pthread_t writerThread;
+
+	bool recording;
+	bool stopRequested;
+	std::deque<Record> queuedRecords;
+	std::vector<Record> freeRecords;
+	size_t queuedBytes;
+	size_t maxQueuedBytes;
+	uint64_t numberOfDroppedRecords;
+	uint32_t cameraFrameDownscale;
+
+	// Only accessed from the writer thread while recording.
+	FILE* file;
+	uint64_t fileOffset;
+	uint64_t lastIndexBlockOffset;
+	uint64_t numberOfRecords;
+	std::vector<TangoSessionIndexEntry> indexEntries;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _TANGO_SESSION_RECORDER_H_
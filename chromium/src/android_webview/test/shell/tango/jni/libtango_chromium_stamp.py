@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+# Copyright 2017 The Chromium Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+"""Keeps the prebuilt libtango_chromium.so in sync with its sources.
+
+ndkbuild.sh writes a stamp with the hash of the sources next to the library
+it builds. The Android build checks the stamp before linking the library:
+device/vr and the GPU process call TangoBackend through its vtable, so a
+library built from older sources still links and then calls the wrong
+methods.
+"""
+
+import argparse
+import hashlib
+import os
+import sys
+
+# The sources of the NDK build (Android.mk) and the headers they include.
+# Keep in sync with check_libtango_chromium in //device/vr/BUILD.gn.
+SOURCES = [
+    'Android.mk',
+    'Application.mk',
+    'TangoBackend.h',
+    'TangoCameraUnderlay.cpp',
+    'TangoCameraUnderlay.h',
+    'TangoHandler.cpp',
+    'TangoHandler.h',
+    'TangoHandlerJNIInterface.cpp',
+    'TangoLazySensor.h',
+    'TangoLog.h',
+    'TangoSessionFormat.h',
+    'TangoSessionRecorder.cpp',
+    'TangoSessionRecorder.h',
+]
+
+STAMP = os.path.join('armeabi-v7a', 'libtango_chromium.so.sha1')
+
+
+def _HashSources(jni_dir):
+  sha1 = hashlib.sha1()
+  for source in SOURCES:
+    sha1.update(source.encode('utf-8') + b'\0')
+    with open(os.path.join(jni_dir, source), 'rb') as f:
+      sha1.update(f.read())
+  return sha1.hexdigest()
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__)
+  parser.add_argument('command', choices=['write', 'check'])
+  parser.add_argument('--jni-dir', required=True,
+                      help='The directory of ndkbuild.sh.')
+  parser.add_argument('--library-dir', required=True,
+                      help='third_party/tango/libtango_chromium.')
+  parser.add_argument('--output',
+                      help='Written once the check passes, for the build.')
+  args = parser.parse_args()
+
+  digest = _HashSources(args.jni_dir)
+  stamp_path = os.path.join(args.library_dir, STAMP)
+  if args.command == 'write':
+    with open(stamp_path, 'w') as f:
+      f.write(digest + '\n')
+    return 0
+
+  try:
+    with open(stamp_path) as f:
+      built_digest = f.read().strip()
+  except IOError:
+    built_digest = None
+  if built_digest != digest:
+    sys.stderr.write(
+        '%s was not built from the current sources in %s.\n'
+        'Run ndkbuild.sh in that directory, then add the library (git add -f, '
+        'it matches *.so) and %s.\n' %
+        (os.path.join(args.library_dir, 'armeabi-v7a', 'libtango_chromium.so'),
+         args.jni_dir, stamp_path))
+    return 1
+
+  if args.output:
+    with open(args.output, 'w') as f:
+      f.write(digest + '\n')
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
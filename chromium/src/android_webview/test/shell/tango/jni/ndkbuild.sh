@@ -37,7 +37,14 @@ EXIT_CODE=$?
 if [ $EXIT_CODE -ne 0 ]; then 
 	exit $EXIT_CODE
 fi
-cp TangoHandler.h ../../../../../third_party/tango/libtango_chromium
+cp TangoBackend.h TangoLazySensor.h TangoLog.h TangoHandler.h TangoCameraUnderlay.h TangoSessionRecorder.h TangoSessionFormat.h ../../../../../third_party/tango/libtango_chromium
+EXIT_CODE=$?
+if [ $EXIT_CODE -ne 0 ]; then 
+	exit $EXIT_CODE
+fi
+# The Android build checks this stamp so it does not link a library built
+# from older sources.
+python ./libtango_chromium_stamp.py write --jni-dir . --library-dir ../../../../../third_party/tango/libtango_chromium
 EXIT_CODE=$?
 if [ $EXIT_CODE -ne 0 ]; then 
 	exit $EXIT_CODE
@@ -89,7 +89,7 @@ void FakeVRDevice::SetSecureOrigin(bool secure_origin) {
 void FakeVRDevice::ExitPresent() {
 }
 
-void FakeVRDevice::SubmitFrame(mojom::VRPosePtr pose) {
+void FakeVRDevice::SubmitFrame(mojom::VRFrameMetadataPtr metadata) {
 }
 
 void FakeVRDevice::UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
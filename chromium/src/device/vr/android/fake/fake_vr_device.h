@@ -26,7 +26,7 @@ class FakeVRDevice : public VRDevice {
   void SetSecureOrigin(bool secure_origin) override;
   void ExitPresent() override;
 
-  void SubmitFrame(mojom::VRPosePtr pose) override;
+  void SubmitFrame(mojom::VRFrameMetadataPtr metadata) override;
   void UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
                          mojom::VRLayerBoundsPtr right_bounds) override;
 
@@ -7,6 +7,7 @@
 
 #include "device/vr/android/gvr/gvr_device_provider.h"
 #include "device/vr/vr_export.h"
+#include "device/vr/vr_service.mojom.h"
 #include "third_party/gvr-android-sdk/src/libraries/headers/vr/gvr/capi/include/gvr_types.h"
 
 namespace gvr {
@@ -20,7 +21,10 @@ constexpr gvr::Sizei kInvalidRenderTargetSize = {0, 0};
 class DEVICE_VR_EXPORT GvrDelegate {
  public:
   virtual void SetWebVRSecureOrigin(bool secure_origin) = 0;
-  virtual void SubmitWebVRFrame() = 0;
+  // The metadata tells which pose, as passed to SetGvrPoseForWebVr, the
+  // frame was rendered with. The frame can only be used once its sync token
+  // is released.
+  virtual void SubmitWebVRFrame(mojom::VRFrameMetadataPtr metadata) = 0;
   virtual void UpdateWebVRTextureBounds(const gvr::Rectf& left_bounds,
                                         const gvr::Rectf& right_bounds) = 0;
 
@@ -273,9 +273,9 @@ void GvrDevice::ExitPresent() {
   OnExitPresent();
 }
 
-void GvrDevice::SubmitFrame(mojom::VRPosePtr pose) {
+void GvrDevice::SubmitFrame(mojom::VRFrameMetadataPtr metadata) {
   if (delegate_)
-    delegate_->SubmitWebVRFrame();
+    delegate_->SubmitWebVRFrame(std::move(metadata));
 }
 
 void GvrDevice::UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
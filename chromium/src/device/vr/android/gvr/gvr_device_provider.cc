@@ -59,6 +59,12 @@ void GvrDeviceProvider::Initialize() {
   }
 }
 
+// The delegate provider calls back with the display focus and activation
+// changes, there is nothing to poll.
+bool GvrDeviceProvider::SupportsEventPush() {
+  return true;
+}
+
 void GvrDeviceProvider::RequestPresent(
     const base::Callback<void(bool)>& callback) {
   device::GvrDelegateProvider* delegate_provider =
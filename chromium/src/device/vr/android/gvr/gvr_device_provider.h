@@ -24,6 +24,7 @@ class DEVICE_VR_EXPORT GvrDeviceProvider : public VRDeviceProvider {
 
   void GetDevices(std::vector<VRDevice*>* devices) override;
   void Initialize() override;
+  bool SupportsEventPush() override;
 
   void SetListeningForActivate(bool listening) override;
 
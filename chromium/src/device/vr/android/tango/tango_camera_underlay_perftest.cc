@@ -0,0 +1,241 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/gfx/geometry/size.h"
+#include "ui/gl/gl_bindings.h"
+#include "ui/gl/gl_context.h"
+#include "ui/gl/gl_implementation.h"
+#include "ui/gl/gl_surface.h"
+#include "ui/gl/init/gl_factory.h"
+#include "ui/gl/test/gl_surface_test_support.h"
+
+#include "TangoCameraUnderlay.h"
+
+using tango_chromium::TangoCameraUnderlay;
+
+namespace device {
+
+namespace {
+
+// A landscape phone screen and the color camera image of the Tango devices.
+const int kWidth = 1920;
+const int kHeight = 1080;
+const int kCameraImageWidth = 1920;
+const int kCameraImageHeight = 1080;
+const int kNumberOfWarmUpFrames = 5;
+const int kNumberOfFrames = 50;
+
+const char* kVertexShaderSource =
+    "attribute vec2 position;\n"
+    "varying vec2 vTextureCoord;\n"
+    "void main() {\n"
+    "  gl_Position = vec4(position, 0.0, 1.0);\n"
+    "  vTextureCoord = position * 0.5 + 0.5;\n"
+    "}\n";
+
+const char* kFragmentShaderSource =
+    "precision mediump float;\n"
+    "uniform sampler2D sampler;\n"
+    "varying vec2 vTextureCoord;\n"
+    "void main() {\n"
+    "  gl_FragColor = texture2D(sampler, vTextureCoord);\n"
+    "}\n";
+
+const GLfloat kPositions[] = {-1.0f, 1.0f, -1.0f, -1.0f,
+                              1.0f,  1.0f, 1.0f,  -1.0f};
+
+GLuint LoadShader(GLenum type, const char* source) {
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 1, &source, nullptr);
+  glCompileShader(shader);
+  return shader;
+}
+
+// Draws the WebGL canvas over the viewport the way the compositor does: an
+// opaque canvas replaces the pixels beneath it, a transparent one is blended
+// over them.
+class CanvasCompositor {
+ public:
+  CanvasCompositor() {
+    GLuint vertex_shader = LoadShader(GL_VERTEX_SHADER, kVertexShaderSource);
+    GLuint fragment_shader =
+        LoadShader(GL_FRAGMENT_SHADER, kFragmentShaderSource);
+    program_ = glCreateProgram();
+    glAttachShader(program_, vertex_shader);
+    glAttachShader(program_, fragment_shader);
+    glLinkProgram(program_);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+    position_attribute_ = glGetAttribLocation(program_, "position");
+  }
+
+  ~CanvasCompositor() { glDeleteProgram(program_); }
+
+  bool IsValid() const {
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program_, GL_LINK_STATUS, &linked);
+    return linked == GL_TRUE;
+  }
+
+  void Draw(GLuint texture, bool transparent) {
+    glViewport(0, 0, kWidth, kHeight);
+    if (transparent) {
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+      glDisable(GL_BLEND);
+    }
+    glUseProgram(program_);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glEnableVertexAttribArray(position_attribute_);
+    glVertexAttribPointer(position_attribute_, 2, GL_FLOAT, GL_FALSE, 0,
+                          kPositions);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(position_attribute_);
+    glDisable(GL_BLEND);
+  }
+
+ private:
+  GLuint program_;
+  GLint position_attribute_;
+};
+
+}  // namespace
+
+// Compares the GPU work of showing the camera image by drawing it into the
+// WebGL canvas (THREE.WebAR.createVRSeeThroughCameraMesh) with drawing it as
+// the camera underlay beneath a transparent canvas. It runs on the software
+// GL implementation (OSMesa), where the time is proportional to the pixels
+// that are read and written, so it measures the fill rate and not the bus or
+// the tiling of a particular GPU. The virtual content is the same in both
+// cases and is left out.
+class TangoCameraUnderlayPerfTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    gl::GLSurfaceTestSupport::InitializeOneOffImplementation(
+        gl::kGLImplementationOSMesaGL, false);
+    surface_ = gl::init::CreateOffscreenGLSurface(gfx::Size(kWidth, kHeight));
+    ASSERT_TRUE(surface_);
+    context_ = gl::init::CreateGLContext(nullptr, surface_.get(),
+                                         gl::PreferIntegratedGpu);
+    ASSERT_TRUE(context_);
+    ASSERT_TRUE(context_->MakeCurrent(surface_.get()));
+
+    // The camera image, uploaded the same way by both, is not measured.
+    camera_texture_ = camera_.getTexture(GL_TEXTURE_2D);
+    ASSERT_NE(0u, camera_texture_);
+    std::vector<uint8_t> image(kCameraImageWidth * kCameraImageHeight, 0x80);
+    glBindTexture(GL_TEXTURE_2D, camera_texture_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, kCameraImageWidth,
+                 kCameraImageHeight, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE,
+                 image.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glGenTextures(1, &canvas_texture_);
+    glBindTexture(GL_TEXTURE_2D, canvas_texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, kWidth, kHeight, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffersEXT(1, &canvas_framebuffer_);
+    glBindFramebufferEXT(GL_FRAMEBUFFER, canvas_framebuffer_);
+    glFramebufferTexture2DEXT(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_TEXTURE_2D, canvas_texture_, 0);
+    ASSERT_EQ(static_cast<GLenum>(GL_FRAMEBUFFER_COMPLETE),
+              glCheckFramebufferStatusEXT(GL_FRAMEBUFFER));
+    glBindFramebufferEXT(GL_FRAMEBUFFER, 0);
+
+    compositor_.reset(new CanvasCompositor());
+    ASSERT_TRUE(compositor_->IsValid());
+  }
+
+  void TearDown() override {
+    compositor_.reset();
+    glDeleteFramebuffersEXT(1, &canvas_framebuffer_);
+    glDeleteTextures(1, &canvas_texture_);
+    context_->ReleaseCurrent(surface_.get());
+    context_ = nullptr;
+    surface_ = nullptr;
+  }
+
+  // The page clears its canvas, draws the camera image into it and the
+  // compositor draws the opaque canvas.
+  void DrawCameraInCanvas() {
+    glBindFramebufferEXT(GL_FRAMEBUFFER, canvas_framebuffer_);
+    glViewport(0, 0, kWidth, kHeight);
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+    camera_.draw(kWidth, kHeight, 0, 0, 1.0f, 1.0f);
+    glBindFramebufferEXT(GL_FRAMEBUFFER, 0);
+    compositor_->Draw(canvas_texture_, false);
+  }
+
+  // The embedder draws the camera image, the page only clears its canvas to
+  // a transparent color and the compositor blends it over the camera image.
+  void DrawCameraUnderlay() {
+    camera_.draw(kWidth, kHeight, 0, 0, 1.0f, 1.0f);
+    glBindFramebufferEXT(GL_FRAMEBUFFER, canvas_framebuffer_);
+    glViewport(0, 0, kWidth, kHeight);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebufferEXT(GL_FRAMEBUFFER, 0);
+    compositor_->Draw(canvas_texture_, true);
+  }
+
+  void DrawFrame(bool camera_underlay) {
+    if (camera_underlay)
+      DrawCameraUnderlay();
+    else
+      DrawCameraInCanvas();
+  }
+
+  // Returns the average time of a frame in milliseconds.
+  double MeasureFrames(bool camera_underlay) {
+    for (int i = 0; i < kNumberOfWarmUpFrames; i++)
+      DrawFrame(camera_underlay);
+    glFinish();
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kNumberOfFrames; i++) {
+      DrawFrame(camera_underlay);
+      // The software implementation draws when it is flushed, a frame is
+      // finished before the next one as it is on screen.
+      glFinish();
+    }
+    return (base::TimeTicks::Now() - start).InMillisecondsF() /
+           kNumberOfFrames;
+  }
+
+  scoped_refptr<gl::GLSurface> surface_;
+  scoped_refptr<gl::GLContext> context_;
+  TangoCameraUnderlay camera_;
+  GLuint camera_texture_ = 0;
+  GLuint canvas_texture_ = 0;
+  GLuint canvas_framebuffer_ = 0;
+  std::unique_ptr<CanvasCompositor> compositor_;
+};
+
+TEST_F(TangoCameraUnderlayPerfTest, CameraInCanvasVersusUnderlay) {
+  double camera_in_canvas_time = MeasureFrames(false);
+  double camera_underlay_time = MeasureFrames(true);
+  EXPECT_EQ(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+  perf_test::PrintResult("camera_frame_time", "", "camera_in_canvas",
+                         camera_in_canvas_time, "ms", true);
+  perf_test::PrintResult("camera_frame_time", "", "camera_underlay",
+                         camera_underlay_time, "ms", true);
+}
+
+}  // namespace device
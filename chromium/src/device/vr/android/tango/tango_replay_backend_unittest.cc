@@ -0,0 +1,213 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/environment.h"
+#include "base/files/file_path.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#include "TangoReplayBackend.h"
+#include "TangoSessionRecorder.h"
+
+using tango_chromium::TangoReplayBackend;
+using tango_chromium::TangoSensorConfiguration;
+using tango_chromium::TangoSessionRecorder;
+
+namespace device {
+
+namespace {
+
+const int kNumberOfPoses = 100;
+const int kNumberOfCameraFrames = 10;
+const int kNumberOfPoints = 441;
+const int kNumberOfRequests = 1000;
+const double kSensorIdleTimeout = 0.05;
+
+// Serves the poses and the point clouds concurrently, like the mojo thread
+// and the worker thread of TangoVRDevice do.
+class PoseReader : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit PoseReader(TangoReplayBackend* backend)
+      : backend_(backend), number_of_poses_(0) {}
+
+  void Run() override {
+    for (int i = 0; i < kNumberOfRequests; i++) {
+      TangoPoseData pose;
+      uint32_t camera_frame_id = 0;
+      if (backend_->getPose(&pose, &camera_frame_id))
+        number_of_poses_++;
+      backend_->getLatestPose(&pose);
+      backend_->getLatestCameraFrameId();
+      uint32_t number_of_points = 0;
+      float points[3 * 16];
+      backend_->getPointCloud(&number_of_points, points, 16, false, 0);
+    }
+  }
+
+  int number_of_poses() const { return number_of_poses_; }
+
+ private:
+  TangoReplayBackend* backend_;
+  int number_of_poses_;
+};
+
+// Fetches the shared instance, like the browser and the GPU threads do the
+// first time they use the backend.
+class InstanceGetter : public base::DelegateSimpleThread::Delegate {
+ public:
+  InstanceGetter() : instance_(nullptr), connected_(false) {}
+
+  void Run() override {
+    instance_ = TangoReplayBackend::getInstance();
+    connected_ = instance_->isConnected();
+  }
+
+  TangoReplayBackend* instance() const { return instance_; }
+  bool connected() const { return connected_; }
+
+ private:
+  TangoReplayBackend* instance_;
+  bool connected_;
+};
+
+}  // namespace
+
+// The backends are shared by the browser and the GPU threads. These tests
+// are meant to run under ThreadSanitizer (is_tsan = true) as well.
+class TangoReplayBackendTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    path_ = temp_dir_.GetPath().AppendASCII("session.tango").value();
+
+    TangoSessionRecorder recorder;
+    ASSERT_TRUE(recorder.start(path_, 1 << 24, 1));
+    TangoCameraIntrinsics intrinsics;
+    memset(&intrinsics, 0, sizeof(intrinsics));
+    intrinsics.width = 64;
+    intrinsics.height = 48;
+    intrinsics.fx = intrinsics.fy = 50;
+    intrinsics.cx = 32;
+    intrinsics.cy = 24;
+    recorder.recordCameraIntrinsics(0, intrinsics);
+    recorder.recordDisplayRotation(0, 0, 0);
+    for (int i = 0; i < kNumberOfPoses; i++) {
+      TangoPoseData pose;
+      memset(&pose, 0, sizeof(pose));
+      pose.timestamp = i * 0.01;
+      pose.translation[0] = i;
+      pose.orientation[3] = 1;
+      pose.status_code = TANGO_POSE_VALID;
+      recorder.recordPose(pose);
+    }
+    std::vector<uint8_t> image(intrinsics.width * intrinsics.height);
+    for (int i = 0; i < kNumberOfCameraFrames; i++) {
+      TangoImageBuffer buffer;
+      memset(&buffer, 0, sizeof(buffer));
+      buffer.width = buffer.stride = intrinsics.width;
+      buffer.height = intrinsics.height;
+      buffer.data = image.data();
+      buffer.timestamp = i * 0.1;
+      recorder.recordCameraFrame(buffer);
+    }
+    std::vector<float> points(kNumberOfPoints * 4, 1.0f);
+    TangoPointCloud point_cloud;
+    memset(&point_cloud, 0, sizeof(point_cloud));
+    point_cloud.num_points = kNumberOfPoints;
+    point_cloud.points = reinterpret_cast<float(*)[4]>(points.data());
+    const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    recorder.recordPointCloud(point_cloud, identity);
+    recorder.stop();
+  }
+
+  base::ScopedTempDir temp_dir_;
+  std::string path_;
+};
+
+TEST_F(TangoReplayBackendTest, GetPoseFromTwoThreads) {
+  TangoReplayBackend backend;
+  // Replayed fast so the requests cross several poses and camera frames.
+  ASSERT_TRUE(backend.open(path_, 10.0));
+
+  PoseReader first_reader(&backend);
+  PoseReader second_reader(&backend);
+  base::DelegateSimpleThread first_thread(&first_reader, "first_reader");
+  base::DelegateSimpleThread second_thread(&second_reader, "second_reader");
+  first_thread.Start();
+  second_thread.Start();
+
+  // The page reconfigures the sensors while the poses are served.
+  for (int i = 0; i < kNumberOfRequests; i++) {
+    TangoSensorConfiguration configuration;
+    configuration.depthFramerate = i % 2 ? 0 : TANGO_MAX_DEPTH_FRAMERATE;
+    configuration.maxNumberOfPointsInPointCloud = 0;
+    configuration.cameraImageWidth = configuration.cameraImageHeight = 0;
+    std::string error;
+    EXPECT_TRUE(backend.configureSensors(configuration, &error)) << error;
+  }
+
+  first_thread.Join();
+  second_thread.Join();
+  EXPECT_EQ(kNumberOfRequests, first_reader.number_of_poses());
+  EXPECT_EQ(kNumberOfRequests, second_reader.number_of_poses());
+}
+
+TEST_F(TangoReplayBackendTest, DepthTurnsOffWithoutPoses) {
+  TangoReplayBackend backend(kSensorIdleTimeout);
+  ASSERT_TRUE(backend.open(path_, 1.0));
+
+  uint32_t number_of_points = 0;
+  std::vector<float> points(3 * kNumberOfPoints);
+  ASSERT_TRUE(backend.getPointCloud(&number_of_points, points.data(),
+                                    kNumberOfPoints, false, 0));
+
+  // The page stops using the point cloud and does not request poses
+  // anymore, only the device updates the sensors.
+  base::PlatformThread::Sleep(
+      base::TimeDelta::FromSecondsD(2 * kSensorIdleTimeout));
+  backend.updateSensors();
+  double depth_time = 0;
+  double camera_time = 0;
+  backend.getSensorUsage(&depth_time, &camera_time);
+  EXPECT_GT(depth_time, 0.0);
+  EXPECT_EQ(0.0, camera_time);
+
+  base::PlatformThread::Sleep(
+      base::TimeDelta::FromSecondsD(2 * kSensorIdleTimeout));
+  double later_depth_time = 0;
+  backend.getSensorUsage(&later_depth_time, &camera_time);
+  EXPECT_EQ(depth_time, later_depth_time);
+}
+
+TEST_F(TangoReplayBackendTest, GetInstanceFromTwoThreads) {
+  // The instance opens the session given by the environment. It is kept
+  // until the process exits, with the session file mapped.
+  std::unique_ptr<base::Environment> env(base::Environment::Create());
+  ASSERT_TRUE(env->SetVar(TANGO_SESSION_REPLAY_PATH_VARIABLE, path_));
+
+  InstanceGetter first_getter;
+  InstanceGetter second_getter;
+  base::DelegateSimpleThread first_thread(&first_getter, "first_getter");
+  base::DelegateSimpleThread second_thread(&second_getter, "second_getter");
+  first_thread.Start();
+  second_thread.Start();
+  first_thread.Join();
+  second_thread.Join();
+  env->UnSetVar(TANGO_SESSION_REPLAY_PATH_VARIABLE);
+
+  ASSERT_TRUE(first_getter.instance());
+  EXPECT_EQ(first_getter.instance(), second_getter.instance());
+  // Neither thread gets the instance before its session is open.
+  EXPECT_TRUE(first_getter.connected());
+  EXPECT_TRUE(second_getter.connected());
+}
+
+}  // namespace device
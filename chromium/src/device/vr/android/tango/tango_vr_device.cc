@@ -6,25 +6,97 @@
 
 #include "tango_support_api.h"
 
+#include "base/bind.h"
+#include "base/task_runner_util.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "base/trace_event/trace_event.h"
 
-#include "TangoHandler.h"
+#include "TangoBackend.h"
 
 #define THIS_VALUE_NEEDS_TO_BE_OBTAINED_FROM_THE_TANGO_API -1
 
-using base::android::AttachCurrentThread;
-using tango_chromium::TangoHandler;
+using tango_chromium::TangoBackend;
 using tango_chromium::ADF;
 
 namespace device {
 
+namespace {
+
+mojom::VRConnectionState ToMojo(tango_chromium::TangoConnectionState state) {
+  switch (state) {
+    case tango_chromium::TANGO_CONNECTION_STATE_CONNECTING:
+      return mojom::VRConnectionState::CONNECTING;
+    case tango_chromium::TANGO_CONNECTION_STATE_CONNECTED:
+      return mojom::VRConnectionState::CONNECTED;
+    case tango_chromium::TANGO_CONNECTION_STATE_FAILED:
+      return mojom::VRConnectionState::FAILED;
+    case tango_chromium::TANGO_CONNECTION_STATE_DISCONNECTED:
+      break;
+  }
+  return mojom::VRConnectionState::DISCONNECTED;
+}
+
+mojom::VRPosePtr ToMojo(const TangoPoseData& tangoPoseData,
+                        uint32_t cameraFrameId) {
+  mojom::VRPosePtr pose = mojom::VRPose::New();
+
+  pose->timestamp = base::Time::Now().ToJsTime();
+  pose->cameraFrameId = cameraFrameId;
+
+  pose->orientation.emplace(4);
+  pose->position.emplace(3);
+
+  pose->orientation.value()[0] = tangoPoseData.orientation[0]/*decomposed_transform.quaternion[0]*/;
+  pose->orientation.value()[1] = tangoPoseData.orientation[1]/*decomposed_transform.quaternion[1]*/;
+  pose->orientation.value()[2] = tangoPoseData.orientation[2]/*decomposed_transform.quaternion[2]*/;
+  pose->orientation.value()[3] = tangoPoseData.orientation[3]/*decomposed_transform.quaternion[3]*/;
+
+  pose->position.value()[0] = tangoPoseData.translation[0]/*decomposed_transform.translate[0]*/;
+  pose->position.value()[1] = tangoPoseData.translation[1]/*decomposed_transform.translate[1]*/;
+  pose->position.value()[2] = tangoPoseData.translation[2]/*decomposed_transform.translate[2]*/;
+
+  return pose;
+}
+
+void OnSensorsConfigured(const VRDevice::ConfigureSensorsCallback& callback,
+                         const std::string& error) {
+  callback.Run(error.empty(), error);
+}
+
+}  // namespace
+
 TangoVRDevice::TangoVRDevice(TangoVRDeviceProvider* provider)
-    : tangoVRDeviceProvider(provider) {
+    : TangoVRDevice(provider, TangoBackend::getInstance()) {}
+
+TangoVRDevice::TangoVRDevice(TangoVRDeviceProvider* provider,
+                             TangoBackend* backend)
+    : tangoVRDeviceProvider(provider),
+      tangoBackend(backend),
+      waitingForFirstPose(false),
+      workerThread("TangoVRDeviceWorker"),
+      cachedPointCloudGeneration(0),
+      cachedPickingPointCloudGeneration(0),
+      cachedPickingCameraFrameId(0),
+      cacheInvalidations(0),
+      pointCloudCacheHits(0),
+      pointCloudCacheMisses(0),
+      pickingCacheHits(0),
+      pickingCacheMisses(0),
+      taskRunner(base::ThreadTaskRunnerHandle::Get()),
+      weakPtrFactory(this) {
   tangoCoordinateFramePair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
   tangoCoordinateFramePair.target = TANGO_COORDINATE_FRAME_DEVICE;
+  workerThread.Start();
+  // The weak pointer is created here as it is bound on the Tango threads.
+  weakThis = weakPtrFactory.GetWeakPtr();
+  tangoBackend->setListener(this);
+  sensorTimer.Start(FROM_HERE, base::TimeDelta::FromSeconds(1), this,
+                    &TangoVRDevice::UpdateSensors);
 }
 
 TangoVRDevice::~TangoVRDevice() {
+  tangoBackend->setListener(0);
+  workerThread.Stop();
 }
 
 mojom::VRDisplayInfoPtr TangoVRDevice::GetVRDevice() {
@@ -80,65 +152,122 @@ mojom::VRDisplayInfoPtr TangoVRDevice::GetVRDevice() {
   // device->stageParameters = mojom::VRStageParameters::New();
   // device->stageParameters->standingTransform = mojo::Array<float>::New(16);
 
+  device->seeThroughCamera = GetSeeThroughCamera();
+
+  std::string connectionError;
+  device->connectionState = ToMojo(
+      tangoBackend->getConnectionState(&connectionError));
+  if (device->connectionState == mojom::VRConnectionState::FAILED)
+    device->connectionError = connectionError;
+
   return device;
 }
 
 mojom::VRPosePtr TangoVRDevice::GetPose() {
-
   TangoPoseData tangoPoseData;
+  uint32_t cameraFrameId;
 
   mojom::VRPosePtr pose = nullptr;
-  if (TangoHandler::getInstance()->isConnected() && TangoHandler::getInstance()->getPose(&tangoPoseData))
+  if (tangoBackend->isConnected() && tangoBackend->getPose(&tangoPoseData, &cameraFrameId))
   {
-    pose = mojom::VRPose::New();
-
-    pose->timestamp = base::Time::Now().ToJsTime();
+    pose = ToMojo(tangoPoseData, cameraFrameId);
 
-    pose->orientation.emplace(4);
-    pose->position.emplace(3);
-
-    pose->orientation.value()[0] = tangoPoseData.orientation[0]/*decomposed_transform.quaternion[0]*/;
-    pose->orientation.value()[1] = tangoPoseData.orientation[1]/*decomposed_transform.quaternion[1]*/;
-    pose->orientation.value()[2] = tangoPoseData.orientation[2]/*decomposed_transform.quaternion[2]*/;
-    pose->orientation.value()[3] = tangoPoseData.orientation[3]/*decomposed_transform.quaternion[3]*/;
-
-    pose->position.value()[0] = tangoPoseData.translation[0]/*decomposed_transform.translate[0]*/;
-    pose->position.value()[1] = tangoPoseData.translation[1]/*decomposed_transform.translate[1]*/;
-    pose->position.value()[2] = tangoPoseData.translation[2]/*decomposed_transform.translate[2]*/;
+    if (waitingForFirstPose)
+    {
+      waitingForFirstPose = false;
+      TRACE_EVENT_ASYNC_END0("input", "TangoVRDevice::TimeToFirstPose", this);
+    }
   }
 
   return pose;
 }
 
+mojom::VRPosePtr TangoVRDevice::GetLatestPose() {
+  TangoPoseData tangoPoseData;
+  if (!tangoBackend->isConnected() || !tangoBackend->getLatestPose(&tangoPoseData))
+    return nullptr;
+
+  return ToMojo(tangoPoseData, 0);
+}
+
 void TangoVRDevice::ResetPose() {
   // TODO
 }
 
 unsigned TangoVRDevice::GetMaxNumberOfPointsInPointCloud()
 {
-  return TangoHandler::getInstance()->getMaxNumberOfPointsInPointCloud();
+  return tangoBackend->getMaxNumberOfPointsInPointCloud();
 }
 
 mojom::VRPointCloudPtr TangoVRDevice::GetPointCloud(bool justUpdatePointCloud, unsigned pointsToSkip)
 {
-  TangoHandler* tangoHandler = TangoHandler::getInstance();
   mojom::VRPointCloudPtr pointCloudPtr = nullptr;
-  if (tangoHandler->isConnected())
+  if (tangoBackend->isConnected())
   {
+    // A generation of 0 means the backend cannot tell when the point cloud
+    // changes so nothing can be reused.
+    uint32_t pointCloudGeneration = tangoBackend->getPointCloudGeneration();
+    std::pair<bool, unsigned> key(justUpdatePointCloud, pointsToSkip);
+    uint32_t invalidations;
+    {
+      // The lock is not held while the point cloud is retrieved so the other
+      // displays can still get their cached results in the meantime.
+      base::AutoLock lock(cacheLock);
+      invalidations = cacheInvalidations;
+      if (pointCloudGeneration != 0)
+      {
+        if (pointCloudGeneration != cachedPointCloudGeneration)
+        {
+          cachedPointClouds.clear();
+          cachedPointCloudGeneration = pointCloudGeneration;
+        }
+        auto it = cachedPointClouds.find(key);
+        if (it != cachedPointClouds.end())
+        {
+          pointCloudCacheHits++;
+          TRACE_COUNTER2("input", "TangoVRDevice::PointCloudCache", "hits", pointCloudCacheHits, "misses", pointCloudCacheMisses);
+          return it->second.Clone();
+        }
+      }
+      pointCloudCacheMisses++;
+      TRACE_COUNTER2("input", "TangoVRDevice::PointCloudCache", "hits", pointCloudCacheHits, "misses", pointCloudCacheMisses);
+    }
     if (!justUpdatePointCloud)
     {
+      // The limit is read once, configureSensors can change it before the
+      // point cloud is retrieved.
+      unsigned maxNumberOfPoints = tangoBackend->getMaxNumberOfPointsInPointCloud();
       pointCloudPtr = mojom::VRPointCloud::New();
-      pointCloudPtr->points.resize(tangoHandler->getMaxNumberOfPointsInPointCloud() * 3);
-      if (!tangoHandler->getPointCloud(&(pointCloudPtr->numberOfPoints), &(pointCloudPtr->points[0]), justUpdatePointCloud, pointsToSkip))
+      pointCloudPtr->points.resize(maxNumberOfPoints * 3);
+      if (!tangoBackend->getPointCloud(&(pointCloudPtr->numberOfPoints), pointCloudPtr->points.data(), maxNumberOfPoints, justUpdatePointCloud, pointsToSkip))
       {
         pointCloudPtr = nullptr;
       }
+      else
+      {
+        // Only the live points are sent to the renderer (and cached), the
+        // renderer copies them into its max-size array.
+        pointCloudPtr->points.resize(pointCloudPtr->numberOfPoints * 3);
+      }
     }
     else 
     {
       // If the point cloud should only be updated, why create a whole array?
       uint32_t numberOfPoints;
-      tangoHandler->getPointCloud(&numberOfPoints, 0, justUpdatePointCloud, pointsToSkip);
+      tangoBackend->getPointCloud(&numberOfPoints, 0, 0, justUpdatePointCloud, pointsToSkip);
+    }
+    // The generation is read again after the point cloud is retrieved: if a
+    // newer point cloud arrived in between, the one retrieved can belong to
+    // either generation so it is not cached. Another display may also have
+    // moved the cache on to a newer point cloud in the meantime, or the
+    // sensors may have been configured again.
+    bool unchanged = tangoBackend->getPointCloudGeneration() == pointCloudGeneration;
+    base::AutoLock lock(cacheLock);
+    if (unchanged && pointCloudGeneration != 0 &&
+        pointCloudGeneration == cachedPointCloudGeneration &&
+        invalidations == cacheInvalidations)
+    {
+      cachedPointClouds[key] = pointCloudPtr.Clone();
     }
   }
   return pointCloudPtr;
@@ -146,16 +275,20 @@ mojom::VRPointCloudPtr TangoVRDevice::GetPointCloud(bool justUpdatePointCloud, u
 
 mojom::VRSeeThroughCameraPtr TangoVRDevice::GetSeeThroughCamera()
 {
-  TangoHandler* tangoHandler = TangoHandler::getInstance();
   mojom::VRSeeThroughCameraPtr seeThroughCameraPtr = nullptr;
-  if (tangoHandler->isConnected())
+  if (tangoBackend->isConnected())
   {
     seeThroughCameraPtr = mojom::VRSeeThroughCamera::New();
-    tangoHandler->getCameraImageSize(&(seeThroughCameraPtr->width), &(seeThroughCameraPtr->height));
-    tangoHandler->getCameraImageTextureSize(&(seeThroughCameraPtr->textureWidth), &(seeThroughCameraPtr->textureHeight));
-    tangoHandler->getCameraFocalLength(&(seeThroughCameraPtr->focalLengthX), &(seeThroughCameraPtr->focalLengthY));
-    tangoHandler->getCameraPoint(&(seeThroughCameraPtr->pointX), &(seeThroughCameraPtr->pointY));
-    seeThroughCameraPtr->orientation = tangoHandler->getSensorOrientation();
+    tangoBackend->getCameraImageSize(&(seeThroughCameraPtr->width), &(seeThroughCameraPtr->height));
+    tangoBackend->getCameraImageTextureSize(&(seeThroughCameraPtr->textureWidth), &(seeThroughCameraPtr->textureHeight));
+    tangoBackend->getCameraFocalLength(&(seeThroughCameraPtr->focalLengthX), &(seeThroughCameraPtr->focalLengthY));
+    tangoBackend->getCameraPoint(&(seeThroughCameraPtr->pointX), &(seeThroughCameraPtr->pointY));
+    seeThroughCameraPtr->orientation = tangoBackend->getSensorOrientation();
+    tangoBackend->getRotatedCameraIntrinsics(&(seeThroughCameraPtr->rotatedWidth), &(seeThroughCameraPtr->rotatedHeight), 
+      &(seeThroughCameraPtr->rotatedFocalLengthX), &(seeThroughCameraPtr->rotatedFocalLengthY), 
+      &(seeThroughCameraPtr->rotatedPointX), &(seeThroughCameraPtr->rotatedPointY));
+    tangoBackend->getCameraUndistortionLUT(&(seeThroughCameraPtr->undistortionLUTWidth), 
+      &(seeThroughCameraPtr->undistortionLUTHeight), seeThroughCameraPtr->undistortionLUT);
   }
   return seeThroughCameraPtr;
 }
@@ -163,15 +296,55 @@ mojom::VRSeeThroughCameraPtr TangoVRDevice::GetSeeThroughCamera()
 mojom::VRPickingPointAndPlanePtr TangoVRDevice::GetPickingPointAndPlaneInPointCloud(float x, float y)
 {
   mojom::VRPickingPointAndPlanePtr pickingPointAndPlanePtr = nullptr;
-  if (TangoHandler::getInstance()->isConnected())
+  if (tangoBackend->isConnected())
   {
+    // The picking depends on both the point cloud and the pose of the camera
+    // frame so the results are reused until either of them changes.
+    uint32_t pointCloudGeneration = tangoBackend->getPointCloudGeneration();
+    uint32_t cameraFrameId = tangoBackend->getLatestCameraFrameId();
+    bool cacheable = pointCloudGeneration != 0 && cameraFrameId != 0;
+    std::pair<float, float> key(x, y);
+    uint32_t invalidations;
+    {
+      base::AutoLock lock(cacheLock);
+      invalidations = cacheInvalidations;
+      if (cacheable)
+      {
+        if (pointCloudGeneration != cachedPickingPointCloudGeneration || cameraFrameId != cachedPickingCameraFrameId)
+        {
+          cachedPickingPointsAndPlanes.clear();
+          cachedPickingPointCloudGeneration = pointCloudGeneration;
+          cachedPickingCameraFrameId = cameraFrameId;
+        }
+        auto it = cachedPickingPointsAndPlanes.find(key);
+        if (it != cachedPickingPointsAndPlanes.end())
+        {
+          pickingCacheHits++;
+          TRACE_COUNTER2("input", "TangoVRDevice::PickingCache", "hits", pickingCacheHits, "misses", pickingCacheMisses);
+          return it->second.Clone();
+        }
+      }
+      pickingCacheMisses++;
+      TRACE_COUNTER2("input", "TangoVRDevice::PickingCache", "hits", pickingCacheHits, "misses", pickingCacheMisses);
+    }
+
     pickingPointAndPlanePtr = mojom::VRPickingPointAndPlane::New();
     pickingPointAndPlanePtr->point = std::vector<double>(3);
     pickingPointAndPlanePtr->plane = std::vector<double>(4);
-    if (!TangoHandler::getInstance()->getPickingPointAndPlaneInPointCloud(x, y, &(pickingPointAndPlanePtr->point[0]), &(pickingPointAndPlanePtr->plane[0])))
+    if (!tangoBackend->getPickingPointAndPlaneInPointCloud(x, y, &(pickingPointAndPlanePtr->point[0]), &(pickingPointAndPlanePtr->plane[0])))
     {
       pickingPointAndPlanePtr = nullptr;
     }
+    // Same as the point clouds, the result is only cached if it was
+    // calculated with the point cloud and the camera frame it is cached for.
+    bool unchanged = tangoBackend->getPointCloudGeneration() == pointCloudGeneration &&
+        tangoBackend->getLatestCameraFrameId() == cameraFrameId;
+    base::AutoLock lock(cacheLock);
+    if (unchanged && cacheable && pointCloudGeneration == cachedPickingPointCloudGeneration &&
+        cameraFrameId == cachedPickingCameraFrameId && invalidations == cacheInvalidations)
+    {
+      cachedPickingPointsAndPlanes[key] = pickingPointAndPlanePtr.Clone();
+    }
   }
   return pickingPointAndPlanePtr;
 }
@@ -179,10 +352,10 @@ mojom::VRPickingPointAndPlanePtr TangoVRDevice::GetPickingPointAndPlaneInPointCl
 std::vector<mojom::VRADFPtr> TangoVRDevice::GetADFs()
 {
   std::vector<mojom::VRADFPtr> mojomADFs;
-  if (TangoHandler::getInstance()->isConnected())
+  if (tangoBackend->isConnected())
   {
     std::vector<ADF> adfs;
-    if (TangoHandler::getInstance()->getADFs(adfs))
+    if (tangoBackend->getADFs(adfs))
     {
       std::vector<ADF>::size_type size = adfs.size();
       mojomADFs.resize(size);
@@ -200,12 +373,125 @@ std::vector<mojom::VRADFPtr> TangoVRDevice::GetADFs()
 
 void TangoVRDevice::EnableADF(const std::string& uuid)
 {
-  TangoHandler::getInstance()->enableADF(uuid);
+  // Enabling an ADF reconnects to the Tango service so it is serialized with
+  // the rest of the point cloud work.
+  workerThread.task_runner()->PostTask(FROM_HERE,
+    base::Bind(&TangoBackend::enableADF, base::Unretained(tangoBackend), uuid));
 }
 
 void TangoVRDevice::DisableADF()
 {
-  TangoHandler::getInstance()->disableADF();
+  workerThread.task_runner()->PostTask(FROM_HERE,
+    base::Bind(&TangoBackend::disableADF, base::Unretained(tangoBackend)));
+}
+
+void TangoVRDevice::GetPointCloudAsync(bool justUpdatePointCloud, unsigned pointsToSkip, const PointCloudCallback& callback)
+{
+  base::PostTaskAndReplyWithResult(workerThread.task_runner().get(), FROM_HERE,
+    base::Bind(&TangoVRDevice::GetPointCloud, base::Unretained(this), justUpdatePointCloud, pointsToSkip),
+    callback);
+}
+
+void TangoVRDevice::GetPickingPointAndPlaneInPointCloudAsync(float x, float y, const PickingPointAndPlaneCallback& callback)
+{
+  base::PostTaskAndReplyWithResult(workerThread.task_runner().get(), FROM_HERE,
+    base::Bind(&TangoVRDevice::GetPickingPointAndPlaneInPointCloud, base::Unretained(this), x, y),
+    callback);
+}
+
+void TangoVRDevice::GetPickingPointsAndPlanesInPointCloudAsync(const std::vector<float>& coordinates, const PickingPointsAndPlanesCallback& callback)
+{
+  // All the pickings of a batch run in a single task, against the same point
+  // cloud unless it changes in between.
+  base::PostTaskAndReplyWithResult(workerThread.task_runner().get(), FROM_HERE,
+    base::Bind(&TangoVRDevice::GetPickingPointsAndPlanesInPointCloud, base::Unretained(this), coordinates),
+    callback);
+}
+
+void TangoVRDevice::GetADFsAsync(const ADFsCallback& callback)
+{
+  base::PostTaskAndReplyWithResult(workerThread.task_runner().get(), FROM_HERE,
+    base::Bind(&TangoVRDevice::GetADFs, base::Unretained(this)),
+    callback);
+}
+
+void TangoVRDevice::onPointCloudAvailable(double timestamp)
+{
+  taskRunner->PostTask(FROM_HERE,
+    base::Bind(&TangoVRDevice::OnPointCloudAvailable, weakThis, timestamp));
+}
+
+void TangoVRDevice::onCameraFrameAvailable()
+{
+  taskRunner->PostTask(FROM_HERE,
+    base::Bind(&TangoVRDevice::OnCameraFrameAvailable, weakThis));
+}
+
+void TangoVRDevice::onTrackingStateChanged(bool tracking)
+{
+  taskRunner->PostTask(FROM_HERE,
+    base::Bind(&TangoVRDevice::OnTrackingStateChanged, weakThis, tracking));
+}
+
+void TangoVRDevice::onCameraIntrinsicsChanged()
+{
+  taskRunner->PostTask(FROM_HERE,
+    base::Bind(&TangoVRDevice::OnCameraIntrinsicsChanged, weakThis));
+}
+
+void TangoVRDevice::onConnectionStateChanged(tango_chromium::TangoConnectionState state, const std::string& error)
+{
+  // The error is part of the display info.
+  taskRunner->PostTask(FROM_HERE,
+    base::Bind(&TangoVRDevice::OnConnectionStateChanged, weakThis, state));
+}
+
+void TangoVRDevice::UpdateSensors()
+{
+  tangoBackend->updateSensors();
+
+  // The depth and camera streams are only enabled while they are used, the
+  // time they have been on shows up in the traces (also with a replayed
+  // session) to compare the cost of different pages.
+  double depthTime, cameraTime;
+  tangoBackend->getSensorUsage(&depthTime, &cameraTime);
+  TRACE_COUNTER2("input", "TangoVRDevice::SensorUsage", "depthMs",
+                 static_cast<int>(depthTime * 1000), "cameraMs",
+                 static_cast<int>(cameraTime * 1000));
+}
+
+void TangoVRDevice::OnCameraIntrinsicsChanged()
+{
+  // The see through camera is part of the display info.
+  OnChanged();
+}
+
+void TangoVRDevice::OnConnectionStateChanged(tango_chromium::TangoConnectionState state)
+{
+  switch (state)
+  {
+    case tango_chromium::TANGO_CONNECTION_STATE_CONNECTING:
+      if (!waitingForFirstPose)
+      {
+        waitingForFirstPose = true;
+        TRACE_EVENT_ASYNC_BEGIN0("input", "TangoVRDevice::TimeToFirstPose", this);
+      }
+      break;
+    case tango_chromium::TANGO_CONNECTION_STATE_CONNECTED:
+      if (waitingForFirstPose)
+        TRACE_EVENT_ASYNC_STEP_INTO0("input", "TangoVRDevice::TimeToFirstPose", this, "Connected");
+      break;
+    case tango_chromium::TANGO_CONNECTION_STATE_DISCONNECTED:
+    case tango_chromium::TANGO_CONNECTION_STATE_FAILED:
+      if (waitingForFirstPose)
+      {
+        waitingForFirstPose = false;
+        TRACE_EVENT_ASYNC_END1("input", "TangoVRDevice::TimeToFirstPose", this, "aborted", true);
+      }
+      break;
+  }
+  // The displays read the new state from the display info.
+  OnChanged();
 }
 
 void TangoVRDevice::RequestPresent(const base::Callback<void(bool)>& callback) {
@@ -223,7 +509,7 @@ void TangoVRDevice::ExitPresent() {
   // OnExitPresent();
 }
 
-void TangoVRDevice::SubmitFrame(mojom::VRPosePtr pose) {
+void TangoVRDevice::SubmitFrame(mojom::VRFrameMetadataPtr metadata) {
   // if (delegate_)
   //   delegate_->SubmitWebVRFrame();
 }
@@ -248,4 +534,36 @@ void TangoVRDevice::UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
   // delegate_->UpdateWebVRTextureBounds(left_gvr_bounds, right_gvr_bounds);
 }
 
+void TangoVRDevice::ConfigureSensors(
+    mojom::VRSensorConfigurationPtr configuration,
+    const ConfigureSensorsCallback& callback) {
+  // Serialized with the point cloud work so no point cloud is half way
+  // through when the limits change.
+  base::PostTaskAndReplyWithResult(workerThread.task_runner().get(), FROM_HERE,
+      base::Bind(&TangoVRDevice::ConfigureSensorsOnWorkerThread,
+                 base::Unretained(this), base::Passed(&configuration)),
+      base::Bind(&OnSensorsConfigured, callback));
+}
+
+std::string TangoVRDevice::ConfigureSensorsOnWorkerThread(
+    mojom::VRSensorConfigurationPtr configuration) {
+  tango_chromium::TangoSensorConfiguration tangoSensorConfiguration;
+  tangoSensorConfiguration.depthFramerate = configuration->depthFramerate;
+  tangoSensorConfiguration.maxNumberOfPointsInPointCloud =
+      configuration->maxNumberOfPointsInPointCloud;
+  tangoSensorConfiguration.cameraImageWidth = configuration->cameraImageWidth;
+  tangoSensorConfiguration.cameraImageHeight = configuration->cameraImageHeight;
+  std::string error;
+  if (!tangoBackend->configureSensors(tangoSensorConfiguration, &error)) {
+    return error.empty() ? "The sensor configuration is not supported." : error;
+  }
+
+  // The cached point clouds may have more points than allowed now.
+  base::AutoLock lock(cacheLock);
+  cachedPointClouds.clear();
+  cachedPickingPointsAndPlanes.clear();
+  cacheInvalidations++;
+  return std::string();
+}
+
 }  // namespace device
@@ -5,25 +5,38 @@
 #ifndef DEVICE_VR_TANGO_VR_DEVICE_H
 #define DEVICE_VR_TANGO_VR_DEVICE_H
 
-#include <jni.h>
+#include <map>
+#include <utility>
 
-#include "base/android/jni_android.h"
 #include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread.h"
+#include "base/timer/timer.h"
 #include "device/vr/vr_device.h"
+#include "device/vr/vr_export.h"
 
 #include "tango_client_api.h"
+#include "TangoBackend.h"
 
 namespace device {
 
 class TangoVRDeviceProvider;
 
-class TangoVRDevice : public VRDevice {
+class DEVICE_VR_EXPORT TangoVRDevice
+    : public VRDevice,
+      public tango_chromium::TangoBackendListener {
  public:
   explicit TangoVRDevice(TangoVRDeviceProvider* provider);
+  // Uses the given backend instead of the shared instance, for the tests.
+  TangoVRDevice(TangoVRDeviceProvider* provider,
+                tango_chromium::TangoBackend* backend);
   ~TangoVRDevice() override;
 
   mojom::VRDisplayInfoPtr GetVRDevice() override;
   mojom::VRPosePtr GetPose() override;
+  mojom::VRPosePtr GetLatestPose() override;
   void ResetPose() override;
   unsigned GetMaxNumberOfPointsInPointCloud() override;
   mojom::VRPointCloudPtr GetPointCloud(bool justUpdatePointCloud, unsigned pointsToSkip) override;
@@ -33,16 +46,83 @@ class TangoVRDevice : public VRDevice {
   void EnableADF(const std::string& uuid) override;
   void DisableADF() override;
 
+  void GetPointCloudAsync(bool justUpdatePointCloud,
+                          unsigned pointsToSkip,
+                          const PointCloudCallback& callback) override;
+  void GetPickingPointAndPlaneInPointCloudAsync(
+      float x,
+      float y,
+      const PickingPointAndPlaneCallback& callback) override;
+  void GetPickingPointsAndPlanesInPointCloudAsync(
+      const std::vector<float>& coordinates,
+      const PickingPointsAndPlanesCallback& callback) override;
+  void GetADFsAsync(const ADFsCallback& callback) override;
+  void ConfigureSensors(mojom::VRSensorConfigurationPtr configuration,
+                        const ConfigureSensorsCallback& callback) override;
+
+  // tango_chromium::TangoBackendListener, called on the Tango threads.
+  void onPointCloudAvailable(double timestamp) override;
+  void onCameraFrameAvailable() override;
+  void onTrackingStateChanged(bool tracking) override;
+  void onCameraIntrinsicsChanged() override;
+  void onConnectionStateChanged(tango_chromium::TangoConnectionState state,
+                                const std::string& error) override;
+
   void RequestPresent(const base::Callback<void(bool)>& callback) override;
   void SetSecureOrigin(bool secure_origin) override;
   void ExitPresent() override;
-  void SubmitFrame(mojom::VRPosePtr pose) override;
+  void SubmitFrame(mojom::VRFrameMetadataPtr metadata) override;
   void UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
                          mojom::VRLayerBoundsPtr right_bounds) override;
 
  private:
+  // Turns off the sensor streams the pages stopped using, even when they
+  // do not request poses anymore.
+  void UpdateSensors();
+  void OnCameraIntrinsicsChanged();
+  void OnConnectionStateChanged(tango_chromium::TangoConnectionState state);
+
+  // Returns the reason the configuration was rejected, empty on success.
+  std::string ConfigureSensorsOnWorkerThread(
+      mojom::VRSensorConfigurationPtr configuration);
+
   TangoCoordinateFramePair tangoCoordinateFramePair;  
   TangoVRDeviceProvider* tangoVRDeviceProvider;
+  tango_chromium::TangoBackend* tangoBackend;
+  // Set from the start of a connection until the first valid pose, which is
+  // traced as TangoVRDevice::TimeToFirstPose.
+  bool waitingForFirstPose;
+  // Runs the point cloud, picking and ADF work in order so it never delays
+  // the poses.
+  base::Thread workerThread;
+  base::RepeatingTimer sensorTimer;
+
+  // The point cloud and picking results are shared by all the displays of the
+  // device: they are only calculated once per point cloud and camera frame no
+  // matter how many pages ask for them. Guarded by cacheLock, which is only
+  // held to look up and fill the cache, not while the results are calculated.
+  base::Lock cacheLock;
+  uint32_t cachedPointCloudGeneration;
+  // Keyed by (justUpdatePointCloud, pointsToSkip).
+  std::map<std::pair<bool, unsigned>, mojom::VRPointCloudPtr> cachedPointClouds;
+  uint32_t cachedPickingPointCloudGeneration;
+  uint32_t cachedPickingCameraFrameId;
+  // Keyed by the normalized (x, y) picking position.
+  std::map<std::pair<float, float>, mojom::VRPickingPointAndPlanePtr>
+      cachedPickingPointsAndPlanes;
+  // Incremented when the sensors are configured so the results calculated
+  // with the previous configuration are not cached.
+  uint32_t cacheInvalidations;
+  int pointCloudCacheHits;
+  int pointCloudCacheMisses;
+  int pickingCacheHits;
+  int pickingCacheMisses;
+  // The thread the device lives in, the pushed notifications are forwarded
+  // to it.
+  scoped_refptr<base::SingleThreadTaskRunner> taskRunner;
+  base::WeakPtr<TangoVRDevice> weakThis;
+
+  base::WeakPtrFactory<TangoVRDevice> weakPtrFactory;
 
   DISALLOW_COPY_AND_ASSIGN(TangoVRDevice);
 };
@@ -25,4 +25,8 @@ void TangoVRDeviceProvider::Initialize() {
   }
 }
 
+bool TangoVRDeviceProvider::SupportsEventPush() {
+  return true;
+}
+
 }  // namespace device
@@ -21,6 +21,8 @@ class TangoVRDeviceProvider : public VRDeviceProvider {
 
   void GetDevices(std::vector<VRDevice*>* devices) override;
   void Initialize() override;
+  // The Tango device is always there and pushes its own state changes.
+  bool SupportsEventPush() override;
 
  private:
   std::unique_ptr<VRDevice> tango_device_;
@@ -0,0 +1,248 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "device/vr/android/tango/tango_vr_device.h"
+
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#include "TangoReplayBackend.h"
+
+using tango_chromium::TangoReplayBackend;
+using tango_chromium::TangoSensorConfiguration;
+
+namespace device {
+
+namespace {
+
+const unsigned kMaxNumberOfPoints = 16;
+
+// A connected backend that serves made up point clouds and pickings and
+// counts how many times they are calculated. The points and the picked
+// point hold the point cloud generation they were calculated for.
+class FakeTangoBackend : public TangoReplayBackend {
+ public:
+  FakeTangoBackend()
+      : point_cloud_generation_(1),
+        camera_frame_id_(1),
+        new_point_cloud_during_request_(false),
+        number_of_point_cloud_requests_(0),
+        number_of_picking_requests_(0) {}
+
+  bool isConnected() const override { return true; }
+
+  unsigned getMaxNumberOfPointsInPointCloud() const override {
+    return kMaxNumberOfPoints;
+  }
+
+  uint32_t getPointCloudGeneration() const override {
+    return point_cloud_generation_;
+  }
+
+  uint32_t getLatestCameraFrameId() const override { return camera_frame_id_; }
+
+  bool getPointCloud(uint32_t* numberOfPoints,
+                     float* points,
+                     unsigned maxNumberOfPoints,
+                     bool justUpdatePointCloud,
+                     unsigned pointsToSkip) override {
+    number_of_point_cloud_requests_++;
+    *numberOfPoints = 0;
+    if (!justUpdatePointCloud) {
+      // Fewer points are returned the more points are skipped.
+      *numberOfPoints = maxNumberOfPoints / (pointsToSkip + 1);
+      for (unsigned i = 0; i < *numberOfPoints * 3; i++)
+        points[i] = point_cloud_generation_;
+    }
+    if (new_point_cloud_during_request_)
+      point_cloud_generation_++;
+    return true;
+  }
+
+  bool getPickingPointAndPlaneInPointCloud(float x,
+                                           float y,
+                                           double* point,
+                                           double* plane) override {
+    number_of_picking_requests_++;
+    point[0] = x;
+    point[1] = y;
+    point[2] = point_cloud_generation_;
+    plane[0] = plane[1] = plane[3] = 0.0;
+    plane[2] = 1.0;
+    return true;
+  }
+
+  bool configureSensors(const TangoSensorConfiguration& configuration,
+                        std::string* error) override {
+    return true;
+  }
+
+  void set_point_cloud_generation(uint32_t generation) {
+    point_cloud_generation_ = generation;
+  }
+  void set_camera_frame_id(uint32_t camera_frame_id) {
+    camera_frame_id_ = camera_frame_id;
+  }
+  // Simulates a new point cloud arriving while one is retrieved.
+  void set_new_point_cloud_during_request(bool new_point_cloud) {
+    new_point_cloud_during_request_ = new_point_cloud;
+  }
+
+  int number_of_point_cloud_requests() const {
+    return number_of_point_cloud_requests_;
+  }
+  int number_of_picking_requests() const { return number_of_picking_requests_; }
+
+ private:
+  uint32_t point_cloud_generation_;
+  uint32_t camera_frame_id_;
+  bool new_point_cloud_during_request_;
+  int number_of_point_cloud_requests_;
+  int number_of_picking_requests_;
+};
+
+void OnSensorsConfigured(const base::Closure& quit_closure,
+                         bool success,
+                         const std::string& error) {
+  EXPECT_TRUE(success) << error;
+  quit_closure.Run();
+}
+
+}  // namespace
+
+// The point cloud and picking results are shared by all the displays of the
+// device, these tests check when they are reused.
+class TangoVRDeviceTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    device_.reset(new TangoVRDevice(nullptr, &backend_));
+  }
+
+  void TearDown() override { device_.reset(); }
+
+  void ConfigureSensors() {
+    mojom::VRSensorConfigurationPtr configuration =
+        mojom::VRSensorConfiguration::New();
+    configuration->depthFramerate = 5;
+    base::RunLoop run_loop;
+    device_->ConfigureSensors(
+        std::move(configuration),
+        base::Bind(&OnSensorsConfigured, run_loop.QuitClosure()));
+    run_loop.Run();
+  }
+
+  base::MessageLoop message_loop_;
+  FakeTangoBackend backend_;
+  std::unique_ptr<TangoVRDevice> device_;
+};
+
+TEST_F(TangoVRDeviceTest, PointCloudCacheHit) {
+  mojom::VRPointCloudPtr first = device_->GetPointCloud(false, 0);
+  mojom::VRPointCloudPtr second = device_->GetPointCloud(false, 0);
+  EXPECT_EQ(1, backend_.number_of_point_cloud_requests());
+  ASSERT_FALSE(first.is_null());
+  ASSERT_FALSE(second.is_null());
+  EXPECT_EQ(kMaxNumberOfPoints, second->numberOfPoints);
+  EXPECT_EQ(first->points, second->points);
+}
+
+TEST_F(TangoVRDeviceTest, PointCloudCacheInvalidatedByNewPointCloud) {
+  device_->GetPointCloud(false, 0);
+  backend_.set_point_cloud_generation(2);
+  mojom::VRPointCloudPtr point_cloud = device_->GetPointCloud(false, 0);
+  EXPECT_EQ(2, backend_.number_of_point_cloud_requests());
+  ASSERT_FALSE(point_cloud.is_null());
+  EXPECT_EQ(2.0f, point_cloud->points[0]);
+}
+
+TEST_F(TangoVRDeviceTest, PointCloudCacheInvalidatedByConfiguration) {
+  device_->GetPointCloud(false, 0);
+  ConfigureSensors();
+  device_->GetPointCloud(false, 0);
+  EXPECT_EQ(2, backend_.number_of_point_cloud_requests());
+}
+
+TEST_F(TangoVRDeviceTest, PointCloudCacheKeys) {
+  mojom::VRPointCloudPtr all_points = device_->GetPointCloud(false, 0);
+  mojom::VRPointCloudPtr half_points = device_->GetPointCloud(false, 1);
+  mojom::VRPointCloudPtr no_points = device_->GetPointCloud(true, 0);
+  EXPECT_EQ(3, backend_.number_of_point_cloud_requests());
+  ASSERT_FALSE(all_points.is_null());
+  ASSERT_FALSE(half_points.is_null());
+  EXPECT_EQ(kMaxNumberOfPoints, all_points->numberOfPoints);
+  EXPECT_EQ(kMaxNumberOfPoints / 2, half_points->numberOfPoints);
+  EXPECT_TRUE(no_points.is_null());
+
+  // Each request gets the result of its own parameters back.
+  EXPECT_EQ(kMaxNumberOfPoints,
+            device_->GetPointCloud(false, 0)->numberOfPoints);
+  EXPECT_EQ(kMaxNumberOfPoints / 2,
+            device_->GetPointCloud(false, 1)->numberOfPoints);
+  EXPECT_TRUE(device_->GetPointCloud(true, 0).is_null());
+  EXPECT_EQ(3, backend_.number_of_point_cloud_requests());
+}
+
+TEST_F(TangoVRDeviceTest, PointCloudNotCachedWhenNewPointCloudDuringRequest) {
+  // The point cloud retrieved can belong to either generation.
+  backend_.set_new_point_cloud_during_request(true);
+  device_->GetPointCloud(false, 0);
+  backend_.set_new_point_cloud_during_request(false);
+  mojom::VRPointCloudPtr point_cloud = device_->GetPointCloud(false, 0);
+  EXPECT_EQ(2, backend_.number_of_point_cloud_requests());
+  ASSERT_FALSE(point_cloud.is_null());
+  EXPECT_EQ(2.0f, point_cloud->points[0]);
+
+  device_->GetPointCloud(false, 0);
+  EXPECT_EQ(2, backend_.number_of_point_cloud_requests());
+}
+
+TEST_F(TangoVRDeviceTest, PickingCacheHit) {
+  device_->GetPickingPointAndPlaneInPointCloud(0.25f, 0.75f);
+  mojom::VRPickingPointAndPlanePtr point_and_plane =
+      device_->GetPickingPointAndPlaneInPointCloud(0.25f, 0.75f);
+  EXPECT_EQ(1, backend_.number_of_picking_requests());
+  ASSERT_FALSE(point_and_plane.is_null());
+  EXPECT_EQ(0.25, point_and_plane->point[0]);
+  EXPECT_EQ(0.75, point_and_plane->point[1]);
+}
+
+TEST_F(TangoVRDeviceTest, PickingCacheInvalidated) {
+  device_->GetPickingPointAndPlaneInPointCloud(0.25f, 0.75f);
+  backend_.set_camera_frame_id(2);
+  device_->GetPickingPointAndPlaneInPointCloud(0.25f, 0.75f);
+  EXPECT_EQ(2, backend_.number_of_picking_requests());
+
+  backend_.set_point_cloud_generation(2);
+  mojom::VRPickingPointAndPlanePtr point_and_plane =
+      device_->GetPickingPointAndPlaneInPointCloud(0.25f, 0.75f);
+  EXPECT_EQ(3, backend_.number_of_picking_requests());
+  ASSERT_FALSE(point_and_plane.is_null());
+  EXPECT_EQ(2.0, point_and_plane->point[2]);
+
+  ConfigureSensors();
+  device_->GetPickingPointAndPlaneInPointCloud(0.25f, 0.75f);
+  EXPECT_EQ(4, backend_.number_of_picking_requests());
+}
+
+TEST_F(TangoVRDeviceTest, PickingCacheKeys) {
+  device_->GetPickingPointAndPlaneInPointCloud(0.25f, 0.75f);
+  mojom::VRPickingPointAndPlanePtr swapped =
+      device_->GetPickingPointAndPlaneInPointCloud(0.75f, 0.25f);
+  EXPECT_EQ(2, backend_.number_of_picking_requests());
+  ASSERT_FALSE(swapped.is_null());
+  EXPECT_EQ(0.75, swapped->point[0]);
+  EXPECT_EQ(0.25, swapped->point[1]);
+
+  mojom::VRPickingPointAndPlanePtr point_and_plane =
+      device_->GetPickingPointAndPlaneInPointCloud(0.25f, 0.75f);
+  EXPECT_EQ(2, backend_.number_of_picking_requests());
+  EXPECT_EQ(0.25, point_and_plane->point[0]);
+}
+
+}  // namespace device
@@ -4,16 +4,44 @@
 
 #include "device/vr/test/fake_vr_device.h"
 
+#include "base/bind.h"
+#include "base/task_runner_util.h"
+
 namespace device {
 
-FakeVRDevice::FakeVRDevice() {
+namespace {
+
+mojom::VRPointCloudPtr WaitForPointCloud(base::WaitableEvent* held,
+                                         base::WaitableEvent* released,
+                                         mojom::VRPointCloudPtr point_cloud) {
+  held->Signal();
+  released->Wait();
+  return point_cloud;
+}
+
+}  // namespace
+
+FakeVRDevice::FakeVRDevice()
+    : hold_point_cloud_requests_(false),
+      point_cloud_request_held_(
+          base::WaitableEvent::ResetPolicy::AUTOMATIC,
+          base::WaitableEvent::InitialState::NOT_SIGNALED),
+      point_cloud_requests_released_(
+          base::WaitableEvent::ResetPolicy::MANUAL,
+          base::WaitableEvent::InitialState::NOT_SIGNALED),
+      point_cloud_thread_("FakeVRDevicePointCloud") {
   device_ = mojom::VRDisplayInfo::New();
   pose_ = mojom::VRPose::New();
+  point_cloud_ = mojom::VRPointCloud::New();
 
   InitBasicDevice();
 }
 
-FakeVRDevice::~FakeVRDevice() {}
+FakeVRDevice::~FakeVRDevice() {
+  // Do not leave the worker waiting forever.
+  point_cloud_requests_released_.Signal();
+  point_cloud_thread_.Stop();
+}
 
 void FakeVRDevice::InitBasicDevice() {
   device_->index = id();
@@ -68,8 +96,77 @@ mojom::VRPosePtr FakeVRDevice::GetPose() {
   return pose_.Clone();
 }
 
+void FakeVRDevice::SetPointCloud(const mojom::VRPointCloudPtr& point_cloud) {
+  point_cloud_ = point_cloud.Clone();
+}
+
+void FakeVRDevice::HoldPointCloudRequests() {
+  if (!point_cloud_thread_.IsRunning())
+    point_cloud_thread_.Start();
+  point_cloud_requests_released_.Reset();
+  hold_point_cloud_requests_ = true;
+}
+
+void FakeVRDevice::ReleasePointCloudRequests() {
+  hold_point_cloud_requests_ = false;
+  point_cloud_requests_released_.Signal();
+}
+
+void FakeVRDevice::WaitForHeldPointCloudRequest() {
+  point_cloud_request_held_.Wait();
+}
+
 void FakeVRDevice::ResetPose() {}
 
+unsigned FakeVRDevice::GetMaxNumberOfPointsInPointCloud() {
+  return point_cloud_->numberOfPoints;
+}
+
+mojom::VRPointCloudPtr FakeVRDevice::GetPointCloud(bool justUpdatePointCloud,
+                                                   unsigned pointsToSkip) {
+  return justUpdatePointCloud ? nullptr : point_cloud_.Clone();
+}
+
+mojom::VRSeeThroughCameraPtr FakeVRDevice::GetSeeThroughCamera() {
+  return nullptr;
+}
+
+mojom::VRPickingPointAndPlanePtr
+FakeVRDevice::GetPickingPointAndPlaneInPointCloud(float x, float y) {
+  // Only the positions inside the screen hit the fake floor plane.
+  if (x < 0.0f || x > 1.0f || y < 0.0f || y > 1.0f)
+    return nullptr;
+  mojom::VRPickingPointAndPlanePtr pointAndPlane =
+      mojom::VRPickingPointAndPlane::New();
+  pointAndPlane->point = {x, y, -1.0};
+  pointAndPlane->plane = {0.0, 0.0, 1.0, 1.0};
+  return pointAndPlane;
+}
+
+std::vector<mojom::VRADFPtr> FakeVRDevice::GetADFs() {
+  return std::vector<mojom::VRADFPtr>();
+}
+
+void FakeVRDevice::EnableADF(const std::string& uuid) {}
+
+void FakeVRDevice::DisableADF() {}
+
+void FakeVRDevice::GetPointCloudAsync(bool justUpdatePointCloud,
+                                      unsigned pointsToSkip,
+                                      const PointCloudCallback& callback) {
+  if (!hold_point_cloud_requests_) {
+    VRDevice::GetPointCloudAsync(justUpdatePointCloud, pointsToSkip, callback);
+    return;
+  }
+  base::PostTaskAndReplyWithResult(
+      point_cloud_thread_.task_runner().get(), FROM_HERE,
+      base::Bind(&WaitForPointCloud, &point_cloud_request_held_,
+                 &point_cloud_requests_released_,
+                 base::Passed(GetPointCloud(justUpdatePointCloud,
+                                            pointsToSkip))),
+      callback);
+}
+
 void FakeVRDevice::RequestPresent(const base::Callback<void(bool)>& callback) {
   callback.Run(true);
 }
@@ -80,7 +177,9 @@ void FakeVRDevice::ExitPresent() {
   OnExitPresent();
 }
 
-void FakeVRDevice::SubmitFrame(mojom::VRPosePtr pose) {}
+void FakeVRDevice::SubmitFrame(mojom::VRFrameMetadataPtr metadata) {
+  submitted_frame_ = std::move(metadata);
+}
 
 void FakeVRDevice::UpdateLayerBounds(mojom::VRLayerBoundsPtr leftBounds,
                                      mojom::VRLayerBoundsPtr rightBounds) {}
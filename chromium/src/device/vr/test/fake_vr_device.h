@@ -7,6 +7,8 @@
 
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
 #include "device/vr/vr_device.h"
 #include "device/vr/vr_device_provider.h"
 #include "device/vr/vr_service_impl.h"
@@ -22,15 +24,42 @@ class FakeVRDevice : public VRDevice {
 
   void SetVRDevice(const mojom::VRDisplayInfoPtr& device);
   void SetPose(const mojom::VRPosePtr& state);
+  void SetPointCloud(const mojom::VRPointCloudPtr& point_cloud);
+
+  // Simulates a device busy computing point clouds: the asynchronous point
+  // cloud requests wait on a worker thread until they are released.
+  void HoldPointCloudRequests();
+  void ReleasePointCloudRequests();
+  // Waits until a held request is blocked on the worker thread.
+  void WaitForHeldPointCloudRequest();
+
+  // The metadata of the last submitted frame, null if none.
+  const mojom::VRFrameMetadataPtr& submitted_frame() const {
+    return submitted_frame_;
+  }
 
   mojom::VRDisplayInfoPtr GetVRDevice() override;
   mojom::VRPosePtr GetPose() override;
   void ResetPose() override;
+  unsigned GetMaxNumberOfPointsInPointCloud() override;
+  mojom::VRPointCloudPtr GetPointCloud(bool justUpdatePointCloud,
+                                       unsigned pointsToSkip) override;
+  mojom::VRSeeThroughCameraPtr GetSeeThroughCamera() override;
+  mojom::VRPickingPointAndPlanePtr GetPickingPointAndPlaneInPointCloud(
+      float x,
+      float y) override;
+  std::vector<mojom::VRADFPtr> GetADFs() override;
+  void EnableADF(const std::string& uuid) override;
+  void DisableADF() override;
+
+  void GetPointCloudAsync(bool justUpdatePointCloud,
+                          unsigned pointsToSkip,
+                          const PointCloudCallback& callback) override;
 
   void RequestPresent(const base::Callback<void(bool)>& callback) override;
   void SetSecureOrigin(bool secure_origin) override;
   void ExitPresent() override;
-  void SubmitFrame(mojom::VRPosePtr pose) override;
+  void SubmitFrame(mojom::VRFrameMetadataPtr metadata) override;
   void UpdateLayerBounds(mojom::VRLayerBoundsPtr leftBounds,
                          mojom::VRLayerBoundsPtr rightBounds) override;
 
@@ -39,6 +68,13 @@ class FakeVRDevice : public VRDevice {
 
   mojom::VRDisplayInfoPtr device_;
   mojom::VRPosePtr pose_;
+  mojom::VRPointCloudPtr point_cloud_;
+  mojom::VRFrameMetadataPtr submitted_frame_;
+
+  bool hold_point_cloud_requests_;
+  base::WaitableEvent point_cloud_request_held_;
+  base::WaitableEvent point_cloud_requests_released_;
+  base::Thread point_cloud_thread_;
 
   DISALLOW_COPY_AND_ASSIGN(FakeVRDevice);
 };
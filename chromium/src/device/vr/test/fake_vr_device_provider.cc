@@ -8,6 +8,9 @@ namespace device {
 
 FakeVRDeviceProvider::FakeVRDeviceProvider() : VRDeviceProvider() {
   initialized_ = false;
+  supports_event_push_ = false;
+  has_pending_event_ = false;
+  number_of_polls_ = 0;
 }
 
 FakeVRDeviceProvider::~FakeVRDeviceProvider() {}
@@ -37,4 +40,23 @@ void FakeVRDeviceProvider::Initialize() {
   initialized_ = true;
 }
 
+void FakeVRDeviceProvider::SimulateDevicesChanged() {
+  if (supports_event_push_)
+    OnDevicesChanged();
+  else
+    has_pending_event_ = true;
+}
+
+bool FakeVRDeviceProvider::SupportsEventPush() {
+  return supports_event_push_;
+}
+
+void FakeVRDeviceProvider::PollEvents() {
+  number_of_polls_++;
+  if (has_pending_event_) {
+    has_pending_event_ = false;
+    OnDevicesChanged();
+  }
+}
+
 }  // namespace device
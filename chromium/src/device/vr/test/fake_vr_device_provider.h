@@ -22,12 +22,25 @@ class FakeVRDeviceProvider : public VRDeviceProvider {
   void RemoveDevice(std::unique_ptr<VRDevice> device);
   bool IsInitialized() { return initialized_; }
 
+  // Whether the provider pushes its events or waits to be polled.
+  void SetSupportsEventPush(bool supports_event_push) {
+    supports_event_push_ = supports_event_push;
+  }
+  // Signals that the devices changed, either right away or on the next poll.
+  void SimulateDevicesChanged();
+  int number_of_polls() const { return number_of_polls_; }
+
   void GetDevices(std::vector<VRDevice*>* devices) override;
   void Initialize() override;
+  bool SupportsEventPush() override;
+  void PollEvents() override;
 
  private:
   std::vector<std::unique_ptr<VRDevice>> devices_;
   bool initialized_;
+  bool supports_event_push_;
+  bool has_pending_event_;
+  int number_of_polls_;
 };
 
 }  // namespace device
@@ -22,4 +22,16 @@ void FakeVRDisplayImplClient::OnChanged(mojom::VRDisplayInfoPtr display) {
   service_client_->SetLastDeviceId(display->index);
 }
 
+void FakeVRDisplayImplClient::OnPointCloudAvailable(double timestamp) {
+  service_client_->AddPointCloudNotification();
+}
+
+void FakeVRDisplayImplClient::OnCameraFrameAvailable() {
+  service_client_->AddCameraFrameNotification();
+}
+
+void FakeVRDisplayImplClient::OnTrackingStateChanged(bool tracking) {
+  service_client_->AddTrackingStateNotification();
+}
+
 }  // namespace device
@@ -25,6 +25,9 @@ class FakeVRDisplayImplClient : public mojom::VRDisplayClient {
   void OnFocus() override {}
   void OnActivate(mojom::VRDisplayEventReason reason) override {}
   void OnDeactivate(mojom::VRDisplayEventReason reason) override {}
+  void OnPointCloudAvailable(double timestamp) override;
+  void OnCameraFrameAvailable() override;
+  void OnTrackingStateChanged(bool tracking) override;
 
  private:
   FakeVRServiceClient* service_client_;
@@ -8,7 +8,10 @@
 namespace device {
 
 FakeVRServiceClient::FakeVRServiceClient(mojom::VRServiceClientRequest request)
-    : m_binding_(this, std::move(request)) {}
+    : number_of_point_cloud_notifications_(0),
+      number_of_camera_frame_notifications_(0),
+      number_of_tracking_state_notifications_(0),
+      m_binding_(this, std::move(request)) {}
 
 FakeVRServiceClient::~FakeVRServiceClient() {}
 
@@ -31,4 +34,16 @@ bool FakeVRServiceClient::CheckDeviceId(unsigned int id) {
   return id == last_device_id_;
 }
 
+void FakeVRServiceClient::AddPointCloudNotification() {
+  number_of_point_cloud_notifications_++;
+}
+
+void FakeVRServiceClient::AddCameraFrameNotification() {
+  number_of_camera_frame_notifications_++;
+}
+
+void FakeVRServiceClient::AddTrackingStateNotification() {
+  number_of_tracking_state_notifications_++;
+}
+
 }  // namespace device
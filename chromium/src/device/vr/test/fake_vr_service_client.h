@@ -23,11 +23,27 @@ class FakeVRServiceClient : public mojom::VRServiceClient {
                           mojom::VRDisplayInfoPtr displayInfo) override;
   void SetLastDeviceId(unsigned int id);
   bool CheckDeviceId(unsigned int id);
+  void AddPointCloudNotification();
+  void AddCameraFrameNotification();
+  void AddTrackingStateNotification();
+  size_t number_of_displays() const { return displays_.size(); }
+  int number_of_point_cloud_notifications() const {
+    return number_of_point_cloud_notifications_;
+  }
+  int number_of_camera_frame_notifications() const {
+    return number_of_camera_frame_notifications_;
+  }
+  int number_of_tracking_state_notifications() const {
+    return number_of_tracking_state_notifications_;
+  }
 
  private:
   std::vector<mojom::VRDisplayInfoPtr> displays_;
   std::vector<FakeVRDisplayImplClient*> display_clients_;
   unsigned int last_device_id_;
+  int number_of_point_cloud_notifications_;
+  int number_of_camera_frame_notifications_;
+  int number_of_tracking_state_notifications_;
   mojo::Binding<mojom::VRServiceClient> m_binding_;
 
   DISALLOW_COPY_AND_ASSIGN(FakeVRServiceClient);
@@ -18,6 +18,50 @@ VRDevice::VRDevice() : presenting_display_(nullptr), id_(next_id_) {
 
 VRDevice::~VRDevice() {}
 
+mojom::VRPosePtr VRDevice::GetLatestPose() {
+  return GetPose();
+}
+
+void VRDevice::GetPointCloudAsync(bool justUpdatePointCloud,
+                                  unsigned pointsToSkip,
+                                  const PointCloudCallback& callback) {
+  callback.Run(GetPointCloud(justUpdatePointCloud, pointsToSkip));
+}
+
+void VRDevice::GetPickingPointAndPlaneInPointCloudAsync(
+    float x,
+    float y,
+    const PickingPointAndPlaneCallback& callback) {
+  callback.Run(GetPickingPointAndPlaneInPointCloud(x, y));
+}
+
+std::vector<mojom::VRPickingPointAndPlanePtr>
+VRDevice::GetPickingPointsAndPlanesInPointCloud(
+    const std::vector<float>& coordinates) {
+  std::vector<mojom::VRPickingPointAndPlanePtr> pointsAndPlanes(
+      coordinates.size() / 2);
+  for (size_t i = 0; i < pointsAndPlanes.size(); i++) {
+    pointsAndPlanes[i] = GetPickingPointAndPlaneInPointCloud(
+        coordinates[2 * i], coordinates[2 * i + 1]);
+  }
+  return pointsAndPlanes;
+}
+
+void VRDevice::GetPickingPointsAndPlanesInPointCloudAsync(
+    const std::vector<float>& coordinates,
+    const PickingPointsAndPlanesCallback& callback) {
+  callback.Run(GetPickingPointsAndPlanesInPointCloud(coordinates));
+}
+
+void VRDevice::GetADFsAsync(const ADFsCallback& callback) {
+  callback.Run(GetADFs());
+}
+
+void VRDevice::ConfigureSensors(mojom::VRSensorConfigurationPtr configuration,
+                                const ConfigureSensorsCallback& callback) {
+  callback.Run(false, "The sensors of this VRDisplay cannot be configured.");
+}
+
 void VRDevice::RequestPresent(const base::Callback<void(bool)>& callback) {
   callback.Run(true);
 }
@@ -79,6 +123,23 @@ void VRDevice::OnDeactivate(mojom::VRDisplayEventReason reason) {
     display->client()->OnDeactivate(reason);
 }
 
+void VRDevice::OnPointCloudAvailable(double timestamp) {
+  // Each display filters the notification based on its subscription.
+  for (const auto& display : displays_)
+    display->OnPointCloudAvailable(timestamp);
+}
+
+void VRDevice::OnCameraFrameAvailable() {
+  for (const auto& display : displays_)
+    display->OnCameraFrameAvailable();
+}
+
+void VRDevice::OnTrackingStateChanged(bool tracking) {
+  // Each display checks whether it has access to the device.
+  for (const auto& display : displays_)
+    display->OnTrackingStateChanged(tracking);
+}
+
 void VRDevice::SetPresentingDisplay(VRDisplayImpl* display) {
   presenting_display_ = display;
 }
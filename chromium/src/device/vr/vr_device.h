@@ -25,19 +25,55 @@ class DEVICE_VR_EXPORT VRDevice {
 
   virtual mojom::VRDisplayInfoPtr GetVRDevice() = 0;
   virtual mojom::VRPosePtr GetPose() = 0;
+  // The latest pose, even if GetPose returns the one of the latest camera
+  // frame. By default the same as GetPose.
+  virtual mojom::VRPosePtr GetLatestPose();
   virtual void ResetPose() = 0;
   virtual unsigned GetMaxNumberOfPointsInPointCloud() = 0;
   virtual mojom::VRPointCloudPtr GetPointCloud(bool justUpdatePointCloud, unsigned pointsToSkip) = 0;
   virtual mojom::VRSeeThroughCameraPtr GetSeeThroughCamera() = 0;
   virtual mojom::VRPickingPointAndPlanePtr GetPickingPointAndPlaneInPointCloud(float x, float y) = 0;
+  // Picks each (x, y) pair in coordinates in order.
+  std::vector<mojom::VRPickingPointAndPlanePtr>
+  GetPickingPointsAndPlanesInPointCloud(const std::vector<float>& coordinates);
   virtual std::vector<mojom::VRADFPtr> GetADFs() = 0;
   virtual void EnableADF(const std::string& uuid) = 0;
   virtual void DisableADF() = 0;
 
+  // The point cloud, picking and ADF queries can take long. Their
+  // asynchronous versions allow a device to run them away from the thread
+  // that serves the displays so GetPose is never queued behind them. The
+  // callbacks are run on the calling sequence. By default the synchronous
+  // versions are run inline.
+  using PointCloudCallback = base::Callback<void(mojom::VRPointCloudPtr)>;
+  using PickingPointAndPlaneCallback =
+      base::Callback<void(mojom::VRPickingPointAndPlanePtr)>;
+  using PickingPointsAndPlanesCallback =
+      base::Callback<void(std::vector<mojom::VRPickingPointAndPlanePtr>)>;
+  using ADFsCallback = base::Callback<void(std::vector<mojom::VRADFPtr>)>;
+  virtual void GetPointCloudAsync(bool justUpdatePointCloud,
+                                  unsigned pointsToSkip,
+                                  const PointCloudCallback& callback);
+  virtual void GetPickingPointAndPlaneInPointCloudAsync(
+      float x,
+      float y,
+      const PickingPointAndPlaneCallback& callback);
+  virtual void GetPickingPointsAndPlanesInPointCloudAsync(
+      const std::vector<float>& coordinates,
+      const PickingPointsAndPlanesCallback& callback);
+  virtual void GetADFsAsync(const ADFsCallback& callback);
+
+  // Runs the callback with false and the reason if the configuration is not
+  // supported. By default no configuration is.
+  using ConfigureSensorsCallback =
+      base::Callback<void(bool, const std::string&)>;
+  virtual void ConfigureSensors(mojom::VRSensorConfigurationPtr configuration,
+                                const ConfigureSensorsCallback& callback);
+
   virtual void RequestPresent(const base::Callback<void(bool)>& callback) = 0;
   virtual void SetSecureOrigin(bool secure_origin) = 0;
   virtual void ExitPresent() = 0;
-  virtual void SubmitFrame(mojom::VRPosePtr pose) = 0;
+  virtual void SubmitFrame(mojom::VRFrameMetadataPtr metadata) = 0;
   virtual void UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
                                  mojom::VRLayerBoundsPtr right_bounds) = 0;
 
@@ -53,6 +89,9 @@ class DEVICE_VR_EXPORT VRDevice {
   virtual void OnFocus();
   virtual void OnActivate(mojom::VRDisplayEventReason reason);
   virtual void OnDeactivate(mojom::VRDisplayEventReason reason);
+  virtual void OnPointCloudAvailable(double timestamp);
+  virtual void OnCameraFrameAvailable();
+  virtual void OnTrackingStateChanged(bool tracking);
 
  protected:
   friend class VRDisplayImpl;
@@ -13,6 +13,9 @@
 
 #if defined(OS_ANDROID)
 #include "device/vr/android/gvr/gvr_device_provider.h"
+#endif
+
+#if defined(OS_ANDROID) || defined(OS_LINUX)
 #include "device/vr/android/tango/tango_vr_device_provider.h"
 #endif
 
@@ -30,12 +33,19 @@ VRDeviceManager::VRDeviceManager()
 // Register VRDeviceProviders for the current platform
 #if defined(OS_ANDROID)
   RegisterProvider(base::MakeUnique<GvrDeviceProvider>());
+#endif
+  // On Linux the Tango device replays a recorded session (see
+  // TangoReplayBackend).
+#if defined(OS_ANDROID) || defined(OS_LINUX)
   RegisterProvider(base::MakeUnique<TangoVRDeviceProvider>());
 #endif
 }
 
 VRDeviceManager::VRDeviceManager(std::unique_ptr<VRDeviceProvider> provider)
-    : vr_initialized_(false), keep_alive_(true), has_scheduled_poll_(false) {
+    : vr_initialized_(false),
+      keep_alive_(true),
+      has_scheduled_poll_(false),
+      has_activate_listeners_(false) {
   thread_checker_.DetachFromThread();
   RegisterProvider(std::move(provider));
   SetInstance(this);
@@ -168,17 +178,39 @@ void VRDeviceManager::InitializeProviders() {
   }
 
   vr_initialized_ = true;
+
+  SchedulePollEvents();
 }
 
 void VRDeviceManager::RegisterProvider(
     std::unique_ptr<VRDeviceProvider> provider) {
+  // The providers are owned by the manager so they never outlive it.
+  provider->SetDevicesChangedCallback(base::Bind(
+      &VRDeviceManager::OnDevicesChanged, base::Unretained(this)));
   providers_.push_back(std::move(provider));
 }
 
+void VRDeviceManager::OnDevicesChanged() {
+  DCHECK(thread_checker_.CalledOnValidThread());
+
+  for (auto* service : services_)
+    GetVRDevices(service);
+}
+
 void VRDeviceManager::SchedulePollEvents() {
   if (has_scheduled_poll_)
     return;
 
+  bool needs_polling = false;
+  for (const auto& provider : providers_) {
+    if (!provider->SupportsEventPush()) {
+      needs_polling = true;
+      break;
+    }
+  }
+  if (!needs_polling)
+    return;
+
   has_scheduled_poll_ = true;
 
   timer_.Start(FROM_HERE, base::TimeDelta::FromMilliseconds(500), this,
@@ -186,8 +218,10 @@ void VRDeviceManager::SchedulePollEvents() {
 }
 
 void VRDeviceManager::PollEvents() {
-  for (const auto& provider : providers_)
-    provider->PollEvents();
+  for (const auto& provider : providers_) {
+    if (!provider->SupportsEventPush())
+      provider->PollEvents();
+  }
 }
 
 void VRDeviceManager::StopSchedulingPollEvents() {
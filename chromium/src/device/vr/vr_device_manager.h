@@ -59,6 +59,10 @@ class VRDeviceManager {
   void InitializeProviders();
   void RegisterProvider(std::unique_ptr<VRDeviceProvider> provider);
 
+  // Connects the devices that appeared to every service.
+  void OnDevicesChanged();
+
+  // Only the providers that cannot push their events are polled.
   void SchedulePollEvents();
   void PollEvents();
   void StopSchedulingPollEvents();
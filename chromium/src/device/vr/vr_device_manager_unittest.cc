@@ -12,6 +12,7 @@
 #include "base/memory/ptr_util.h"
 #include "base/message_loop/message_loop.h"
 #include "base/run_loop.h"
+#include "base/test/test_mock_time_task_runner.h"
 #include "device/vr/test/fake_vr_device.h"
 #include "device/vr/test/fake_vr_device_provider.h"
 #include "device/vr/test/fake_vr_service_client.h"
@@ -40,6 +41,30 @@ class VRDeviceManagerTest : public testing::Test {
     return device_manager_->GetDevice(index);
   }
 
+  // Runs the polling timer on a mock clock so a minute can be simulated.
+  scoped_refptr<base::TestMockTimeTaskRunner> MockPollTimer() {
+    scoped_refptr<base::TestMockTimeTaskRunner> task_runner(
+        new base::TestMockTimeTaskRunner());
+    device_manager_->timer_.SetTaskRunner(task_runner);
+    return task_runner;
+  }
+
+  // Adds a device to the provider and returns the simulated time it took for
+  // the client to be told about it.
+  base::TimeDelta ConnectDevice(base::TestMockTimeTaskRunner* task_runner,
+                                FakeVRServiceClient* client) {
+    size_t number_of_displays = client->number_of_displays();
+    provider_->AddDevice(base::MakeUnique<FakeVRDevice>());
+    base::TimeTicks event_time = task_runner->NowTicks();
+    provider_->SimulateDevicesChanged();
+    base::RunLoop().RunUntilIdle();
+    while (client->number_of_displays() == number_of_displays) {
+      task_runner->FastForwardBy(base::TimeDelta::FromMilliseconds(10));
+      base::RunLoop().RunUntilIdle();
+    }
+    return task_runner->NowTicks() - event_time;
+  }
+
  protected:
   base::MessageLoop message_loop_;
   FakeVRDeviceProvider* provider_ = nullptr;
@@ -109,4 +134,43 @@ TEST_F(VRDeviceManagerTest, GetDevicesBasicTest) {
   EXPECT_EQ(device2, GetDevice(device2->id()));
 }
 
+TEST_F(VRDeviceManagerTest, PushedEventsAreNotPolled) {
+  provider_->SetSupportsEventPush(true);
+  scoped_refptr<base::TestMockTimeTaskRunner> task_runner = MockPollTimer();
+
+  mojom::VRServiceClientPtr proxy;
+  FakeVRServiceClient client(mojo::MakeRequest(&proxy));
+  VRServiceImpl service;
+  service.SetClient(std::move(proxy),
+                    base::Bind(&VRDeviceManagerTest::onDisplaySynced,
+                               base::Unretained(this)));
+
+  // The client hears about the device as soon as it is connected...
+  EXPECT_EQ(base::TimeDelta(), ConnectDevice(task_runner.get(), &client));
+
+  // ...and nothing wakes up while nothing changes.
+  task_runner->FastForwardBy(base::TimeDelta::FromMinutes(1));
+  EXPECT_EQ(0, provider_->number_of_polls());
+}
+
+TEST_F(VRDeviceManagerTest, EventsArePolledWhenTheyCannotBePushed) {
+  scoped_refptr<base::TestMockTimeTaskRunner> task_runner = MockPollTimer();
+
+  mojom::VRServiceClientPtr proxy;
+  FakeVRServiceClient client(mojo::MakeRequest(&proxy));
+  VRServiceImpl service;
+  service.SetClient(std::move(proxy),
+                    base::Bind(&VRDeviceManagerTest::onDisplaySynced,
+                               base::Unretained(this)));
+
+  // The device is only seen on the next poll.
+  base::TimeDelta latency = ConnectDevice(task_runner.get(), &client);
+  EXPECT_LT(base::TimeDelta(), latency);
+  EXPECT_GE(base::TimeDelta::FromMilliseconds(500), latency);
+
+  int number_of_polls = provider_->number_of_polls();
+  task_runner->FastForwardBy(base::TimeDelta::FromMinutes(1));
+  EXPECT_EQ(120, provider_->number_of_polls() - number_of_polls);
+}
+
 }  // namespace device
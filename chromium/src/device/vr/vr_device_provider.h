@@ -7,6 +7,8 @@
 
 #include <vector>
 
+#include "base/callback.h"
+
 namespace device {
 
 class VRDevice;
@@ -21,9 +23,31 @@ class VRDeviceProvider {
   // If the VR API requires initialization that should happen here.
   virtual void Initialize() = 0;
 
+  // Providers that can tell when their devices connect or disconnect return
+  // true and call OnDevicesChanged() instead of being polled. The state
+  // changes of a connected device (tracking lost, focus...) are pushed by the
+  // device itself to its displays.
+  virtual bool SupportsEventPush() { return false; }
+
+  // Only called for the providers that do not support pushing their events.
   virtual void PollEvents() {}
 
   virtual void SetListeningForActivate(bool listening) {}
+
+  // Set by the VRDeviceManager when the provider is registered.
+  void SetDevicesChangedCallback(const base::Closure& callback) {
+    devices_changed_callback_ = callback;
+  }
+
+ protected:
+  // Must be called on the thread the VRDeviceManager lives on.
+  void OnDevicesChanged() {
+    if (!devices_changed_callback_.is_null())
+      devices_changed_callback_.Run();
+  }
+
+ private:
+  base::Closure devices_changed_callback_;
 };
 
 }  // namespace device
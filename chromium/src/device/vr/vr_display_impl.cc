@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <utility>
 
 #include "base/bind.h"
@@ -14,6 +15,8 @@ VRDisplayImpl::VRDisplayImpl(device::VRDevice* device, VRServiceImpl* service)
     : binding_(this),
       device_(device),
       service_(service),
+      point_cloud_subscribed_(false),
+      camera_frame_subscribed_(false),
       weak_ptr_factory_(this) {
   mojom::VRDisplayInfoPtr display_info = device->GetVRDevice();
   if (service->client()) {
@@ -43,6 +46,62 @@ void VRDisplayImpl::ResetPose() {
   device_->ResetPose();
 }
 
+void VRDisplayImpl::GetFrameState(mojom::VRFrameStateRequestPtr request,
+                                  const GetFrameStateCallback& callback) {
+  if (!device_->IsAccessAllowed(this)) {
+    callback.Run(nullptr);
+    return;
+  }
+
+  mojom::VRFrameStatePtr frame_state = mojom::VRFrameState::New();
+  frame_state->pose =
+      request->latestPose ? device_->GetLatestPose() : device_->GetPose();
+  frame_state->maxNumberOfPointsInPointCloud =
+      device_->GetMaxNumberOfPointsInPointCloud();
+
+  if (request->pointCloud) {
+    bool justUpdatePointCloud = request->justUpdatePointCloud;
+    unsigned pointsToSkip = request->pointsToSkip;
+    device_->GetPointCloudAsync(
+        justUpdatePointCloud, pointsToSkip,
+        base::Bind(&VRDisplayImpl::OnFrameStatePointCloud,
+                   weak_ptr_factory_.GetWeakPtr(),
+                   base::Passed(&frame_state), base::Passed(&request),
+                   callback));
+    return;
+  }
+
+  OnFrameStatePointCloud(std::move(frame_state), std::move(request), callback,
+                         nullptr);
+}
+
+void VRDisplayImpl::OnFrameStatePointCloud(
+    mojom::VRFrameStatePtr frame_state,
+    mojom::VRFrameStateRequestPtr request,
+    const GetFrameStateCallback& callback,
+    mojom::VRPointCloudPtr point_cloud) {
+  frame_state->pointCloud = std::move(point_cloud);
+
+  if (request->pickingPointAndPlane) {
+    device_->GetPickingPointAndPlaneInPointCloudAsync(
+        request->pickingX, request->pickingY,
+        base::Bind(&VRDisplayImpl::OnFrameStatePickingPointAndPlane,
+                   weak_ptr_factory_.GetWeakPtr(),
+                   base::Passed(&frame_state), callback));
+    return;
+  }
+
+  callback.Run(std::move(frame_state));
+}
+
+void VRDisplayImpl::OnFrameStatePickingPointAndPlane(
+    mojom::VRFrameStatePtr frame_state,
+    const GetFrameStateCallback& callback,
+    mojom::VRPickingPointAndPlanePtr picking_point_and_plane) {
+  frame_state->pickingPointAndPlane = std::move(picking_point_and_plane);
+  callback.Run(std::move(frame_state));
+}
+
 void VRDisplayImpl::GetMaxNumberOfPointsInPointCloud(const GetMaxNumberOfPointsInPointCloudCallback& callback) 
 {
   if (!device_->IsAccessAllowed(this)) {
@@ -59,7 +118,7 @@ void VRDisplayImpl::GetPointCloud(bool justUpdatePointCloud, unsigned pointsToSk
     return;
   }
   
-  callback.Run(device_->GetPointCloud(justUpdatePointCloud, pointsToSkip));  
+  device_->GetPointCloudAsync(justUpdatePointCloud, pointsToSkip, callback);
 }
 
 void VRDisplayImpl::GetPickingPointAndPlaneInPointCloud(float x, float y, const GetPickingPointAndPlaneInPointCloudCallback& callback)
@@ -69,16 +128,18 @@ void VRDisplayImpl::GetPickingPointAndPlaneInPointCloud(float x, float y, const
     return;
   }
 
-  callback.Run(device_->GetPickingPointAndPlaneInPointCloud(x, y));
+  device_->GetPickingPointAndPlaneInPointCloudAsync(x, y, callback);
 }
 
-void VRDisplayImpl::GetSeeThroughCamera(const GetSeeThroughCameraCallback& callback) {
+void VRDisplayImpl::GetPickingPointsAndPlanesInPointCloud(
+    const std::vector<float>& coordinates,
+    const GetPickingPointsAndPlanesInPointCloudCallback& callback) {
   if (!device_->IsAccessAllowed(this)) {
-    callback.Run(nullptr);
+    callback.Run(std::vector<mojom::VRPickingPointAndPlanePtr>());
     return;
   }
 
-  callback.Run(device_->GetSeeThroughCamera());
+  device_->GetPickingPointsAndPlanesInPointCloudAsync(coordinates, callback);
 }
 
 void VRDisplayImpl::GetADFs(const GetADFsCallback& callback) {
@@ -87,7 +148,7 @@ void VRDisplayImpl::GetADFs(const GetADFsCallback& callback) {
     return;
   }
 
-  callback.Run(device_->GetADFs());
+  device_->GetADFsAsync(callback);
 }
 
 void VRDisplayImpl::EnableADF(const std::string& uuid) {
@@ -98,6 +159,55 @@ void VRDisplayImpl::DisableADF() {
   device_->DisableADF();
 }
 
+void VRDisplayImpl::SetPointCloudSubscription(bool subscribed,
+                                              double minimumInterval) {
+  point_cloud_subscribed_ = subscribed;
+  point_cloud_minimum_interval_ =
+      base::TimeDelta::FromSecondsD(std::max(minimumInterval, 0.0));
+}
+
+void VRDisplayImpl::SetCameraFrameSubscription(bool subscribed) {
+  camera_frame_subscribed_ = subscribed;
+}
+
+void VRDisplayImpl::ConfigureSensors(
+    mojom::VRSensorConfigurationPtr configuration,
+    const ConfigureSensorsCallback& callback) {
+  if (!device_->IsAccessAllowed(this)) {
+    callback.Run(false, "Another page is presenting to this VRDisplay.");
+    return;
+  }
+
+  device_->ConfigureSensors(std::move(configuration), callback);
+}
+
+void VRDisplayImpl::OnPointCloudAvailable(double timestamp) {
+  if (!point_cloud_subscribed_ || !device_->IsAccessAllowed(this))
+    return;
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (!last_point_cloud_notification_.is_null() &&
+      now - last_point_cloud_notification_ < point_cloud_minimum_interval_)
+    return;
+
+  last_point_cloud_notification_ = now;
+  client_->OnPointCloudAvailable(timestamp);
+}
+
+void VRDisplayImpl::OnCameraFrameAvailable() {
+  if (!camera_frame_subscribed_ || !device_->IsAccessAllowed(this))
+    return;
+
+  client_->OnCameraFrameAvailable();
+}
+
+void VRDisplayImpl::OnTrackingStateChanged(bool tracking) {
+  if (!device_->IsAccessAllowed(this))
+    return;
+
+  client_->OnTrackingStateChanged(tracking);
+}
+
 void VRDisplayImpl::RequestPresent(bool secure_origin,
                                    const RequestPresentCallback& callback) {
   if (!device_->IsAccessAllowed(this)) {
@@ -125,10 +235,10 @@ void VRDisplayImpl::ExitPresent() {
     device_->ExitPresent();
 }
 
-void VRDisplayImpl::SubmitFrame(mojom::VRPosePtr pose) {
+void VRDisplayImpl::SubmitFrame(mojom::VRFrameMetadataPtr metadata) {
   if (!device_->CheckPresentingDisplay(this))
     return;
-  device_->SubmitFrame(std::move(pose));
+  device_->SubmitFrame(std::move(metadata));
 }
 
 void VRDisplayImpl::UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
@@ -9,6 +9,7 @@
 
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
 #include "device/vr/vr_device.h"
 #include "device/vr/vr_export.h"
 #include "device/vr/vr_service.mojom.h"
@@ -25,29 +26,55 @@ class VRDisplayImpl : public mojom::VRDisplay {
 
   mojom::VRDisplayClient* client() { return client_.get(); }
 
+  // Forwards the notification to the client if it subscribed to it and the
+  // minimum interval since the previous one has elapsed.
+  void OnPointCloudAvailable(double timestamp);
+  // Forwards the notification to the client if it subscribed to it.
+  void OnCameraFrameAvailable();
+  // Forwards the notification to the client if it has access to the device.
+  void OnTrackingStateChanged(bool tracking);
+
  private:
   friend class VRDisplayImplTest;
   friend class VRServiceImpl;
 
   void GetPose(const GetPoseCallback& callback) override;
   void ResetPose() override;
+  void GetFrameState(mojom::VRFrameStateRequestPtr request,
+                     const GetFrameStateCallback& callback) override;
 
   void GetMaxNumberOfPointsInPointCloud(const GetMaxNumberOfPointsInPointCloudCallback& callback) override;
   void GetPointCloud(bool justUpdatePointCloud, unsigned pointsToSkip, const GetPointCloudCallback& callback) override;
   void GetPickingPointAndPlaneInPointCloud(float x, float y, const GetPickingPointAndPlaneInPointCloudCallback& callback) override;
-  void GetSeeThroughCamera(const GetSeeThroughCameraCallback& callback) override;
+  void GetPickingPointsAndPlanesInPointCloud(
+      const std::vector<float>& coordinates,
+      const GetPickingPointsAndPlanesInPointCloudCallback& callback) override;
   void GetADFs(const GetADFsCallback& callback) override;
   void EnableADF(const std::string& uuid) override;
   void DisableADF() override;
+  void SetPointCloudSubscription(bool subscribed,
+                                 double minimumInterval) override;
+  void SetCameraFrameSubscription(bool subscribed) override;
+  void ConfigureSensors(mojom::VRSensorConfigurationPtr configuration,
+                        const ConfigureSensorsCallback& callback) override;
 
   void RequestPresent(bool secure_origin,
                       const RequestPresentCallback& callback) override;
   void ExitPresent() override;
-  void SubmitFrame(mojom::VRPosePtr pose) override;
+  void SubmitFrame(mojom::VRFrameMetadataPtr metadata) override;
 
   void UpdateLayerBounds(mojom::VRLayerBoundsPtr left_bounds,
                          mojom::VRLayerBoundsPtr right_bounds) override;
 
+  void OnFrameStatePointCloud(mojom::VRFrameStatePtr frame_state,
+                              mojom::VRFrameStateRequestPtr request,
+                              const GetFrameStateCallback& callback,
+                              mojom::VRPointCloudPtr point_cloud);
+  void OnFrameStatePickingPointAndPlane(
+      mojom::VRFrameStatePtr frame_state,
+      const GetFrameStateCallback& callback,
+      mojom::VRPickingPointAndPlanePtr picking_point_and_plane);
+
   void RequestPresentResult(const RequestPresentCallback& callback,
                             bool secure_origin,
                             bool success);
@@ -57,6 +84,12 @@ class VRDisplayImpl : public mojom::VRDisplay {
   device::VRDevice* device_;
   VRServiceImpl* service_;
 
+  bool point_cloud_subscribed_;
+  base::TimeDelta point_cloud_minimum_interval_;
+  base::TimeTicks last_point_cloud_notification_;
+
+  bool camera_frame_subscribed_;
+
   base::WeakPtrFactory<VRDisplayImpl> weak_ptr_factory_;
 };
 
@@ -26,6 +26,19 @@ class VRDisplayImplTest : public testing::Test {
   void onPresentComplete(bool success) {
     is_request_presenting_success_ = success;
   }
+  void onPose(mojom::VRPosePtr pose) { number_of_poses_++; }
+  void onPickingPointsAndPlanes(
+      std::vector<mojom::VRPickingPointAndPlanePtr> points_and_planes) {
+    points_and_planes_ = std::move(points_and_planes);
+  }
+  void onFrameState(mojom::VRFrameStatePtr frame_state) {
+    frame_state_ = std::move(frame_state);
+  }
+  void onPointCloud(mojom::VRPointCloudPtr point_cloud) {
+    number_of_point_clouds_++;
+    if (!point_cloud_quit_closure_.is_null())
+      point_cloud_quit_closure_.Run();
+  }
 
  protected:
   void SetUp() override {
@@ -62,6 +75,11 @@ class VRDisplayImplTest : public testing::Test {
 
   base::MessageLoop message_loop_;
   bool is_request_presenting_success_ = false;
+  int number_of_poses_ = 0;
+  int number_of_point_clouds_ = 0;
+  base::Closure point_cloud_quit_closure_;
+  mojom::VRFrameStatePtr frame_state_;
+  std::vector<mojom::VRPickingPointAndPlanePtr> points_and_planes_;
   FakeVRDeviceProvider* provider_;
   FakeVRDevice* device_;
   std::vector<FakeVRServiceClient*> clients_;
@@ -122,4 +140,189 @@ TEST_F(VRDisplayImplTest, DeviceChangedDispatched) {
   for (auto client : clients_)
     EXPECT_TRUE(client->CheckDeviceId(device()->id()));
 }
+
+// Poses must be served while a point cloud request is still being computed
+// by the device.
+TEST_F(VRDisplayImplTest, PoseNotBlockedByPointCloud) {
+  auto service = BindService();
+  VRDisplayImpl* display = service->GetVRDisplayImpl(device());
+
+  device_->HoldPointCloudRequests();
+  display->GetPointCloud(false, 0,
+                         base::Bind(&VRDisplayImplTest::onPointCloud,
+                                    base::Unretained(this)));
+  // The device is now busy with the point cloud until it is released.
+  device_->WaitForHeldPointCloudRequest();
+
+  // Each pose is returned right away, the same as without the point cloud
+  // request.
+  for (int i = 0; i < 10; i++) {
+    display->GetPose(
+        base::Bind(&VRDisplayImplTest::onPose, base::Unretained(this)));
+    EXPECT_EQ(i + 1, number_of_poses_);
+    EXPECT_EQ(0, number_of_point_clouds_);
+  }
+
+  base::RunLoop run_loop;
+  point_cloud_quit_closure_ = run_loop.QuitClosure();
+  device_->ReleasePointCloudRequests();
+  run_loop.Run();
+  EXPECT_EQ(1, number_of_point_clouds_);
+}
+
+// A single GetFrameState call returns the pose along with the requested
+// point cloud.
+TEST_F(VRDisplayImplTest, FrameStateBatchesPoseAndPointCloud) {
+  auto service = BindService();
+  VRDisplayImpl* display = service->GetVRDisplayImpl(device());
+
+  mojom::VRPointCloudPtr point_cloud = mojom::VRPointCloud::New();
+  point_cloud->numberOfPoints = 2;
+  point_cloud->points = std::vector<float>(6, 1.0f);
+  device_->SetPointCloud(point_cloud);
+
+  mojom::VRFrameStateRequestPtr request = mojom::VRFrameStateRequest::New();
+  display->GetFrameState(
+      request.Clone(),
+      base::Bind(&VRDisplayImplTest::onFrameState, base::Unretained(this)));
+  ASSERT_FALSE(frame_state_.is_null());
+  EXPECT_FALSE(frame_state_->pose.is_null());
+  EXPECT_EQ(2u, frame_state_->maxNumberOfPointsInPointCloud);
+  EXPECT_TRUE(frame_state_->pointCloud.is_null());
+  EXPECT_TRUE(frame_state_->pickingPointAndPlane.is_null());
+
+  request->pointCloud = true;
+  display->GetFrameState(
+      std::move(request),
+      base::Bind(&VRDisplayImplTest::onFrameState, base::Unretained(this)));
+  ASSERT_FALSE(frame_state_.is_null());
+  EXPECT_FALSE(frame_state_->pose.is_null());
+  ASSERT_FALSE(frame_state_->pointCloud.is_null());
+  EXPECT_EQ(2u, frame_state_->pointCloud->numberOfPoints);
+}
+
+// Point cloud notifications only reach the displays that subscribed to them,
+// no more often than they asked for.
+TEST_F(VRDisplayImplTest, PointCloudNotificationsFollowSubscription) {
+  auto service_1 = BindService();
+  auto service_2 = BindService();
+
+  VRDisplayImpl* display_1 = service_1->GetVRDisplayImpl(device());
+  VRDisplayImpl* display_2 = service_2->GetVRDisplayImpl(device());
+
+  display_1->SetPointCloudSubscription(true, 0.0);
+  // A minimum interval long enough for the second notification to be
+  // dropped.
+  display_2->SetPointCloudSubscription(true, 3600.0);
+
+  device()->OnPointCloudAvailable(1.0);
+  device()->OnPointCloudAvailable(2.0);
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(2, clients_[0]->number_of_point_cloud_notifications());
+  EXPECT_EQ(1, clients_[1]->number_of_point_cloud_notifications());
+
+  display_1->SetPointCloudSubscription(false, 0.0);
+  device()->OnPointCloudAvailable(3.0);
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(2, clients_[0]->number_of_point_cloud_notifications());
+}
+
+// Camera frame notifications only reach the displays that subscribed to
+// them.
+TEST_F(VRDisplayImplTest, CameraFrameNotificationsFollowSubscription) {
+  auto service_1 = BindService();
+  auto service_2 = BindService();
+
+  VRDisplayImpl* display_1 = service_1->GetVRDisplayImpl(device());
+  service_2->GetVRDisplayImpl(device());
+
+  display_1->SetCameraFrameSubscription(true);
+
+  device()->OnCameraFrameAvailable();
+  device()->OnCameraFrameAvailable();
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(2, clients_[0]->number_of_camera_frame_notifications());
+  EXPECT_EQ(0, clients_[1]->number_of_camera_frame_notifications());
+
+  display_1->SetCameraFrameSubscription(false);
+  device()->OnCameraFrameAvailable();
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(2, clients_[0]->number_of_camera_frame_notifications());
+}
+
+// While a display presents, the tracking state changes only reach it, like
+// the other device data.
+TEST_F(VRDisplayImplTest, TrackingStateNotificationsFollowAccess) {
+  auto service_1 = BindService();
+  auto service_2 = BindService();
+
+  VRDisplayImpl* display_1 = service_1->GetVRDisplayImpl(device());
+  service_2->GetVRDisplayImpl(device());
+
+  device()->OnTrackingStateChanged(true);
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(1, clients_[0]->number_of_tracking_state_notifications());
+  EXPECT_EQ(1, clients_[1]->number_of_tracking_state_notifications());
+
+  RequestPresent(display_1);
+  ASSERT_TRUE(presenting());
+  device()->OnTrackingStateChanged(false);
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(2, clients_[0]->number_of_tracking_state_notifications());
+  EXPECT_EQ(1, clients_[1]->number_of_tracking_state_notifications());
+
+  ExitPresent(display_1);
+}
+
+// A batch of pickings returns one entry per (x, y) pair, in order, with the
+// misses left null.
+TEST_F(VRDisplayImplTest, PickingBatchReturnsOneEntryPerPosition) {
+  auto service = BindService();
+  VRDisplayImpl* display = service->GetVRDisplayImpl(device());
+
+  std::vector<float> coordinates = {0.25f, 0.5f, 2.0f, 0.5f, 0.75f, 1.0f};
+  display->GetPickingPointsAndPlanesInPointCloud(
+      coordinates, base::Bind(&VRDisplayImplTest::onPickingPointsAndPlanes,
+                              base::Unretained(this)));
+  ASSERT_EQ(3u, points_and_planes_.size());
+  ASSERT_FALSE(points_and_planes_[0].is_null());
+  EXPECT_EQ(0.25, points_and_planes_[0]->point[0]);
+  EXPECT_EQ(0.5, points_and_planes_[0]->point[1]);
+  EXPECT_TRUE(points_and_planes_[1].is_null());
+  ASSERT_FALSE(points_and_planes_[2].is_null());
+  EXPECT_EQ(0.75, points_and_planes_[2]->point[0]);
+}
+
+TEST_F(VRDisplayImplTest, SubmitFrameForwardsMetadataOfPresentingDisplay) {
+  auto service_1 = BindService();
+  auto service_2 = BindService();
+  VRDisplayImpl* display_1 = service_1->GetVRDisplayImpl(device());
+  VRDisplayImpl* display_2 = service_2->GetVRDisplayImpl(device());
+
+  RequestPresent(display_1);
+  ASSERT_TRUE(presenting());
+
+  auto metadata = mojom::VRFrameMetadata::New();
+  metadata->poseIndex = 7;
+  metadata->timestamp = 2.0;
+  metadata->syncToken.resize(24, 1);
+  display_1->SubmitFrame(metadata.Clone());
+  ASSERT_FALSE(device_->submitted_frame().is_null());
+  EXPECT_EQ(7u, device_->submitted_frame()->poseIndex);
+  EXPECT_EQ(2.0, device_->submitted_frame()->timestamp);
+  EXPECT_EQ(metadata->syncToken, device_->submitted_frame()->syncToken);
+
+  // The frames of a display that is not presenting are dropped.
+  metadata->poseIndex = 8;
+  display_2->SubmitFrame(std::move(metadata));
+  EXPECT_EQ(7u, device_->submitted_frame()->poseIndex);
+
+  ExitPresent(display_1);
+}
 }
@@ -2470,6 +2470,11 @@ _FUNCTION_INFO = {
     'unit_test': False,
     'client_test': False,
   },
+  'UpdateCameraUnderlay': {
+    'decoder_func': 'DoUpdateCameraUnderlay',
+    'unit_test': False,
+    'client_test': False,
+  },
 #  'UpdateTextureExternalOes': {
 #    'type': 'Bind',
 #    'decoder_func': 'DoUpdateTextureExternalOes',
@@ -2513,6 +2518,20 @@ _FUNCTION_INFO = {
     'data_transfer_methods': ['shm'],
     'trace_level': 2,
   },
+#WebAR BEGIN
+  'BufferSubDataPointCloud': {
+    'decoder_func': 'DoBufferSubDataPointCloud',
+    'unit_test': False,
+    'client_test': False,
+    'trace_level': 2,
+  },
+  'BufferSubDataLatchedPose': {
+    'decoder_func': 'DoBufferSubDataLatchedPose',
+    'unit_test': False,
+    'client_test': False,
+    'trace_level': 2,
+  },
+#WebAR END
   'CheckFramebufferStatus': {
     'type': 'Is',
     'decoder_func': 'DoCheckFramebufferStatus',
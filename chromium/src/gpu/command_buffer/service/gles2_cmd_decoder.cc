@@ -11,10 +11,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
 #include <queue>
+#include <vector>
 
 #include "base/callback.h"
 #include "base/callback_helpers.h"
@@ -86,8 +88,8 @@
 #include "ui/gl/gpu_timing.h"
 
 // WebAR BEGIN
-#include "TangoHandler.h"
-using tango_chromium::TangoHandler;
+#include "TangoBackend.h"
+using tango_chromium::TangoBackend;
 // WebAR END
 
 #if defined(OS_MACOSX)
@@ -190,6 +192,39 @@ bool AnyOtherBitsSet(GLbitfield bits, GLbitfield ref) {
   return ((bits & mask) != 0);
 }
 
+// WebAR: the column major pose matrix (camera to world) followed by the view
+// matrix (world to camera) of a Tango pose, a std140 block of two mat4.
+const size_t kLatchedPoseSize = 32;
+void ComputeLatchedPose(const TangoPoseData& pose, GLfloat* matrices) {
+  double x = pose.orientation[0];
+  double y = pose.orientation[1];
+  double z = pose.orientation[2];
+  double w = pose.orientation[3];
+  double rotation[3][3] = {
+      {1 - 2 * (y * y + z * z), 2 * (x * y - z * w), 2 * (x * z + y * w)},
+      {2 * (x * y + z * w), 1 - 2 * (x * x + z * z), 2 * (y * z - x * w)},
+      {2 * (x * z - y * w), 2 * (y * z + x * w), 1 - 2 * (x * x + y * y)}};
+  GLfloat* poseMatrix = matrices;
+  GLfloat* viewMatrix = matrices + 16;
+  for (int column = 0; column < 3; ++column) {
+    for (int row = 0; row < 3; ++row) {
+      poseMatrix[column * 4 + row] = rotation[row][column];
+      // The inverse of a rotation is its transpose.
+      viewMatrix[column * 4 + row] = rotation[column][row];
+    }
+    poseMatrix[column * 4 + 3] = 0.0f;
+    viewMatrix[column * 4 + 3] = 0.0f;
+  }
+  for (int row = 0; row < 3; ++row) {
+    poseMatrix[12 + row] = pose.translation[row];
+    viewMatrix[12 + row] = -(rotation[0][row] * pose.translation[0] +
+                             rotation[1][row] * pose.translation[1] +
+                             rotation[2][row] * pose.translation[2]);
+  }
+  poseMatrix[15] = 1.0f;
+  viewMatrix[15] = 1.0f;
+}
+
 }  // namespace
 
 class GLES2DecoderImpl;
@@ -1417,7 +1452,9 @@ class GLES2DecoderImpl : public GLES2Decoder, public ErrorStateClient {
   void DoBindTexture(GLenum target, GLuint texture);
 
 // WebAR BEGIN
-  void DoUpdateTextureExternalOes(GLuint client_id);
+  void DoUpdateTextureExternalOes(GLuint client_id, GLuint camera_frame_id);
+  // Chooses the camera frame the embedder draws beneath the web contents.
+  void DoUpdateCameraUnderlay(GLuint camera_frame_id);
 // WebAR END
 
   // Wrapper for glBindSampler since we need to track the current targets.
@@ -1453,6 +1490,17 @@ class GLES2DecoderImpl : public GLES2Decoder, public ErrorStateClient {
   void DoBufferSubData(
     GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid * data);
 
+// WebAR BEGIN
+  // Fills the range of the bound buffer with the latest point cloud so the
+  // points never go through the renderer.
+  void DoBufferSubDataPointCloud(
+    GLenum target, GLintptr offset, GLsizeiptr size);
+  // Writes the pose matrix and the view matrix of the freshest pose into the
+  // bound buffer, as late as possible before the draw calls that use them.
+  void DoBufferSubDataLatchedPose(
+    GLenum target, GLintptr offset, GLboolean camera_frame);
+// WebAR END
+
   // Wrapper for glCheckFramebufferStatus
   GLenum DoCheckFramebufferStatus(GLenum target);
 
@@ -2410,6 +2458,25 @@ class GLES2DecoderImpl : public GLES2Decoder, public ErrorStateClient {
   GLuint validation_fbo_multisample_;
   GLuint validation_fbo_;
 
+  // WebAR: reused by DoBufferSubDataPointCloud to avoid an allocation per
+  // point cloud.
+  std::vector<float> point_cloud_data_;
+  // WebAR: the range of each buffer (by service id) last written by
+  // DoBufferSubDataPointCloud and how many points it holds. Everything after
+  // them in the range is already FLT_MAX, so only the points that are no
+  // longer used have to be moved out of sight again.
+  struct PointCloudRange {
+    GLintptr offset;
+    GLsizeiptr size;
+    uint32_t numberOfPoints;
+  };
+  typedef base::hash_map<GLuint, PointCloudRange> PointCloudRangeMap;
+  PointCloudRangeMap point_cloud_ranges_;
+  // WebAR: the camera frame of the last pose latched by
+  // DoBufferSubDataLatchedPose. The camera commands use it when they are not
+  // given a camera frame so the image matches the latched pose.
+  uint32_t latched_camera_frame_id_;
+
   typedef gpu::gles2::GLES2Decoder::Error (GLES2DecoderImpl::*CmdHandler)(
       uint32_t immediate_data_size,
       const volatile void* data);
@@ -3060,6 +3127,7 @@ GLES2DecoderImpl::GLES2DecoderImpl(ContextGroup* group)
       gpu_debug_commands_(false),
       validation_fbo_multisample_(0),
       validation_fbo_(0),
+      latched_camera_frame_id_(0),
       texture_manager_service_id_generation_(0),
       force_shader_name_hashing_for_test(false) {
   DCHECK(group);
@@ -5282,6 +5350,11 @@ error::Error GLES2DecoderImpl::DoCommands(unsigned int num_commands,
 }
 
 void GLES2DecoderImpl::RemoveBuffer(GLuint client_id) {
+  // WebAR BEGIN
+  Buffer* buffer = GetBuffer(client_id);
+  if (buffer)
+    point_cloud_ranges_.erase(buffer->service_id());
+  // WebAR END
   buffer_manager()->RemoveBuffer(client_id);
 }
 
@@ -5774,77 +5847,60 @@ void GLES2DecoderImpl::DoBindTexture(GLenum target, GLuint client_id) {
 
 // WebAR BEGIN
 
-void GLES2DecoderImpl::DoUpdateTextureExternalOes(GLuint client_id) {
-  TextureRef* texture_ref = NULL;
-  GLuint service_id = 0;
-  if (client_id != 0) {
-    texture_ref = GetTexture(client_id);
-    if (!texture_ref) {
-      if (!group_->bind_generates_resource()) {
-        LOCAL_SET_GL_ERROR(GL_INVALID_OPERATION,
-                           "glUpdateTextureExternalOes",
-                           "id not generated by glGenTextures");
-        return;
-      }
-
-      // It's a new id so make a texture texture for it.
-      glGenTextures(1, &service_id);
-      DCHECK_NE(0u, service_id);
-      CreateTexture(client_id, service_id);
-      texture_ref = GetTexture(client_id);
-    }
+void GLES2DecoderImpl::DoUpdateTextureExternalOes(GLuint client_id,
+                                                  GLuint camera_frame_id) {
+  TextureRef* texture_ref = GetTexture(client_id);
+  if (!texture_ref) {
+    LOCAL_SET_GL_ERROR(GL_INVALID_OPERATION, "glUpdateTextureExternalOes",
+                       "unknown texture");
+    return;
   }
-  // else {
-  //   texture_ref = texture_manager()->GetDefaultTextureInfo(target);
-  // }
-
-  // Check the texture exists
-  if (texture_ref) {
-    Texture* texture = texture_ref->texture();
-    // Check that we are not trying to bind it to a different target.
-    // if (texture->target() != 0 && texture->target() != target) {
-    //   LOCAL_SET_GL_ERROR(GL_INVALID_OPERATION,
-    //                      "glBindTexture",
-    //                      "texture bound to more than 1 target.");
-    //   return;
-    // }
-    LogClientServiceForInfo(texture, client_id, "glUpdateTextureExternalOes");
-
-    glBindTexture(GL_TEXTURE_EXTERNAL_OES, texture->service_id());
-    // There is a GL error after this bind call because the texture was bound
-    // to GL_TEXTURE2D when it was created (remember, WebGL does not support 
-    // the external image texture extension). For now there is no easy way
-    // to resolve this issue as it involves creating a correct handling of
-    // the external texture and maybe copying it to a regular texture 2d.
-    glGetError();
-    TangoHandler::getInstance()->updateCameraImageIntoTexture(texture->service_id());
-    VLOG(0) << "WebAR: The previous error log from Tango cannot be removed for now. There might also be another JS level warning message from the renderer indicating that the used texture index has no texture bound. This is also a known bug in the current WebAR implementation. We are working on trying to resolve these issues. Sorry for the inconveniences with so many log/error messages.";
-
-    // glBindTexture(target, texture->service_id());
-    // if (texture->target() == 0) {
-    //   texture_manager()->SetTarget(texture_ref, target);
-    //   if (!feature_info_->gl_version_info().BehavesLikeGLES() &&
-    //       feature_info_->gl_version_info().IsAtLeastGL(3, 2)) {
-    //     // In Desktop GL core profile and GL ES, depth textures are always
-    //     // sampled to the RED channel, whereas on Desktop GL compatibility
-    //     // proifle, they are sampled to RED, LUMINANCE, INTENSITY, or ALPHA
-    //     // channel, depending on the DEPTH_TEXTURE_MODE value.
-    //     // In theory we only need to apply this for depth textures, but it is
-    //     // simpler to apply to all textures.
-    //     glTexParameteri(target, GL_DEPTH_TEXTURE_MODE, GL_RED);
-    //   }
-    // }
-  }
-  // else {
-  //   glBindTexture(target, 0);
-  // }
-
-  // TextureUnit& unit = state_.texture_units[state_.active_texture_unit];
-  // unit.bind_target = target;
-  // unit.GetInfoForTarget(target) = texture_ref;
-
-  // TODO: This call should not be done. It seems that the Tango codea is giving/leaving a GL error behing so this call is here to clean it up.
-  glGetError();
+  Texture* texture = texture_ref->texture();
+  // A camera texture that has not been bound yet becomes an external one.
+  if (texture->target() == 0)
+    texture_manager()->SetTarget(texture_ref, GL_TEXTURE_EXTERNAL_OES);
+  if (texture->target() != GL_TEXTURE_EXTERNAL_OES) {
+    LOCAL_SET_GL_ERROR(GL_INVALID_OPERATION, "glUpdateTextureExternalOes",
+                       "texture is not an external texture");
+    return;
+  }
+  LogClientServiceForInfo(texture, client_id, "glUpdateTextureExternalOes");
+  TRACE_EVENT1("gpu", "GLES2DecoderImpl::DoUpdateTextureExternalOes",
+               "cameraFrameId", camera_frame_id);
+
+  // The camera frame id comes from the pose the page used for this frame
+  // so the image that is uploaded matches that pose. A page that latches its
+  // pose does not know the frame, the latched one is used.
+  if (camera_frame_id == 0)
+    camera_frame_id = latched_camera_frame_id_;
+  // The backends make their own GL calls, which the decoder does not track.
+  // The errors the page generated before are kept, and the ones the backend
+  // leaves behind are logged and cleared here instead of being reported to
+  // the page by its next getError.
+  LOCAL_COPY_REAL_GL_ERRORS_TO_WRAPPER("glUpdateTextureExternalOes");
+  // The replay backend uploads the image with glTexImage2D, which must not
+  // read from the unpack buffer or use the unpack parameters of the page.
+  state_.PushTextureDecompressionUnpackState();
+  TangoBackend::getInstance()->updateCameraImageIntoTexture(
+      texture->service_id(), camera_frame_id);
+  state_.RestoreUnpackState();
+  LOCAL_CLEAR_REAL_GL_ERRORS("glUpdateTextureExternalOes");
+
+  // The Tango client library binds the texture to the external target of the
+  // active unit, the replay backend to the 2D one.
+  state_.RestoreActiveTextureUnitBinding(GL_TEXTURE_EXTERNAL_OES);
+  state_.RestoreActiveTextureUnitBinding(GL_TEXTURE_2D);
+}
+
+void GLES2DecoderImpl::DoUpdateCameraUnderlay(GLuint camera_frame_id) {
+  TRACE_EVENT1("gpu", "GLES2DecoderImpl::DoUpdateCameraUnderlay",
+               "cameraFrameId", camera_frame_id);
+  // Nothing is drawn here. The command is ordered with the rest of the frame
+  // so the camera frame is the one the page rendered with, the embedder
+  // draws the latest one it was given when it composites.
+  if (camera_frame_id == 0)
+    camera_frame_id = latched_camera_frame_id_;
+  TangoBackend::getInstance()->setCameraUnderlayFrameId(camera_frame_id);
 }
 // WebAR END
 
@@ -12425,17 +12481,134 @@ error::Error GLES2DecoderImpl::HandleBufferData(uint32_t immediate_data_size,
       return error::kOutOfBounds;
     }
   }
+  // WebAR BEGIN
+  // The new data store does not have the point cloud tail in it.
+  Buffer* buffer = buffer_manager()->GetBufferInfoForTarget(&state_, target);
+  if (buffer)
+    point_cloud_ranges_.erase(buffer->service_id());
+  // WebAR END
   buffer_manager()->ValidateAndDoBufferData(&state_, target, size, data, usage);
   return error::kNoError;
 }
 
 void GLES2DecoderImpl::DoBufferSubData(
   GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid * data) {
+  // WebAR BEGIN
+  // The data may overwrite the point cloud tail.
+  if (!point_cloud_ranges_.empty()) {
+    Buffer* buffer = buffer_manager()->GetBufferInfoForTarget(&state_, target);
+    if (buffer)
+      point_cloud_ranges_.erase(buffer->service_id());
+  }
+  // WebAR END
   // Just delegate it. Some validation is actually done before this.
   buffer_manager()->ValidateAndDoBufferSubData(
       &state_, target, offset, size, data);
 }
 
+// WebAR BEGIN
+
+void GLES2DecoderImpl::DoBufferSubDataPointCloud(
+  GLenum target, GLintptr offset, GLsizeiptr size) {
+  const GLsizeiptr kPointSize = 3 * sizeof(float);
+  // The range is only staged in chunks of this many points (or the biggest
+  // point cloud if it is larger).
+  const unsigned kMinNumberOfStagedPoints = 4096;
+  if (size < 0 || size % kPointSize != 0) {
+    LOCAL_SET_GL_ERROR(GL_INVALID_VALUE, "glBufferSubDataPointCloud",
+                       "size is not a multiple of the point size");
+    return;
+  }
+  // The range is checked before anything is allocated for it.
+  Buffer* buffer = buffer_manager()->GetBufferInfoForTarget(&state_, target);
+  if (!buffer) {
+    LOCAL_SET_GL_ERROR(GL_INVALID_VALUE, "glBufferSubDataPointCloud",
+                       "unknown buffer");
+    return;
+  }
+  if (!buffer->CheckRange(offset, size)) {
+    LOCAL_SET_GL_ERROR(GL_INVALID_VALUE, "glBufferSubDataPointCloud",
+                       "out of range");
+    return;
+  }
+  if (buffer->GetMappedRange()) {
+    LOCAL_SET_GL_ERROR(GL_INVALID_OPERATION, "glBufferSubDataPointCloud",
+                       "buffer is mapped");
+    return;
+  }
+  unsigned capacity = static_cast<unsigned>(size / kPointSize);
+  if (capacity == 0)
+    return;
+  TangoBackend* tangoBackend = TangoBackend::getInstance();
+  unsigned numberOfStagedPoints = std::min(
+      capacity, std::max(tangoBackend->getMaxNumberOfPointsInPointCloud(),
+                         kMinNumberOfStagedPoints));
+  point_cloud_data_.resize(numberOfStagedPoints * 3);
+  // The backend skips enough points for the point cloud to fit.
+  uint32_t numberOfPoints = 0;
+  tangoBackend->getPointCloud(&numberOfPoints, point_cloud_data_.data(),
+                              numberOfStagedPoints, false, 0);
+  TRACE_EVENT1("gpu", "GLES2DecoderImpl::DoBufferSubDataPointCloud",
+               "numberOfPoints", numberOfPoints);
+  if (numberOfPoints > 0) {
+    buffer_manager()->ValidateAndDoBufferSubData(
+        &state_, target, offset, numberOfPoints * kPointSize,
+        point_cloud_data_.data());
+  }
+  // The points after the point cloud are moved out of sight as the renderer
+  // does not know how many points there are. The first time a range is
+  // written all of them are, afterwards only the ones the previous point
+  // cloud used and this one does not.
+  unsigned endOfUnusedPoints = capacity;
+  PointCloudRange& range = point_cloud_ranges_[buffer->service_id()];
+  if (range.offset == offset && range.size == size)
+    endOfUnusedPoints = std::max(range.numberOfPoints, numberOfPoints);
+  range.offset = offset;
+  range.size = size;
+  range.numberOfPoints = numberOfPoints;
+  if (endOfUnusedPoints <= numberOfPoints)
+    return;
+  std::fill(point_cloud_data_.begin(), point_cloud_data_.end(),
+            std::numeric_limits<float>::max());
+  for (unsigned first = numberOfPoints; first < endOfUnusedPoints;
+       first += numberOfStagedPoints) {
+    unsigned count =
+        std::min(numberOfStagedPoints, endOfUnusedPoints - first);
+    buffer_manager()->ValidateAndDoBufferSubData(
+        &state_, target, offset + first * kPointSize, count * kPointSize,
+        point_cloud_data_.data());
+  }
+}
+
+void GLES2DecoderImpl::DoBufferSubDataLatchedPose(
+  GLenum target, GLintptr offset, GLboolean camera_frame) {
+  TangoBackend* tangoBackend = TangoBackend::getInstance();
+  TangoPoseData pose;
+  uint32_t cameraFrameId = 0;
+  // The camera frames are locked and consumed by the pose requests of the
+  // pages and the camera texture updates only. The GPU thread reads the pose
+  // of the latest camera frame the page got, or the latest pose if the page
+  // does not use the camera.
+  bool hasPose =
+      tangoBackend->isConnected() &&
+      ((camera_frame &&
+        tangoBackend->getLatestCameraFramePose(&pose, &cameraFrameId)) ||
+       tangoBackend->getLatestPose(&pose));
+  // Without a pose the buffer keeps the last latched one, the same as a
+  // VRPose that does not change while tracking is lost.
+  if (!hasPose)
+    return;
+  latched_camera_frame_id_ = cameraFrameId;
+  GLfloat matrices[kLatchedPoseSize];
+  ComputeLatchedPose(pose, matrices);
+  TRACE_EVENT1("gpu", "GLES2DecoderImpl::DoBufferSubDataLatchedPose",
+               "cameraFrameId", cameraFrameId);
+  buffer_manager()->ValidateAndDoBufferSubData(
+      &state_, target, offset, sizeof(matrices), matrices);
+}
+
+// WebAR END
+
 bool GLES2DecoderImpl::ClearLevel(Texture* texture,
                                   unsigned target,
                                   int level,
@@ -20,7 +20,14 @@ error::Error DoBindSampler(GLuint unit, GLuint sampler);
 error::Error DoBindTexture(GLenum target, GLuint texture);
 
 // WebAR BEGIN
-error::Error DoUpdateTextureExternalOes(GLuint texture);
+error::Error DoUpdateTextureExternalOes(GLuint texture, GLuint camera_frame_id);
+error::Error DoUpdateCameraUnderlay(GLuint camera_frame_id);
+error::Error DoBufferSubDataPointCloud(GLenum target,
+                                       GLintptr offset,
+                                       GLsizeiptr size);
+error::Error DoBufferSubDataLatchedPose(GLenum target,
+                                        GLintptr offset,
+                                        GLboolean camera_frame);
 // WebAR END
 
 error::Error DoBindTransformFeedback(GLenum target, GLuint transformfeedback);
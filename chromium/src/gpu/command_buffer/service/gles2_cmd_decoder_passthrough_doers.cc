@@ -305,7 +305,28 @@ error::Error GLES2DecoderPassthroughImpl::DoBindTexture(GLenum target,
 }
 
 // WebAR BEGIN
-error::Error GLES2DecoderPassthroughImpl::DoUpdateTextureExternalOes(GLuint texture) {
+error::Error GLES2DecoderPassthroughImpl::DoUpdateTextureExternalOes(
+    GLuint texture,
+    GLuint camera_frame_id) {
+  return error::kNoError;
+}
+
+error::Error GLES2DecoderPassthroughImpl::DoUpdateCameraUnderlay(
+    GLuint camera_frame_id) {
+  return error::kNoError;
+}
+
+error::Error GLES2DecoderPassthroughImpl::DoBufferSubDataPointCloud(
+    GLenum target,
+    GLintptr offset,
+    GLsizeiptr size) {
+  return error::kNoError;
+}
+
+error::Error GLES2DecoderPassthroughImpl::DoBufferSubDataLatchedPose(
+    GLenum target,
+    GLintptr offset,
+    GLboolean camera_frame) {
   return error::kNoError;
 }
 // WebAR END
@@ -0,0 +1,170 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "modules/vr/VRAdaptiveResolution.h"
+
+#include "gpu/GLES2/gl2extchromium.h"
+#include "gpu/command_buffer/client/gles2_interface.h"
+#include "modules/webgl/WebGLRenderingContextBase.h"
+#include "platform/tracing/TraceEvent.h"
+
+#include <algorithm>
+
+namespace blink {
+
+namespace {
+
+// Enough for the results to come back a few frames late without stalling.
+const size_t kMaxPendingFrames = 4;
+// The weight of the newest frame time in the average.
+const double kFrameTimeSmoothing = 0.1;
+// The GPU time is roughly proportional to the number of pixels, so a step
+// changes it by about 20%. The scale goes up only below 75% of the budget
+// for the frame time to stay under it at the new scale.
+const double kScaleStep = 0.9;
+const double kIncreaseThreshold = 0.75;
+// Going over the budget drops frames, it is corrected faster than the scale
+// is increased back.
+const unsigned kFramesBeforeDecrease = 10;
+const unsigned kFramesBeforeIncrease = 60;
+
+}  // namespace
+
+VRAdaptiveResolution::VRAdaptiveResolution(
+    WebGLRenderingContextBase* renderingContext,
+    double minScale,
+    double maxScale,
+    double targetFrameTime)
+    : m_renderingContext(renderingContext),
+      m_minScale(minScale),
+      m_maxScale(maxScale),
+      m_targetFrameTime(targetFrameTime),
+      m_scale(maxScale),
+      m_scaleGeneration(0),
+      m_frameTime(0),
+      m_framesOverBudget(0),
+      m_framesUnderBudget(0) {}
+
+void VRAdaptiveResolution::beginFrame() {
+  if (m_renderingContext->isContextLost())
+    return;
+  collectFrameTimes();
+
+  // The results are late, this frame is not measured.
+  if (m_pendingFrames.size() >= kMaxPendingFrames)
+    return;
+  // Timestamps do not occupy the GL_TIME_ELAPSED_EXT slot, so the page can
+  // still time its own work with EXT_disjoint_timer_query in its callbacks.
+  m_currentFrame.startQuery = takeQuery();
+  m_currentFrame.scaleGeneration = m_scaleGeneration;
+  m_renderingContext->contextGL()->QueryCounterEXT(m_currentFrame.startQuery,
+                                                   GL_TIMESTAMP_EXT);
+}
+
+void VRAdaptiveResolution::endFrame() {
+  if (!m_currentFrame.startQuery)
+    return;
+  if (m_renderingContext->isContextLost()) {
+    m_freeQueries.push_back(m_currentFrame.startQuery);
+  } else {
+    m_currentFrame.endQuery = takeQuery();
+    m_renderingContext->contextGL()->QueryCounterEXT(m_currentFrame.endQuery,
+                                                     GL_TIMESTAMP_EXT);
+    m_pendingFrames.append(m_currentFrame);
+  }
+  m_currentFrame = PendingFrame();
+}
+
+void VRAdaptiveResolution::dispose() {
+  if (m_currentFrame.startQuery)
+    m_freeQueries.push_back(m_currentFrame.startQuery);
+  for (const PendingFrame& pendingFrame : m_pendingFrames) {
+    m_freeQueries.push_back(pendingFrame.startQuery);
+    m_freeQueries.push_back(pendingFrame.endQuery);
+  }
+  if (!m_renderingContext->isContextLost() && !m_freeQueries.isEmpty()) {
+    m_renderingContext->contextGL()->DeleteQueriesEXT(m_freeQueries.size(),
+                                                      m_freeQueries.data());
+  }
+  m_currentFrame = PendingFrame();
+  m_freeQueries.clear();
+  m_pendingFrames.clear();
+}
+
+unsigned VRAdaptiveResolution::takeQuery() {
+  if (m_freeQueries.isEmpty()) {
+    GLuint query = 0;
+    m_renderingContext->contextGL()->GenQueriesEXT(1, &query);
+    return query;
+  }
+  unsigned query = m_freeQueries.last();
+  m_freeQueries.removeLast();
+  return query;
+}
+
+void VRAdaptiveResolution::collectFrameTimes() {
+  gpu::gles2::GLES2Interface* gl = m_renderingContext->contextGL();
+  while (!m_pendingFrames.isEmpty()) {
+    PendingFrame pendingFrame = m_pendingFrames.first();
+    // The end timestamp is written after the start one.
+    GLuint available = 0;
+    gl->GetQueryObjectuivEXT(pendingFrame.endQuery,
+                             GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+    if (!available)
+      break;
+    m_pendingFrames.removeFirst();
+    m_freeQueries.push_back(pendingFrame.startQuery);
+    m_freeQueries.push_back(pendingFrame.endQuery);
+    GLuint64 startTime = 0;
+    GLuint64 endTime = 0;
+    gl->GetQueryObjectui64vEXT(pendingFrame.startQuery, GL_QUERY_RESULT_EXT,
+                               &startTime);
+    gl->GetQueryObjectui64vEXT(pendingFrame.endQuery, GL_QUERY_RESULT_EXT,
+                               &endTime);
+    // A disjoint operation (for example a frequency change of a throttled
+    // GPU) makes the results of the queries in flight meaningless.
+    GLint disjoint = 0;
+    gl->GetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint || endTime < startTime ||
+        pendingFrame.scaleGeneration != m_scaleGeneration)
+      continue;
+    addFrameTime((endTime - startTime) / 1000000.0);
+  }
+}
+
+void VRAdaptiveResolution::addFrameTime(double frameTime) {
+  m_frameTime = m_frameTime ? m_frameTime +
+                                  kFrameTimeSmoothing * (frameTime - m_frameTime)
+                            : frameTime;
+  if (m_frameTime > m_targetFrameTime) {
+    m_framesUnderBudget = 0;
+    if (++m_framesOverBudget >= kFramesBeforeDecrease)
+      setScale(std::max(m_minScale, m_scale * kScaleStep));
+  } else if (m_frameTime < m_targetFrameTime * kIncreaseThreshold) {
+    m_framesOverBudget = 0;
+    if (++m_framesUnderBudget >= kFramesBeforeIncrease)
+      setScale(std::min(m_maxScale, m_scale / kScaleStep));
+  } else {
+    m_framesOverBudget = 0;
+    m_framesUnderBudget = 0;
+  }
+}
+
+void VRAdaptiveResolution::setScale(double scale) {
+  m_framesOverBudget = 0;
+  m_framesUnderBudget = 0;
+  if (scale == m_scale)
+    return;
+  TRACE_EVENT2("gpu", "VRAdaptiveResolution::setScale", "frameTime",
+               m_frameTime, "scale", scale);
+  m_scale = scale;
+  m_scaleGeneration++;
+  m_frameTime = 0;
+}
+
+DEFINE_TRACE(VRAdaptiveResolution) {
+  visitor->trace(m_renderingContext);
+}
+
+}  // namespace blink
@@ -0,0 +1,87 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef VRAdaptiveResolution_h
+#define VRAdaptiveResolution_h
+
+#include "platform/heap/Handle.h"
+#include "wtf/Deque.h"
+#include "wtf/Vector.h"
+
+namespace blink {
+
+class WebGLRenderingContextBase;
+
+// Picks the render scale of a WebGL canvas that keeps its GPU frame time
+// under a budget. The GPU time of each animation frame is measured by the
+// decoder with GL_TIMESTAMP_EXT queries written before and after the
+// callbacks. The scale goes down after a run of frames
+// over the budget and back up after a longer run of frames well under it, so
+// it does not bounce between two values. The page applies the scale to its
+// drawing buffer.
+class VRAdaptiveResolution final
+    : public GarbageCollectedFinalized<VRAdaptiveResolution> {
+ public:
+  // targetFrameTime is in milliseconds.
+  VRAdaptiveResolution(WebGLRenderingContextBase*,
+                       double minScale,
+                       double maxScale,
+                       double targetFrameTime);
+
+  WebGLRenderingContextBase* renderingContext() const {
+    return m_renderingContext;
+  }
+  double scale() const { return m_scale; }
+
+  // Around the animation frame callbacks. The scale only changes in
+  // beginFrame, it stays the same for the whole frame.
+  void beginFrame();
+  void endFrame();
+
+  // Deletes the queries. The object is not used afterwards.
+  void dispose();
+
+  // Adds the GPU time of a frame, in milliseconds, as if it had been
+  // measured.
+  void addFrameTimeForTesting(double frameTime) { addFrameTime(frameTime); }
+
+  DECLARE_TRACE();
+
+ private:
+  struct PendingFrame {
+    PendingFrame() : startQuery(0), endQuery(0), scaleGeneration(0) {}
+
+    unsigned startQuery;
+    unsigned endQuery;
+    unsigned scaleGeneration;
+  };
+
+  unsigned takeQuery();
+  void collectFrameTimes();
+  void addFrameTime(double frameTime);
+  void setScale(double);
+
+  Member<WebGLRenderingContextBase> m_renderingContext;
+  double m_minScale;
+  double m_maxScale;
+  double m_targetFrameTime;
+  double m_scale;
+  // Incremented on every scale change so the frames rendered at the previous
+  // scale are not counted.
+  unsigned m_scaleGeneration;
+  // Exponential moving average, 0 until the first frame time at the current
+  // scale arrives.
+  double m_frameTime;
+  unsigned m_framesOverBudget;
+  unsigned m_framesUnderBudget;
+
+  Vector<unsigned> m_freeQueries;
+  Deque<PendingFrame> m_pendingFrames;
+  // The frame being rendered, its startQuery is 0 if it is not measured.
+  PendingFrame m_currentFrame;
+};
+
+}  // namespace blink
+
+#endif  // VRAdaptiveResolution_h
@@ -0,0 +1,94 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "modules/vr/VRAdaptiveResolution.h"
+
+#include "platform/heap/Handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace blink {
+
+namespace {
+
+const double kMinScale = 0.5;
+const double kMaxScale = 1.0;
+const double kTargetFrameTime = 16.0;
+
+// The frame times are added directly, the policy does not need a context.
+VRAdaptiveResolution* createAdaptiveResolution() {
+  return new VRAdaptiveResolution(nullptr, kMinScale, kMaxScale,
+                                  kTargetFrameTime);
+}
+
+void addFrames(VRAdaptiveResolution* adaptiveResolution,
+               unsigned numberOfFrames,
+               double frameTime) {
+  for (unsigned i = 0; i < numberOfFrames; i++)
+    adaptiveResolution->addFrameTimeForTesting(frameTime);
+}
+
+}  // namespace
+
+TEST(VRAdaptiveResolutionTest, StartsAtTheMaximumScale) {
+  Persistent<VRAdaptiveResolution> adaptiveResolution =
+      createAdaptiveResolution();
+  EXPECT_EQ(kMaxScale, adaptiveResolution->scale());
+}
+
+TEST(VRAdaptiveResolutionTest, DecreasesAfterARunOfFramesOverBudget) {
+  Persistent<VRAdaptiveResolution> adaptiveResolution =
+      createAdaptiveResolution();
+  addFrames(adaptiveResolution, 9, 20.0);
+  EXPECT_EQ(kMaxScale, adaptiveResolution->scale());
+  addFrames(adaptiveResolution, 1, 20.0);
+  EXPECT_DOUBLE_EQ(0.9, adaptiveResolution->scale());
+}
+
+TEST(VRAdaptiveResolutionTest, IsClampedToTheBounds) {
+  Persistent<VRAdaptiveResolution> adaptiveResolution =
+      createAdaptiveResolution();
+  addFrames(adaptiveResolution, 1000, 100.0);
+  EXPECT_EQ(kMinScale, adaptiveResolution->scale());
+  addFrames(adaptiveResolution, 10000, 1.0);
+  EXPECT_EQ(kMaxScale, adaptiveResolution->scale());
+}
+
+TEST(VRAdaptiveResolutionTest, DoesNotIncreaseJustUnderBudget) {
+  Persistent<VRAdaptiveResolution> adaptiveResolution =
+      createAdaptiveResolution();
+  addFrames(adaptiveResolution, 10, 20.0);
+  ASSERT_DOUBLE_EQ(0.9, adaptiveResolution->scale());
+  // Under the budget but above 75% of it, the scale stays where it is
+  // instead of bouncing between two values.
+  addFrames(adaptiveResolution, 1000, 14.0);
+  EXPECT_DOUBLE_EQ(0.9, adaptiveResolution->scale());
+}
+
+TEST(VRAdaptiveResolutionTest, IncreasesAfterALongerRunWellUnderBudget) {
+  Persistent<VRAdaptiveResolution> adaptiveResolution =
+      createAdaptiveResolution();
+  addFrames(adaptiveResolution, 10, 20.0);
+  ASSERT_DOUBLE_EQ(0.9, adaptiveResolution->scale());
+  addFrames(adaptiveResolution, 59, 5.0);
+  EXPECT_DOUBLE_EQ(0.9, adaptiveResolution->scale());
+  addFrames(adaptiveResolution, 1, 5.0);
+  EXPECT_DOUBLE_EQ(kMaxScale, adaptiveResolution->scale());
+}
+
+TEST(VRAdaptiveResolutionTest, ASpikeRestartsTheRunUnderBudget) {
+  Persistent<VRAdaptiveResolution> adaptiveResolution =
+      createAdaptiveResolution();
+  addFrames(adaptiveResolution, 10, 20.0);
+  ASSERT_DOUBLE_EQ(0.9, adaptiveResolution->scale());
+  addFrames(adaptiveResolution, 50, 5.0);
+  // A single slow frame takes the average over the budget for a few frames,
+  // not long enough to decrease the scale.
+  addFrames(adaptiveResolution, 1, 200.0);
+  addFrames(adaptiveResolution, 60, 5.0);
+  EXPECT_DOUBLE_EQ(0.9, adaptiveResolution->scale());
+  addFrames(adaptiveResolution, 60, 5.0);
+  EXPECT_DOUBLE_EQ(kMaxScale, adaptiveResolution->scale());
+}
+
+}  // namespace blink
@@ -4,6 +4,7 @@
 
 #include "modules/vr/VRDisplay.h"
 
+#include "bindings/core/v8/ExceptionState.h"
 #include "core/css/StylePropertySet.h"
 #include "core/dom/DOMException.h"
 #include "core/dom/DocumentUserGestureToken.h"
@@ -13,9 +14,12 @@
 #include "core/frame/UseCounter.h"
 #include "core/inspector/ConsoleMessage.h"
 #include "core/loader/DocumentLoader.h"
+#include "gpu/GLES2/gl2extchromium.h"
 #include "gpu/command_buffer/client/gles2_interface.h"
 #include "modules/EventTargetModules.h"
 #include "modules/vr/NavigatorVR.h"
+#include "modules/vr/VRAdaptiveResolution.h"
+#include "modules/vr/VRAdaptiveResolutionConfiguration.h"
 #include "modules/vr/VRController.h"
 #include "modules/vr/VRDisplayCapabilities.h"
 #include "modules/vr/VREyeParameters.h"
@@ -27,21 +31,100 @@
 #include "modules/vr/VRPickingPointAndPlane.h"
 #include "modules/vr/VRSeeThroughCamera.h"
 #include "modules/vr/VRADF.h"
+#include "modules/vr/VRSensorConfiguration.h"
 #include "modules/webgl/WebGLRenderingContextBase.h"
 #include "platform/Histogram.h"
 #include "platform/UserGestureIndicator.h"
+#include "platform/graphics/gpu/Extensions3DUtil.h"
+#include "platform/tracing/TraceEvent.h"
 #include "public/platform/Platform.h"
 #include "wtf/AutoReset.h"
 
-#include <array>
+#include <algorithm>
+#include <limits>
 
 namespace blink {
 
 namespace {
 
-// Magic numbers used to mark valid pose index values encoded in frame
-// data. Must match the magic numbers used in vr_shell.cc.
-static constexpr std::array<uint8_t, 2> kWebVrPosePixelMagicNumbers{{42, 142}};
+// Depth arrives at a few Hz, this only protects the page from a device that
+// would push point clouds faster than it can render them.
+static constexpr double kPointCloudMinimumInterval = 1.0 / 30.0;
+
+// The camera runs at about 30 Hz, a page waiting for a camera frame longer
+// than this is served anyway.
+static constexpr double kCameraFrameTimeout = 0.1;
+
+const char* animationFrameModeToString(VRAnimationFrameMode mode) {
+  switch (mode) {
+    case VRAnimationFrameModeDisplay:
+      return "display";
+    case VRAnimationFrameModeCamera:
+      return "camera";
+    case VRAnimationFrameModeInterpolated:
+      return "interpolated";
+  }
+  NOTREACHED();
+  return "display";
+}
+
+// The number of values a picking writes: the point and then the plane.
+static constexpr unsigned kPickingPointAndPlaneSize = 7;
+
+// The picking results can be written into these arrays only, at offset for
+// count pickings.
+bool validatePickingResults(DOMArrayBufferView* results,
+                            unsigned offset,
+                            unsigned count,
+                            ExceptionState& exceptionState) {
+  if (results->type() != DOMArrayBufferView::TypeFloat32 &&
+      results->type() != DOMArrayBufferView::TypeFloat64) {
+    exceptionState.throwTypeError(
+        "The results must be a Float32Array or a Float64Array.");
+    return false;
+  }
+  unsigned length = results->byteLength() /
+                    (results->type() == DOMArrayBufferView::TypeFloat32
+                         ? sizeof(float)
+                         : sizeof(double));
+  if (offset > length ||
+      (length - offset) / kPickingPointAndPlaneSize < count) {
+    exceptionState.throwRangeError(
+        "The results do not fit in the array from the offset on.");
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+void writePickingPointAndPlane(
+    T* values,
+    const device::mojom::blink::VRPickingPointAndPlanePtr& pointAndPlane) {
+  if (pointAndPlane.is_null()) {
+    std::fill(values, values + kPickingPointAndPlaneSize,
+              std::numeric_limits<T>::quiet_NaN());
+    return;
+  }
+  for (size_t i = 0; i < 3; i++)
+    values[i] = static_cast<T>(pointAndPlane->point[i]);
+  for (size_t i = 0; i < 4; i++)
+    values[3 + i] = static_cast<T>(pointAndPlane->plane[i]);
+}
+
+void writePickingPointAndPlane(
+    DOMArrayBufferView* results,
+    unsigned offset,
+    const device::mojom::blink::VRPickingPointAndPlanePtr& pointAndPlane) {
+  if (results->type() == DOMArrayBufferView::TypeFloat32) {
+    writePickingPointAndPlane(
+        static_cast<DOMFloat32Array*>(results)->data() + offset,
+        pointAndPlane);
+  } else {
+    writePickingPointAndPlane(
+        static_cast<DOMFloat64Array*>(results)->data() + offset,
+        pointAndPlane);
+  }
+}
 
 VREye stringToVREye(const String& whichEye) {
   if (whichEye == "left")
@@ -51,6 +134,22 @@ VREye stringToVREye(const String& whichEye) {
   return VREyeNone;
 }
 
+String connectionStateToString(
+    device::mojom::blink::VRConnectionState state) {
+  switch (state) {
+    case device::mojom::blink::VRConnectionState::CONNECTED:
+      return "connected";
+    case device::mojom::blink::VRConnectionState::CONNECTING:
+      return "connecting";
+    case device::mojom::blink::VRConnectionState::DISCONNECTED:
+      return "disconnected";
+    case device::mojom::blink::VRConnectionState::FAILED:
+      return "failed";
+  }
+  NOTREACHED();
+  return "disconnected";
+}
+
 class VRDisplayFrameRequestCallback : public FrameRequestCallback {
  public:
   VRDisplayFrameRequestCallback(VRDisplay* vrDisplay) : m_vrDisplay(vrDisplay) {
@@ -86,20 +185,32 @@ VRDisplay::VRDisplay(NavigatorVR* navigatorVR,
     : ContextLifecycleObserver(navigatorVR->document()),
       m_navigatorVR(navigatorVR),
       m_isConnected(false),
+      m_connectionState("disconnected"),
       m_isPresenting(false),
       m_isValidDeviceForPresenting(true),
       m_canUpdateFramePose(true),
       m_capabilities(new VRDisplayCapabilities()),
       m_eyeParametersLeft(new VREyeParameters()),
       m_eyeParametersRight(new VREyeParameters()),
+      m_nextFrameStateRequest(
+          device::mojom::blink::VRFrameStateRequest::New()),
       m_depthNear(0.01),
       m_depthFar(10000.0),
       m_fullscreenCheckTimer(this, &VRDisplay::onFullscreenCheck),
       m_contextGL(nullptr),
       m_animationCallbackRequested(false),
       m_inAnimationFrame(false),
+      m_animationFrameMode(VRAnimationFrameModeDisplay),
+      m_cameraFrameAvailable(false),
+      m_useLatestPose(false),
+      m_cameraFrameTimer(this, &VRDisplay::onCameraFrameTimeout),
       m_display(std::move(display)),
-      m_binding(this, std::move(request)) {}
+      m_binding(this, std::move(request)),
+      m_pointCloudSubscribed(false),
+      m_maxNumberOfPointsInPointCloud(0) {
+  m_display.set_connection_error_handler(convertToBaseCallback(
+      WTF::bind(&VRDisplay::onConnectionError, wrapWeakPersistent(this))));
+}
 
 VRDisplay::~VRDisplay() {}
 
@@ -140,10 +251,16 @@ void VRDisplay::update(const device::mojom::blink::VRDisplayInfoPtr& display) {
     m_stageParameters = nullptr;
   }
 
-  if (display->capabilities->hasSeeThroughCamera) {
+  // The see through camera information is pushed along with the display
+  // info whenever it changes so getSeeThroughCamera does not need any IPC.
+  if (display->capabilities->hasSeeThroughCamera &&
+      !display->seeThroughCamera.is_null()) {
     if (!m_seeThroughCamera) {
       m_seeThroughCamera = new VRSeeThroughCamera();
     }
+    m_seeThroughCamera->setSeeThroughCamera(display->seeThroughCamera);
+  } else {
+    m_seeThroughCamera = nullptr;
   }
 
   if (display->capabilities->hasPointCloud) {
@@ -152,6 +269,19 @@ void VRDisplay::update(const device::mojom::blink::VRDisplayInfoPtr& display) {
     }
   }
 
+  // Tango devices connect in the background, the pages waiting for the
+  // connection are notified when the state changes.
+  String connectionState = connectionStateToString(display->connectionState);
+  m_connectionError = display->connectionError;
+  if (connectionState != m_connectionState) {
+    m_connectionState = connectionState;
+    while (!m_connectionStateResolvers.isEmpty()) {
+      ScriptPromiseResolver* resolver =
+          m_connectionStateResolvers.takeFirst();
+      resolver->resolve(m_connectionState);
+    }
+  }
+
   if (needOnPresentChange) {
     OnPresentChange();
   }
@@ -199,13 +329,36 @@ void VRDisplay::updatePose() {
     if (!m_display)
       return;
     device::mojom::blink::VRPosePtr pose;
-    m_display->GetPose(&pose);
+    if (updateFrameState())
+      pose = m_frameState->pose.Clone();
+    else
+      m_display->GetPose(&pose);
     m_framePose = std::move(pose);
+    // Remember which camera frame matches this pose so the camera texture
+    // update resolves the very same frame.
+    if (m_seeThroughCamera) {
+      m_seeThroughCamera->setFrameId(m_framePose ? m_framePose->cameraFrameId
+                                                 : 0);
+    }
     if (m_isPresenting)
       m_canUpdateFramePose = false;
   }
 }
 
+bool VRDisplay::updateFrameState() {
+  if (!m_inAnimationFrame || !m_display)
+    return false;
+  if (m_frameState)
+    return true;
+
+  m_frameStateRequest = std::move(m_nextFrameStateRequest);
+  m_nextFrameStateRequest = device::mojom::blink::VRFrameStateRequest::New();
+  m_frameStateRequest->latestPose = m_useLatestPose;
+  if (!m_display->GetFrameState(m_frameStateRequest.Clone(), &m_frameState))
+    m_frameState = nullptr;
+  return !m_frameState.is_null();
+}
+
 void VRDisplay::resetPose() {
   if (!m_display)
     return;
@@ -217,6 +370,9 @@ unsigned VRDisplay::getMaxNumberOfPointsInPointCloud() {
   if (!m_display)
     return 0;
 
+  if (updateFrameState())
+    return m_frameState->maxNumberOfPointsInPointCloud;
+
   unsigned result;
   m_display->GetMaxNumberOfPointsInPointCloud(&result);
 
@@ -227,20 +383,31 @@ void VRDisplay::getPointCloud(VRPointCloud* pointCloud, bool justUpdatePointClou
   if (!m_display)
     return;
 
+  // Ask for the same point cloud along with the next frame state.
+  m_nextFrameStateRequest->pointCloud = true;
+  m_nextFrameStateRequest->justUpdatePointCloud = justUpdatePointCloud;
+  m_nextFrameStateRequest->pointsToSkip = pointsToSkip;
+
+  if (updateFrameState() && m_frameStateRequest->pointCloud &&
+      m_frameStateRequest->justUpdatePointCloud == justUpdatePointCloud &&
+      m_frameStateRequest->pointsToSkip == pointsToSkip) {
+    pointCloud->setPointCloud(m_frameState->maxNumberOfPointsInPointCloud,
+                              m_frameState->pointCloud);
+    return;
+  }
+
   device::mojom::blink::VRPointCloudPtr mojoPointCloud;
   m_display->GetPointCloud(justUpdatePointCloud, pointsToSkip, &mojoPointCloud);
 
-  unsigned maxNumberOfPoints;
-  m_display->GetMaxNumberOfPointsInPointCloud(&maxNumberOfPoints);
-  pointCloud->setPointCloud(maxNumberOfPoints, mojoPointCloud);
+  pointCloud->setPointCloud(getMaxNumberOfPointsInPointCloud(), mojoPointCloud);
 }
 
 VRPickingPointAndPlane* VRDisplay::getPickingPointAndPlaneInPointCloud(float x, float y) {
   if (!m_display || !m_pickingPointAndPlane)
     return nullptr;
 
-  device::mojom::blink::VRPickingPointAndPlanePtr mojoPickingPointAndPlane;
-  m_display->GetPickingPointAndPlaneInPointCloud(x, y, &mojoPickingPointAndPlane);
+  device::mojom::blink::VRPickingPointAndPlanePtr mojoPickingPointAndPlane =
+      pickPointAndPlane(x, y);
   if (mojoPickingPointAndPlane.is_null()) {
     return nullptr;
   }
@@ -250,19 +417,85 @@ VRPickingPointAndPlane* VRDisplay::getPickingPointAndPlaneInPointCloud(float x,
   return m_pickingPointAndPlane;
 }
 
+bool VRDisplay::getPickingPointAndPlaneInPointCloudInto(
+    float x,
+    float y,
+    DOMArrayBufferView* result,
+    unsigned offset,
+    ExceptionState& exceptionState) {
+  if (!validatePickingResults(result, offset, 1, exceptionState))
+    return false;
+  if (!m_display || !m_pickingPointAndPlane)
+    return false;
+
+  device::mojom::blink::VRPickingPointAndPlanePtr mojoPickingPointAndPlane =
+      pickPointAndPlane(x, y);
+  if (mojoPickingPointAndPlane.is_null())
+    return false;
+  writePickingPointAndPlane(result, offset, mojoPickingPointAndPlane);
+  return true;
+}
+
+unsigned VRDisplay::getPickingPointsAndPlanesInPointCloud(
+    DOMFloat32Array* coordinates,
+    DOMArrayBufferView* results,
+    unsigned offset,
+    ExceptionState& exceptionState) {
+  unsigned count = coordinates->length() / 2;
+  if (!validatePickingResults(results, offset, count, exceptionState))
+    return 0;
+
+  Vector<device::mojom::blink::VRPickingPointAndPlanePtr> mojoPointsAndPlanes;
+  if (m_display && m_pickingPointAndPlane && count) {
+    TRACE_EVENT1("gpu", "VRDisplay::getPickingPointsAndPlanesInPointCloud",
+                 "count", count);
+    Vector<float> mojoCoordinates;
+    mojoCoordinates.append(coordinates->data(), 2 * count);
+    m_display->GetPickingPointsAndPlanesInPointCloud(mojoCoordinates,
+                                                     &mojoPointsAndPlanes);
+  }
+
+  unsigned hits = 0;
+  for (unsigned i = 0; i < count; i++) {
+    // A missing entry (no access to the display) is a miss as well.
+    if (i < mojoPointsAndPlanes.size()) {
+      writePickingPointAndPlane(results, offset + i * kPickingPointAndPlaneSize,
+                                mojoPointsAndPlanes[i]);
+      if (!mojoPointsAndPlanes[i].is_null())
+        hits++;
+    } else {
+      writePickingPointAndPlane(results, offset + i * kPickingPointAndPlaneSize,
+                                nullptr);
+    }
+  }
+  return hits;
+}
+
+device::mojom::blink::VRPickingPointAndPlanePtr VRDisplay::pickPointAndPlane(
+    float x,
+    float y) {
+  // Pages usually pick at the same position every frame (a reticle), so the
+  // picking is requested again with the next frame state.
+  m_nextFrameStateRequest->pickingPointAndPlane = true;
+  m_nextFrameStateRequest->pickingX = x;
+  m_nextFrameStateRequest->pickingY = y;
+
+  device::mojom::blink::VRPickingPointAndPlanePtr mojoPickingPointAndPlane;
+  if (updateFrameState() && m_frameStateRequest->pickingPointAndPlane &&
+      m_frameStateRequest->pickingX == x && m_frameStateRequest->pickingY == y) {
+    mojoPickingPointAndPlane = m_frameState->pickingPointAndPlane.Clone();
+  } else {
+    m_display->GetPickingPointAndPlaneInPointCloud(x, y,
+                                                   &mojoPickingPointAndPlane);
+  }
+  return mojoPickingPointAndPlane;
+}
+
 VRSeeThroughCamera* VRDisplay::getSeeThroughCamera()
 {
-  if (!m_display || !m_seeThroughCamera)
+  if (!m_display)
     return nullptr;
 
-  device::mojom::blink::VRSeeThroughCameraPtr seeThroughCamera;
-  m_display->GetSeeThroughCamera(&seeThroughCamera);
-  if (seeThroughCamera.is_null()) {
-    return nullptr;
-  }
-  else {
-    m_seeThroughCamera->setSeeThroughCamera(seeThroughCamera);
-  }
   return m_seeThroughCamera;
 }
 
@@ -299,6 +532,56 @@ void VRDisplay::disableADF()
   m_display->DisableADF();
 }
 
+ScriptPromise VRDisplay::waitForPointCloud(ScriptState* scriptState) {
+  ScriptPromiseResolver* resolver = ScriptPromiseResolver::create(scriptState);
+  ScriptPromise promise = resolver->promise();
+
+  if (!m_display) {
+    DOMException* exception =
+        DOMException::create(InvalidStateError, "VRService is not available.");
+    resolver->reject(exception);
+    return promise;
+  }
+
+  m_pointCloudResolvers.append(resolver);
+  if (!m_pointCloudSubscribed) {
+    m_pointCloudSubscribed = true;
+    m_display->SetPointCloudSubscription(true, kPointCloudMinimumInterval);
+  }
+  return promise;
+}
+
+ScriptPromise VRDisplay::waitForTrackingStateChange(ScriptState* scriptState) {
+  ScriptPromiseResolver* resolver = ScriptPromiseResolver::create(scriptState);
+  ScriptPromise promise = resolver->promise();
+
+  if (!m_display) {
+    DOMException* exception =
+        DOMException::create(InvalidStateError, "VRService is not available.");
+    resolver->reject(exception);
+    return promise;
+  }
+
+  m_trackingStateResolvers.append(resolver);
+  return promise;
+}
+
+ScriptPromise VRDisplay::waitForConnectionStateChange(
+    ScriptState* scriptState) {
+  ScriptPromiseResolver* resolver = ScriptPromiseResolver::create(scriptState);
+  ScriptPromise promise = resolver->promise();
+
+  if (!m_display) {
+    DOMException* exception =
+        DOMException::create(InvalidStateError, "VRService is not available.");
+    resolver->reject(exception);
+    return promise;
+  }
+
+  m_connectionStateResolvers.append(resolver);
+  return promise;
+}
+
 VREyeParameters* VRDisplay::getEyeParameters(const String& whichEye) {
   switch (stringToVREye(whichEye)) {
     case VREyeLeft:
@@ -316,14 +599,59 @@ int VRDisplay::requestAnimationFrame(FrameRequestCallback* callback) {
     return 0;
 
   if (!m_animationCallbackRequested) {
-    doc->requestAnimationFrame(new VRDisplayFrameRequestCallback(this));
-    m_animationCallbackRequested = true;
+    // In camera mode the frame is only requested once there is a new camera
+    // frame to show.
+    if (m_animationFrameMode != VRAnimationFrameModeCamera ||
+        m_cameraFrameAvailable) {
+      requestDocumentAnimationFrame();
+    } else if (!m_cameraFrameTimer.isActive()) {
+      m_cameraFrameTimer.startOneShot(kCameraFrameTimeout, BLINK_FROM_HERE);
+    }
   }
 
   callback->m_useLegacyTimeBase = false;
   return ensureScriptedAnimationController(doc).registerCallback(callback);
 }
 
+void VRDisplay::requestDocumentAnimationFrame() {
+  Document* doc = this->document();
+  if (!doc)
+    return;
+
+  m_cameraFrameTimer.stop();
+  doc->requestAnimationFrame(new VRDisplayFrameRequestCallback(this));
+  m_animationCallbackRequested = true;
+}
+
+void VRDisplay::onCameraFrameTimeout(TimerBase*) {
+  if (!m_animationCallbackRequested)
+    requestDocumentAnimationFrame();
+}
+
+String VRDisplay::animationFrameMode() const {
+  return animationFrameModeToString(m_animationFrameMode);
+}
+
+void VRDisplay::setAnimationFrameMode(const String& mode) {
+  VRAnimationFrameMode newMode = VRAnimationFrameModeDisplay;
+  if (mode == "camera")
+    newMode = VRAnimationFrameModeCamera;
+  else if (mode == "interpolated")
+    newMode = VRAnimationFrameModeInterpolated;
+  if (newMode == m_animationFrameMode)
+    return;
+
+  m_animationFrameMode = newMode;
+  m_cameraFrameAvailable = false;
+  if (m_display) {
+    m_display->SetCameraFrameSubscription(newMode !=
+                                          VRAnimationFrameModeDisplay);
+  }
+  // A frame that was waiting for a camera frame is not anymore.
+  if (newMode != VRAnimationFrameModeCamera && m_cameraFrameTimer.isActive())
+    requestDocumentAnimationFrame();
+}
+
 void VRDisplay::cancelAnimationFrame(int id) {
   if (!m_scriptedAnimationController)
     return;
@@ -359,6 +687,16 @@ void VRDisplay::serviceScriptedAnimations(double monotonicAnimationStartTime) {
     return;
   AutoReset<bool> animating(&m_inAnimationFrame, true);
   m_animationCallbackRequested = false;
+  // A new frame, the frame state is requested again on first use.
+  m_frameState = nullptr;
+  // The GPU time per second of each mode can be compared in the traces.
+  TRACE_EVENT2("gpu", "VRDisplay::serviceScriptedAnimations",
+               "animationFrameMode",
+               animationFrameModeToString(m_animationFrameMode),
+               "newCameraFrame", m_cameraFrameAvailable);
+  m_useLatestPose = m_animationFrameMode == VRAnimationFrameModeInterpolated &&
+                    !m_cameraFrameAvailable;
+  m_cameraFrameAvailable = false;
 
   // We use an internal rAF callback to run the animation loop at the display
   // speed, and run the user's callback after our internal callback fires.
@@ -366,8 +704,72 @@ void VRDisplay::serviceScriptedAnimations(double monotonicAnimationStartTime) {
   // so we don't fire the user's callback until the display is focused.
   if (m_displayBlurred)
     return;
+  // The GPU time of the callbacks is what the adaptive resolution measures.
+  VRAdaptiveResolution* adaptiveResolution = m_adaptiveResolution;
+  if (adaptiveResolution)
+    adaptiveResolution->beginFrame();
   m_scriptedAnimationController->serviceScriptedAnimations(
       monotonicAnimationStartTime);
+  if (adaptiveResolution)
+    adaptiveResolution->endFrame();
+}
+
+void VRDisplay::enableAdaptiveResolution(
+    HTMLCanvasElement* source,
+    const VRAdaptiveResolutionConfiguration& configuration,
+    ExceptionState& exceptionState) {
+  double minScale = configuration.minScale();
+  double maxScale = configuration.maxScale();
+  double targetFrameTime = configuration.targetFrameTime();
+  if (!(minScale > 0) || !(minScale <= maxScale) || !(maxScale <= 1)) {
+    exceptionState.throwRangeError(
+        "The scales must satisfy 0 < minScale <= maxScale <= 1.");
+    return;
+  }
+  if (!(targetFrameTime > 0)) {
+    exceptionState.throwRangeError("targetFrameTime must be positive.");
+    return;
+  }
+  CanvasRenderingContext* renderingContext = source->renderingContext();
+  if (!renderingContext || !renderingContext->is3d() ||
+      renderingContext->isContextLost()) {
+    exceptionState.throwDOMException(
+        InvalidStateError, "The canvas must have a WebGLRenderingContext.");
+    return;
+  }
+  WebGLRenderingContextBase* webglContext =
+      toWebGLRenderingContextBase(renderingContext);
+  if (!webglContext->extensionsUtil()->ensureExtensionEnabled(
+          "GL_EXT_disjoint_timer_query")) {
+    exceptionState.throwDOMException(
+        NotSupportedError, "The GPU cannot measure the frame time.");
+    return;
+  }
+  // The frame time is measured with timestamps, which the extension allows
+  // not to support.
+  GLint timestampBits = 0;
+  webglContext->contextGL()->GetQueryivEXT(
+      GL_TIMESTAMP_EXT, GL_QUERY_COUNTER_BITS_EXT, &timestampBits);
+  if (!timestampBits) {
+    exceptionState.throwDOMException(
+        NotSupportedError, "The GPU cannot measure the frame time.");
+    return;
+  }
+
+  disableAdaptiveResolution();
+  m_adaptiveResolution = new VRAdaptiveResolution(webglContext, minScale,
+                                                  maxScale, targetFrameTime);
+}
+
+void VRDisplay::disableAdaptiveResolution() {
+  if (!m_adaptiveResolution)
+    return;
+  m_adaptiveResolution->dispose();
+  m_adaptiveResolution = nullptr;
+}
+
+double VRDisplay::renderScale() const {
+  return m_adaptiveResolution ? m_adaptiveResolution->scale() : 1.0;
 }
 
 void ReportPresentationResult(PresentationResult result) {
@@ -723,38 +1125,22 @@ void VRDisplay::submitFrame() {
     return;
   }
 
-  // Write the frame number for the pose used into a bottom left pixel block.
-  // It is read by chrome/browser/android/vr_shell/vr_shell.cc to associate
-  // the correct corresponding pose for submission.
-  auto gl = m_contextGL;
-
-  // We must ensure that the WebGL app's GL state is preserved. We do this by
-  // calling low-level GL commands directly so that the rendering context's
-  // saved parameters don't get overwritten.
-
-  gl->Enable(GL_SCISSOR_TEST);
-  // Use a few pixels to ensure we get a clean color. The resolution for the
-  // WebGL buffer may not match the final rendered destination size, and
-  // texture filtering could interfere for single pixels. This isn't visible
-  // since the final rendering hides the edges via a vignette effect.
-  gl->Scissor(0, 0, 4, 4);
-  gl->ColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-  int idx = m_framePose->poseIndex;
-  // Careful with the arithmetic here. Float color 1.f is equivalent to int 255.
-  // Use the low byte of the index as the red component, and store an arbitrary
-  // magic number in green/blue. This number must match the reading code in
-  // vr_shell.cc. Avoid all-black/all-white.
-  gl->ClearColor((idx & 255) / 255.0f, kWebVrPosePixelMagicNumbers[0] / 255.0f,
-                 kWebVrPosePixelMagicNumbers[1] / 255.0f, 1.0f);
-  gl->Clear(GL_COLOR_BUFFER_BIT);
-
-  // Set the GL state back to what was set by the WebVR application.
-  m_renderingContext->restoreScissorEnabled();
-  m_renderingContext->restoreScissorBox();
-  m_renderingContext->restoreColorMask();
-  m_renderingContext->restoreClearColor();
-
-  m_display->SubmitFrame(m_framePose.Clone());
+  // The frame is paired with its pose through the metadata sent along with
+  // it. The sync token tells the consumer when the GPU is done with the frame,
+  // so nothing is drawn into the frame to be read back and the WebGL state of
+  // the page is left alone.
+  auto metadata = device::mojom::blink::VRFrameMetadata::New();
+  if (m_framePose) {
+    metadata->poseIndex = m_framePose->poseIndex;
+    metadata->timestamp = m_framePose->timestamp;
+  }
+  metadata->syncToken.resize(GL_SYNC_TOKEN_SIZE_CHROMIUM);
+  const GLuint64 fenceSync = m_contextGL->InsertFenceSyncCHROMIUM();
+  m_contextGL->ShallowFlushCHROMIUM();
+  m_contextGL->GenSyncTokenCHROMIUM(
+      fenceSync, reinterpret_cast<GLbyte*>(metadata->syncToken.data()));
+
+  m_display->SubmitFrame(std::move(metadata));
   m_canUpdateFramePose = true;
 }
 
@@ -800,6 +1186,207 @@ void VRDisplay::OnDeactivate(
       EventTypeNames::vrdisplaydeactivate, true, false, this, reason));
 }
 
+void VRDisplay::OnPointCloudAvailable(double timestamp) {
+  // Stay subscribed while the page keeps waiting, so pages that wait in a
+  // loop do not subscribe again on every point cloud.
+  if (m_pointCloudResolvers.isEmpty()) {
+    if (m_pointCloudSubscribed && m_display) {
+      m_pointCloudSubscribed = false;
+      m_display->SetPointCloudSubscription(false, 0);
+    }
+    return;
+  }
+
+  while (!m_pointCloudResolvers.isEmpty()) {
+    ScriptPromiseResolver* resolver = m_pointCloudResolvers.takeFirst();
+    resolver->resolve(timestamp);
+  }
+}
+
+void VRDisplay::OnCameraFrameAvailable() {
+  m_cameraFrameAvailable = true;
+  // Run the frame that has been waiting for it in camera mode.
+  if (m_cameraFrameTimer.isActive())
+    requestDocumentAnimationFrame();
+}
+
+ScriptPromise VRDisplay::requestPointCloud(ScriptState* scriptState,
+                                           VRPointCloud* pointCloud,
+                                           bool justUpdatePointCloud,
+                                           unsigned pointsToSkip) {
+  ScriptPromiseResolver* resolver = ScriptPromiseResolver::create(scriptState);
+  ScriptPromise promise = resolver->promise();
+
+  if (!m_display) {
+    DOMException* exception =
+        DOMException::create(InvalidStateError, "VRService is not available.");
+    resolver->reject(exception);
+    return promise;
+  }
+
+  if (!m_maxNumberOfPointsInPointCloud) {
+    m_display->GetMaxNumberOfPointsInPointCloud(convertToBaseCallback(
+        WTF::bind(&VRDisplay::onMaxNumberOfPointsInPointCloud,
+                  wrapWeakPersistent(this))));
+  }
+  m_pendingRequestResolvers.add(resolver);
+  m_display->GetPointCloud(
+      justUpdatePointCloud, pointsToSkip,
+      convertToBaseCallback(WTF::bind(&VRDisplay::onPointCloud,
+                                      wrapPersistent(this),
+                                      wrapPersistent(resolver),
+                                      wrapPersistent(pointCloud))));
+  return promise;
+}
+
+void VRDisplay::onMaxNumberOfPointsInPointCloud(
+    unsigned maxNumberOfPointsInPointCloud) {
+  m_maxNumberOfPointsInPointCloud = maxNumberOfPointsInPointCloud;
+}
+
+void VRDisplay::onPointCloud(ScriptPromiseResolver* resolver,
+                             VRPointCloud* pointCloud,
+                             device::mojom::blink::VRPointCloudPtr mojoPointCloud) {
+  m_pendingRequestResolvers.remove(resolver);
+  pointCloud->setPointCloud(m_maxNumberOfPointsInPointCloud, mojoPointCloud);
+  resolver->resolve(pointCloud);
+}
+
+ScriptPromise VRDisplay::requestPickingPointAndPlaneInPointCloud(
+    ScriptState* scriptState,
+    float x,
+    float y) {
+  ScriptPromiseResolver* resolver = ScriptPromiseResolver::create(scriptState);
+  ScriptPromise promise = resolver->promise();
+
+  if (!m_display) {
+    DOMException* exception =
+        DOMException::create(InvalidStateError, "VRService is not available.");
+    resolver->reject(exception);
+    return promise;
+  }
+
+  m_pendingRequestResolvers.add(resolver);
+  m_display->GetPickingPointAndPlaneInPointCloud(
+      x, y, convertToBaseCallback(WTF::bind(&VRDisplay::onPickingPointAndPlane,
+                                            wrapPersistent(this),
+                                            wrapPersistent(resolver))));
+  return promise;
+}
+
+void VRDisplay::onPickingPointAndPlane(
+    ScriptPromiseResolver* resolver,
+    device::mojom::blink::VRPickingPointAndPlanePtr mojoPickingPointAndPlane) {
+  m_pendingRequestResolvers.remove(resolver);
+  if (mojoPickingPointAndPlane.is_null()) {
+    resolver->resolve(v8::Null(resolver->getScriptState()->isolate()));
+    return;
+  }
+  // Unlike getPickingPointAndPlaneInPointCloud every request gets its own
+  // object as several of them can be in flight.
+  VRPickingPointAndPlane* pickingPointAndPlane = new VRPickingPointAndPlane();
+  pickingPointAndPlane->setPickingPointAndPlane(mojoPickingPointAndPlane);
+  resolver->resolve(pickingPointAndPlane);
+}
+
+ScriptPromise VRDisplay::requestSeeThroughCamera(ScriptState* scriptState) {
+  ScriptPromiseResolver* resolver = ScriptPromiseResolver::create(scriptState);
+  ScriptPromise promise = resolver->promise();
+
+  if (!m_display) {
+    DOMException* exception =
+        DOMException::create(InvalidStateError, "VRService is not available.");
+    resolver->reject(exception);
+    return promise;
+  }
+
+  // The see through camera is pushed with the display info, there is nothing
+  // to wait for.
+  if (m_seeThroughCamera)
+    resolver->resolve(m_seeThroughCamera.get());
+  else
+    resolver->resolve(v8::Null(scriptState->isolate()));
+  return promise;
+}
+
+ScriptPromise VRDisplay::requestADFs(ScriptState* scriptState) {
+  ScriptPromiseResolver* resolver = ScriptPromiseResolver::create(scriptState);
+  ScriptPromise promise = resolver->promise();
+
+  if (!m_display) {
+    DOMException* exception =
+        DOMException::create(InvalidStateError, "VRService is not available.");
+    resolver->reject(exception);
+    return promise;
+  }
+
+  m_pendingRequestResolvers.add(resolver);
+  m_display->GetADFs(convertToBaseCallback(WTF::bind(
+      &VRDisplay::onADFs, wrapPersistent(this), wrapPersistent(resolver))));
+  return promise;
+}
+
+void VRDisplay::onADFs(ScriptPromiseResolver* resolver,
+                       Vector<device::mojom::blink::VRADFPtr> mojomADFs) {
+  m_pendingRequestResolvers.remove(resolver);
+  HeapVector<Member<VRADF>> adfs(mojomADFs.size());
+  for (size_t i = 0; i < mojomADFs.size(); i++) {
+    VRADF* adf = new VRADF();
+    adf->setADF(mojomADFs[i]);
+    adfs[i] = adf;
+  }
+  resolver->resolve(adfs);
+}
+
+ScriptPromise VRDisplay::configureSensors(
+    ScriptState* scriptState,
+    const VRSensorConfiguration& configuration) {
+  ScriptPromiseResolver* resolver = ScriptPromiseResolver::create(scriptState);
+  ScriptPromise promise = resolver->promise();
+
+  if (!m_display) {
+    DOMException* exception =
+        DOMException::create(InvalidStateError, "VRService is not available.");
+    resolver->reject(exception);
+    return promise;
+  }
+
+  device::mojom::blink::VRSensorConfigurationPtr mojoConfiguration =
+      device::mojom::blink::VRSensorConfiguration::New();
+  mojoConfiguration->depthFramerate = configuration.depthFramerate();
+  mojoConfiguration->maxNumberOfPointsInPointCloud =
+      configuration.maxNumberOfPointsInPointCloud();
+  mojoConfiguration->cameraImageWidth = configuration.cameraImageWidth();
+  mojoConfiguration->cameraImageHeight = configuration.cameraImageHeight();
+  m_pendingRequestResolvers.add(resolver);
+  m_display->ConfigureSensors(
+      std::move(mojoConfiguration),
+      convertToBaseCallback(WTF::bind(&VRDisplay::onSensorsConfigured,
+                                      wrapPersistent(this),
+                                      wrapPersistent(resolver))));
+  return promise;
+}
+
+void VRDisplay::onSensorsConfigured(ScriptPromiseResolver* resolver,
+                                    bool success,
+                                    const String& errorMessage) {
+  m_pendingRequestResolvers.remove(resolver);
+  if (!success) {
+    resolver->reject(DOMException::create(NotSupportedError, errorMessage));
+    return;
+  }
+  // The maximum number of points may have changed.
+  m_maxNumberOfPointsInPointCloud = 0;
+  resolver->resolve();
+}
+
+void VRDisplay::OnTrackingStateChanged(bool tracking) {
+  while (!m_trackingStateResolvers.isEmpty()) {
+    ScriptPromiseResolver* resolver = m_trackingStateResolvers.takeFirst();
+    resolver->resolve(tracking);
+  }
+}
+
 void VRDisplay::onFullscreenCheck(TimerBase*) {
   if (!m_isPresenting) {
     m_fullscreenCheckTimer.stop();
@@ -858,7 +1445,37 @@ const AtomicString& VRDisplay::interfaceName() const {
 
 void VRDisplay::contextDestroyed(ExecutionContext*) {
   forceExitPresent();
+  disableAdaptiveResolution();
+  m_cameraFrameTimer.stop();
   m_scriptedAnimationController.clear();
+  rejectPendingResolvers();
+}
+
+void VRDisplay::onConnectionError() {
+  // The replies of the pending requests are dropped with the connection.
+  m_display.reset();
+  m_pointCloudSubscribed = false;
+  rejectPendingResolvers();
+}
+
+void VRDisplay::rejectPendingResolvers() {
+  HeapHashSet<Member<ScriptPromiseResolver>> pendingRequestResolvers;
+  pendingRequestResolvers.swap(m_pendingRequestResolvers);
+  for (ScriptPromiseResolver* resolver : pendingRequestResolvers) {
+    resolver->reject(
+        DOMException::create(InvalidStateError, "VRService is not available."));
+  }
+  // No more notifications will arrive either.
+  HeapDeque<Member<ScriptPromiseResolver>>* waitingResolvers[] = {
+      &m_pointCloudResolvers, &m_trackingStateResolvers,
+      &m_connectionStateResolvers};
+  for (HeapDeque<Member<ScriptPromiseResolver>>* resolvers : waitingResolvers) {
+    while (!resolvers->isEmpty()) {
+      ScriptPromiseResolver* resolver = resolvers->takeFirst();
+      resolver->reject(DOMException::create(InvalidStateError,
+                                            "VRService is not available."));
+    }
+  }
 }
 
 bool VRDisplay::hasPendingActivity() const {
@@ -878,7 +1495,12 @@ DEFINE_TRACE(VRDisplay) {
   visitor->trace(m_layer);
   visitor->trace(m_renderingContext);
   visitor->trace(m_scriptedAnimationController);
+  visitor->trace(m_adaptiveResolution);
   visitor->trace(m_pendingPresentResolvers);
+  visitor->trace(m_pointCloudResolvers);
+  visitor->trace(m_trackingStateResolvers);
+  visitor->trace(m_connectionStateResolvers);
+  visitor->trace(m_pendingRequestResolvers);
 }
 
 }  // namespace blink
@@ -27,8 +27,12 @@ class GLES2Interface;
 
 namespace blink {
 
+class ExceptionState;
+class HTMLCanvasElement;
 class NavigatorVR;
 class ScriptedAnimationController;
+class VRAdaptiveResolution;
+class VRAdaptiveResolutionConfiguration;
 class VRController;
 class VREyeParameters;
 class VRFrameData;
@@ -38,11 +42,21 @@ class VRPointCloud;
 class VRPickingPointAndPlane;
 class VRSeeThroughCamera;
 class VRADF;
+class VRSensorConfiguration;
 
 class WebGLRenderingContextBase;
 
 enum VREye { VREyeNone, VREyeLeft, VREyeRight };
 
+// When the animation frame callbacks run: at the display rate, only when
+// there is a new camera frame, or at the display rate with the latest pose
+// in between camera frames.
+enum VRAnimationFrameMode {
+  VRAnimationFrameModeDisplay,
+  VRAnimationFrameModeCamera,
+  VRAnimationFrameModeInterpolated
+};
+
 class VRDisplay final : public EventTargetWithInlineData,
                         public ActiveScriptWrappable<VRDisplay>,
                         public ContextLifecycleObserver,
@@ -61,6 +75,10 @@ class VRDisplay final : public EventTargetWithInlineData,
   VRStageParameters* stageParameters() const { return m_stageParameters; }
 
   bool isConnected() const { return m_isConnected; }
+  // "connected", "connecting", "disconnected" or "failed". The error is only
+  // set while failed.
+  const String& connectionState() const { return m_connectionState; }
+  const String& connectionError() const { return m_connectionError; }
   bool isPresenting() const { return m_isPresenting; }
 
   bool getFrameData(VRFrameData*);
@@ -70,11 +88,50 @@ class VRDisplay final : public EventTargetWithInlineData,
   unsigned getMaxNumberOfPointsInPointCloud();
   void getPointCloud(VRPointCloud* pointCloud, bool justUpdatePointCloud, unsigned pointsToSkip);
   VRPickingPointAndPlane* getPickingPointAndPlaneInPointCloud(float x, float y);
+  // Write the picked point (3 values) and plane (4 values) into a
+  // Float32Array or Float64Array of the caller at offset, so picking in a
+  // loop does not allocate any JavaScript object. The single version leaves
+  // the results untouched on a miss, the batched one picks each (x, y) pair
+  // of coordinates in a single round trip, writes NaN for the misses and
+  // returns the number of hits.
+  bool getPickingPointAndPlaneInPointCloudInto(float x,
+                                               float y,
+                                               DOMArrayBufferView* result,
+                                               unsigned offset,
+                                               ExceptionState&);
+  unsigned getPickingPointsAndPlanesInPointCloud(DOMFloat32Array* coordinates,
+                                                 DOMArrayBufferView* results,
+                                                 unsigned offset,
+                                                 ExceptionState&);
   VRSeeThroughCamera* getSeeThroughCamera();
   HeapVector<Member<VRADF>> getADFs();
   void enableADF(const String&);
   void disableADF();
 
+  // Resolved with the timestamp of the next point cloud and with the new
+  // tracking state, so pages do not need to poll for them.
+  ScriptPromise waitForPointCloud(ScriptState*);
+  ScriptPromise waitForTrackingStateChange(ScriptState*);
+  // Resolved with the new connectionState.
+  ScriptPromise waitForConnectionStateChange(ScriptState*);
+
+  // Asynchronous versions of the queries above. They do not block the main
+  // thread so a page can ask early in a frame and use the results later on.
+  // The point cloud is written into the given VRPointCloud.
+  ScriptPromise requestPointCloud(ScriptState*,
+                                  VRPointCloud*,
+                                  bool justUpdatePointCloud,
+                                  unsigned pointsToSkip);
+  ScriptPromise requestPickingPointAndPlaneInPointCloud(ScriptState*,
+                                                        float x,
+                                                        float y);
+  ScriptPromise requestSeeThroughCamera(ScriptState*);
+  ScriptPromise requestADFs(ScriptState*);
+
+  // Chooses the depth framerate, the maximum number of points and the camera
+  // resolution. Rejected if the device does not support the configuration.
+  ScriptPromise configureSensors(ScriptState*, const VRSensorConfiguration&);
+
   double depthNear() const { return m_depthNear; }
   double depthFar() const { return m_depthFar; }
 
@@ -87,6 +144,19 @@ class VRDisplay final : public EventTargetWithInlineData,
   void cancelAnimationFrame(int id);
   void serviceScriptedAnimations(double monotonicAnimationStartTime);
 
+  String animationFrameMode() const;
+  void setAnimationFrameMode(const String&);
+
+  // Measures the GPU time of the animation frames rendered into the canvas
+  // and lowers renderScale while they go over the budget. The page applies
+  // renderScale to the size of its drawing buffer. renderScale is 1 while the
+  // adaptive resolution is disabled.
+  void enableAdaptiveResolution(HTMLCanvasElement*,
+                                const VRAdaptiveResolutionConfiguration&,
+                                ExceptionState&);
+  void disableAdaptiveResolution();
+  double renderScale() const;
+
   ScriptPromise requestPresent(ScriptState*, const HeapVector<VRLayer>& layers);
   ScriptPromise exitPresent(ScriptState*);
 
@@ -118,6 +188,9 @@ class VRDisplay final : public EventTargetWithInlineData,
   void update(const device::mojom::blink::VRDisplayInfoPtr&);
 
   void updatePose();
+  bool updateFrameState();
+  device::mojom::blink::VRPickingPointAndPlanePtr pickPointAndPlane(float x,
+                                                                    float y);
 
   void beginPresent();
   void forceExitPresent();
@@ -129,6 +202,8 @@ class VRDisplay final : public EventTargetWithInlineData,
 
  private:
   void onFullscreenCheck(TimerBase*);
+  void onCameraFrameTimeout(TimerBase*);
+  void requestDocumentAnimationFrame();
   void onPresentComplete(bool);
 
   void onConnected();
@@ -136,6 +211,22 @@ class VRDisplay final : public EventTargetWithInlineData,
 
   void OnPresentChange();
 
+  void onMaxNumberOfPointsInPointCloud(unsigned maxNumberOfPointsInPointCloud);
+  void onPointCloud(ScriptPromiseResolver*,
+                    VRPointCloud*,
+                    device::mojom::blink::VRPointCloudPtr);
+  void onPickingPointAndPlane(ScriptPromiseResolver*,
+                              device::mojom::blink::VRPickingPointAndPlanePtr);
+  void onADFs(ScriptPromiseResolver*, Vector<device::mojom::blink::VRADFPtr>);
+  void onSensorsConfigured(ScriptPromiseResolver*,
+                           bool success,
+                           const String& errorMessage);
+
+  void onConnectionError();
+  // Rejects the promises still waiting for the device, which will not
+  // answer anymore.
+  void rejectPendingResolvers();
+
   // VRDisplayClient
   void OnChanged(device::mojom::blink::VRDisplayInfoPtr) override;
   void OnExitPresent() override;
@@ -143,6 +234,9 @@ class VRDisplay final : public EventTargetWithInlineData,
   void OnFocus() override;
   void OnActivate(device::mojom::blink::VRDisplayEventReason) override;
   void OnDeactivate(device::mojom::blink::VRDisplayEventReason) override;
+  void OnPointCloudAvailable(double timestamp) override;
+  void OnCameraFrameAvailable() override;
+  void OnTrackingStateChanged(bool tracking) override;
 
   ScriptedAnimationController& ensureScriptedAnimationController(Document*);
 
@@ -150,6 +244,8 @@ class VRDisplay final : public EventTargetWithInlineData,
   unsigned m_displayId;
   String m_displayName;
   bool m_isConnected;
+  String m_connectionState;
+  String m_connectionError;
   bool m_isPresenting;
   bool m_isValidDeviceForPresenting;
   bool m_canUpdateFramePose;
@@ -159,6 +255,13 @@ class VRDisplay final : public EventTargetWithInlineData,
   Member<VREyeParameters> m_eyeParametersRight;
   device::mojom::blink::VRPosePtr m_framePose;
 
+  // Inside an animation frame all the per frame data comes from a single
+  // GetFrameState call. What is requested is what the page used in the
+  // previous frame.
+  device::mojom::blink::VRFrameStateRequestPtr m_nextFrameStateRequest;
+  device::mojom::blink::VRFrameStateRequestPtr m_frameStateRequest;
+  device::mojom::blink::VRFrameStatePtr m_frameState;
+
   Member<VRPickingPointAndPlane> m_pickingPointAndPlane;
   Member<VRSeeThroughCamera> m_seeThroughCamera;
   Member<DOMFloat32Array> m_poseMatrix;
@@ -178,6 +281,17 @@ class VRDisplay final : public EventTargetWithInlineData,
   Member<ScriptedAnimationController> m_scriptedAnimationController;
   bool m_animationCallbackRequested;
   bool m_inAnimationFrame;
+  VRAnimationFrameMode m_animationFrameMode;
+  // Set by OnCameraFrameAvailable, cleared by each animation frame.
+  bool m_cameraFrameAvailable;
+  // Whether the frame state of the current animation frame asks for the
+  // latest pose (interpolated mode in between camera frames).
+  bool m_useLatestPose;
+  // Runs the animation frame anyway if a camera frame does not arrive in
+  // time, so the camera mode does not stall with a device that does not
+  // notify them.
+  Timer<VRDisplay> m_cameraFrameTimer;
+  Member<VRAdaptiveResolution> m_adaptiveResolution;
   bool m_displayBlurred;
   bool m_reenteredFullscreen;
 
@@ -186,6 +300,18 @@ class VRDisplay final : public EventTargetWithInlineData,
   mojo::Binding<device::mojom::blink::VRDisplayClient> m_binding;
 
   HeapDeque<Member<ScriptPromiseResolver>> m_pendingPresentResolvers;
+
+  bool m_pointCloudSubscribed;
+  // Fetched along with the first requestPointCloud, the replies of a display
+  // arrive in order so it is known by the time the point cloud arrives.
+  unsigned m_maxNumberOfPointsInPointCloud;
+  HeapDeque<Member<ScriptPromiseResolver>> m_pointCloudResolvers;
+  HeapDeque<Member<ScriptPromiseResolver>> m_trackingStateResolvers;
+  HeapDeque<Member<ScriptPromiseResolver>> m_connectionStateResolvers;
+  // The requests waiting for a reply from the device: requestPointCloud,
+  // requestPickingPointAndPlaneInPointCloud, requestADFs and
+  // configureSensors.
+  HeapHashSet<Member<ScriptPromiseResolver>> m_pendingRequestResolvers;
 };
 
 using VRDisplayVector = HeapVector<Member<VRDisplay>>;
@@ -4,7 +4,7 @@
 
 #include "modules/vr/VRPointCloud.h"
 
-#include <float.h>
+#include <algorithm>
 
 namespace blink {
 
@@ -20,7 +20,7 @@ namespace {
 
 } // namespace
 
-VRPointCloud::VRPointCloud(): m_numberOfPoints(0), m_lastNumberOfPoints(0)
+VRPointCloud::VRPointCloud(): m_numberOfPoints(0), m_generation(0)
 {
 }
 
@@ -34,29 +34,31 @@ DOMFloat32Array* VRPointCloud::points() const
     return m_points;
 }
 
+unsigned int VRPointCloud::generation() const
+{
+    return m_generation;
+}
+
 void VRPointCloud::setPointCloud(unsigned maxNumberOfPoints, device::mojom::blink::VRPointCloudPtr& pointCloudPtr)
 {
-	if (!m_points)
+	// The maximum number of points changes with VRDisplay.configureSensors.
+	if (!m_points || m_points->length() != maxNumberOfPoints * 3)
 	{
 		m_points = DOMFloat32Array::create(maxNumberOfPoints * 3);
-		std::fill_n(m_points->data(), m_numberOfPoints, std::numeric_limits<float>::max());
 	}
-	if (pointCloudPtr.is_null())
+	unsigned numberOfPoints = 0;
+	if (!pointCloudPtr.is_null())
 	{
-		m_numberOfPoints = 0;
-	}
-	else
-	{
-		m_numberOfPoints = pointCloudPtr->numberOfPoints;
-		if (m_numberOfPoints > 0) {
-			memcpy(m_points->data(), &(pointCloudPtr->points.front()), m_numberOfPoints * 3 * sizeof(float));
+		// Only the live points are sent, never trust the count more than
+		// the points themselves.
+		numberOfPoints = std::min(pointCloudPtr->numberOfPoints, maxNumberOfPoints);
+		numberOfPoints = std::min<size_t>(numberOfPoints, pointCloudPtr->points.size() / 3);
+		if (numberOfPoints > 0) {
+			memcpy(m_points->data(), &(pointCloudPtr->points.front()), numberOfPoints * 3 * sizeof(float));
 		}
 	}
-	if (m_numberOfPoints < m_lastNumberOfPoints)
-	{
-		std::fill_n(m_points->data() + (m_numberOfPoints * 3), (m_lastNumberOfPoints - m_numberOfPoints) * 3, std::numeric_limits<float>::max());
-	}
-	m_lastNumberOfPoints = m_numberOfPoints;
+	m_numberOfPoints = numberOfPoints;
+	m_generation++;
 }
 
 DEFINE_TRACE(VRPointCloud)
@@ -21,7 +21,14 @@ public:
     VRPointCloud();
 
     unsigned int numberOfPoints() const;
+    // A view of the maximum number of points. It is allocated once and
+    // reused by every update, only the first numberOfPoints points are
+    // valid, the rest are left over from previous updates. A renderer keeps
+    // the view and uses numberOfPoints as its draw range. A new view is only
+    // allocated when the maximum number of points changes.
     DOMFloat32Array* points() const;
+    // Changes with every update of the point cloud.
+    unsigned int generation() const;
 
     void setPointCloud(unsigned maxNumberOfPoints, device::mojom::blink::VRPointCloudPtr& pointCloudPtr);
 
@@ -29,7 +36,7 @@ public:
 
 private:
     unsigned long m_numberOfPoints;
-    unsigned long m_lastNumberOfPoints;
+    unsigned long m_generation;
     Member<DOMFloat32Array> m_points;
 };
 
@@ -4,6 +4,8 @@
 
 #include "modules/vr/VRSeeThroughCamera.h"
 
+#include <algorithm>
+
 namespace blink {
 
 VRSeeThroughCamera::VRSeeThroughCamera(): m_width(0)
@@ -15,6 +17,15 @@ VRSeeThroughCamera::VRSeeThroughCamera(): m_width(0)
 	, m_pointX(0)
 	, m_pointY(0)
 	, m_orientation(0)
+	, m_frameId(0)
+	, m_rotatedWidth(0)
+	, m_rotatedHeight(0)
+	, m_rotatedFocalLengthX(0)
+	, m_rotatedFocalLengthY(0)
+	, m_rotatedPointX(0)
+	, m_rotatedPointY(0)
+	, m_undistortionLUTWidth(0)
+	, m_undistortionLUTHeight(0)
 {
 }
 
@@ -63,6 +74,57 @@ long VRSeeThroughCamera::orientation()
 	return m_orientation;
 }
 
+unsigned long VRSeeThroughCamera::frameId() const
+{
+	return m_frameId;
+}
+
+unsigned long VRSeeThroughCamera::undistortionLUTWidth() const
+{
+	return m_undistortionLUTWidth;
+}
+
+unsigned long VRSeeThroughCamera::undistortionLUTHeight() const
+{
+	return m_undistortionLUTHeight;
+}
+
+DOMFloat32Array* VRSeeThroughCamera::undistortionLUT() const
+{
+	return m_undistortionLUT;
+}
+
+DOMFloat32Array* VRSeeThroughCamera::getProjectionMatrix(float depthNear, float depthFar) const
+{
+	if (!m_rotatedWidth || !m_rotatedHeight || depthNear == depthFar)
+		return nullptr;
+
+	double width = m_rotatedWidth;
+	double height = m_rotatedHeight;
+	double xScale = depthNear / m_rotatedFocalLengthX;
+	double yScale = depthNear / m_rotatedFocalLengthY;
+	double xOffset = (m_rotatedPointX - (width / 2.0)) * xScale;
+	// The color camera coordinates have Y pointing downwards.
+	double yOffset = -(m_rotatedPointY - (height / 2.0)) * yScale;
+
+	double left = xScale * -width / 2.0 - xOffset;
+	double right = xScale * width / 2.0 - xOffset;
+	double bottom = yScale * -height / 2.0 - yOffset;
+	double top = yScale * height / 2.0 - yOffset;
+
+	DOMFloat32Array* matrix = DOMFloat32Array::create(16);
+	float* m = matrix->data();
+	std::fill_n(m, 16, 0.0f);
+	m[0] = 2.0 * depthNear / (right - left);
+	m[5] = 2.0 * depthNear / (top - bottom);
+	m[8] = (right + left) / (right - left);
+	m[9] = (top + bottom) / (top - bottom);
+	m[10] = -(depthFar + depthNear) / (depthFar - depthNear);
+	m[11] = -1.0f;
+	m[14] = -2.0 * depthFar * depthNear / (depthFar - depthNear);
+	return matrix;
+}
+
 void VRSeeThroughCamera::setSeeThroughCamera(const device::mojom::blink::VRSeeThroughCameraPtr& seeThroughCameraPtr)
 {
 	m_width = seeThroughCameraPtr->width;
@@ -74,10 +136,29 @@ void VRSeeThroughCamera::setSeeThroughCamera(const device::mojom::blink::VRSeeTh
 	m_pointX = seeThroughCameraPtr->pointX;
 	m_pointY = seeThroughCameraPtr->pointY;
 	m_orientation = seeThroughCameraPtr->orientation;
+	m_rotatedWidth = seeThroughCameraPtr->rotatedWidth;
+	m_rotatedHeight = seeThroughCameraPtr->rotatedHeight;
+	m_rotatedFocalLengthX = seeThroughCameraPtr->rotatedFocalLengthX;
+	m_rotatedFocalLengthY = seeThroughCameraPtr->rotatedFocalLengthY;
+	m_rotatedPointX = seeThroughCameraPtr->rotatedPointX;
+	m_rotatedPointY = seeThroughCameraPtr->rotatedPointY;
+	m_undistortionLUTWidth = seeThroughCameraPtr->undistortionLUTWidth;
+	m_undistortionLUTHeight = seeThroughCameraPtr->undistortionLUTHeight;
+	// The lookup table only changes along with the intrinsics so it is fine
+	// to create a new array every time they are updated.
+	if (seeThroughCameraPtr->undistortionLUT.isEmpty())
+	{
+		m_undistortionLUT = nullptr;
+	}
+	else
+	{
+		m_undistortionLUT = DOMFloat32Array::create(seeThroughCameraPtr->undistortionLUT.data(), seeThroughCameraPtr->undistortionLUT.size());
+	}
 }
 
 DEFINE_TRACE(VRSeeThroughCamera)
 {
+	visitor->trace(m_undistortionLUT);
 }
 
 } // namespace blink
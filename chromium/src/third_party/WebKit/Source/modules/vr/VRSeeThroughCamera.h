@@ -6,7 +6,9 @@
 #define VRSeeThroughCamera_h
 
 #include "bindings/core/v8/ScriptWrappable.h"
+#include "core/dom/DOMTypedArray.h"
 #include "device/vr/vr_service.mojom-blink.h"
+#include "platform/heap/Handle.h"
 
 namespace blink {
 
@@ -24,8 +26,17 @@ public:
     double pointX() const;
     double pointY() const;
     long orientation();
+    unsigned long frameId() const;
+    unsigned long undistortionLUTWidth() const;
+    unsigned long undistortionLUTHeight() const;
+    DOMFloat32Array* undistortionLUT() const;
+
+    // Returns a column major projection matrix that matches the camera
+    // image for the current display rotation.
+    DOMFloat32Array* getProjectionMatrix(float depthNear, float depthFar) const;
 
     void setSeeThroughCamera(const device::mojom::blink::VRSeeThroughCameraPtr&);
+    void setFrameId(unsigned long frameId) { m_frameId = frameId; }
 
     DECLARE_VIRTUAL_TRACE()
 private:
@@ -38,6 +49,17 @@ private:
     double m_pointX;
     double m_pointY;
     long m_orientation;
+    // The id of the camera frame that matches the latest pose.
+    unsigned long m_frameId;
+    unsigned long m_rotatedWidth;
+    unsigned long m_rotatedHeight;
+    double m_rotatedFocalLengthX;
+    double m_rotatedFocalLengthY;
+    double m_rotatedPointX;
+    double m_rotatedPointY;
+    unsigned long m_undistortionLUTWidth;
+    unsigned long m_undistortionLUTHeight;
+    Member<DOMFloat32Array> m_undistortionLUT;
 };
 
 } // namespace blink
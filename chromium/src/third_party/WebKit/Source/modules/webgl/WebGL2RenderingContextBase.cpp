@@ -315,6 +315,31 @@ void WebGL2RenderingContextBase::bufferSubData(
   WebGLRenderingContextBase::bufferSubData(target, offset, data);
 }
 
+void WebGL2RenderingContextBase::bufferSubData(GLenum target,
+                                               long long offset,
+                                               VRPointCloud* pointCloud) {
+  WebGLRenderingContextBase::bufferSubData(target, offset, pointCloud);
+}
+
+void WebGL2RenderingContextBase::latchPose(GLenum target,
+                                           long long offset,
+                                           bool cameraFrame) {
+  if (isContextLost())
+    return;
+  WebGLBuffer* buffer = validateBufferDataTarget("latchPose", target);
+  if (!buffer)
+    return;
+  if (!validateValueFitNonNegInt32("latchPose", "offset", offset))
+    return;
+  const long long latchedPoseSize = 32 * sizeof(GLfloat);
+  if (offset + latchedPoseSize > buffer->getSize()) {
+    synthesizeGLError(GL_INVALID_VALUE, "latchPose", "buffer overflow");
+    return;
+  }
+  contextGL()->BufferSubDataLatchedPose(target, static_cast<GLintptr>(offset),
+                                        cameraFrame ? GL_TRUE : GL_FALSE);
+}
+
 void WebGL2RenderingContextBase::copyBufferSubData(GLenum readTarget,
                                                    GLenum writeTarget,
                                                    long long readOffset,
@@ -43,9 +43,17 @@ class WebGL2RenderingContextBase : public WebGLRenderingContextBase {
   void bufferSubData(GLenum target,
                      long long offset,
                      const FlexibleArrayBufferView& data);
+  void bufferSubData(GLenum target, long long offset, VRPointCloud*);
 
   void copyBufferSubData(GLenum, GLenum, long long, long long, long long);
   void getBufferSubData(GLenum, long long, DOMArrayBufferView*, GLuint, GLuint);
+  // Writes the pose matrix and the view matrix (two column major mat4, 128
+  // bytes) into the bound buffer at offset, with the pose the GPU process has
+  // when it reaches this call instead of the one of the start of the frame.
+  // Meant for a uniform buffer read by the draw calls that follow. With
+  // cameraFrame the pose is the one of the latest camera frame, and the
+  // camera texture or underlay updates with a frame id of 0 use that frame.
+  void latchPose(GLenum target, long long offset, bool cameraFrame);
 
   void registerGetBufferSubDataAsyncCallback(
       WebGLGetBufferSubDataAsyncCallback*);
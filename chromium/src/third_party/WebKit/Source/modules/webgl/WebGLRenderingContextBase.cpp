@@ -1093,7 +1093,6 @@ WebGLRenderingContextBase::WebGLRenderingContextBase(
       m_isWebGLDepthTextureFormatsTypesAdded(false),
       m_isEXTsRGBFormatsTypesAdded(false),
       m_cameraImageRGB(0),
-      m_cameraImageTextureId(0),
       m_version(version) {
   ASSERT(contextProvider);
 
@@ -1808,6 +1807,16 @@ void WebGLRenderingContextBase::bindTexture(GLenum target,
   } else if (isWebGL2OrHigher() && target == GL_TEXTURE_3D) {
     m_textureUnits[m_activeTextureUnit].m_texture3DBinding =
         TraceWrapperMember<WebGLTexture>(this, texture);
+  } else if (target == GL_TEXTURE_EXTERNAL_OES) {
+    // Only the textures created with createCameraTexture have this target
+    // before their first bind.
+    if (texture && texture->getTarget() != GL_TEXTURE_EXTERNAL_OES) {
+      synthesizeGLError(GL_INVALID_OPERATION, "bindTexture",
+                        "not a camera texture");
+      return;
+    }
+    m_textureUnits[m_activeTextureUnit].m_textureExternalOESBinding =
+        TraceWrapperMember<WebGLTexture>(this, texture);
   } else {
     synthesizeGLError(GL_INVALID_ENUM, "bindTexture", "invalid target");
     return;
@@ -1834,9 +1843,6 @@ void WebGLRenderingContextBase::bindTexture(GLenum target,
   // platforms is fairly involved (will require a HashMap from texture ID
   // in all ports), and we have not had any complaints, so the logic has
   // been removed.
-
-  m_cameraImageTextureId = objectOrZero(texture);
-
 }
 
 void WebGLRenderingContextBase::blendColor(GLfloat red,
@@ -1968,6 +1974,30 @@ void WebGLRenderingContextBase::bufferSubData(
                     data.baseAddressMaybeOnStack());
 }
 
+void WebGLRenderingContextBase::bufferSubData(GLenum target,
+                                              long long offset,
+                                              VRPointCloud* pointCloud) {
+  if (isContextLost())
+    return;
+  DCHECK(pointCloud);
+  WebGLBuffer* buffer = validateBufferDataTarget("bufferSubData", target);
+  if (!buffer)
+    return;
+  if (!validateValueFitNonNegInt32("bufferSubData", "offset", offset))
+    return;
+  if (offset > buffer->getSize()) {
+    synthesizeGLError(GL_INVALID_VALUE, "bufferSubData", "buffer overflow");
+    return;
+  }
+  // Only whole points are written.
+  const long long pointSize = 3 * sizeof(GLfloat);
+  long long size = (buffer->getSize() - offset) / pointSize * pointSize;
+  if (!size)
+    return;
+  contextGL()->BufferSubDataPointCloud(target, static_cast<GLintptr>(offset),
+                                       static_cast<GLsizeiptr>(size));
+}
+
 bool WebGLRenderingContextBase::validateFramebufferTarget(GLenum target) {
   if (target == GL_FRAMEBUFFER)
     return true;
@@ -2228,6 +2258,16 @@ WebGLTexture* WebGLRenderingContextBase::createTexture() {
   return WebGLTexture::create(this);
 }
 
+WebGLTexture* WebGLRenderingContextBase::createCameraTexture() {
+  if (isContextLost())
+    return nullptr;
+  WebGLTexture* texture = WebGLTexture::create(this);
+  // The target is final once set, so the texture can never be bound to (and
+  // be mistaken for) a TEXTURE_2D.
+  texture->setTarget(GL_TEXTURE_EXTERNAL_OES);
+  return texture;
+}
+
 WebGLProgram* WebGLRenderingContextBase::createProgram() {
   if (isContextLost())
     return nullptr;
@@ -2348,6 +2388,10 @@ void WebGLRenderingContextBase::deleteTexture(WebGLTexture* texture) {
         maxBoundTextureIndex = i;
       }
     }
+    if (texture == m_textureUnits[i].m_textureExternalOESBinding) {
+      m_textureUnits[i].m_textureExternalOESBinding = nullptr;
+      maxBoundTextureIndex = i;
+    }
   }
   if (m_framebufferBinding)
     m_framebufferBinding->removeAttachmentFromBoundFramebuffer(GL_FRAMEBUFFER,
@@ -3141,6 +3185,9 @@ ScriptValue WebGLRenderingContextBase::getParameter(ScriptState* scriptState,
       return WebGLAny(
           scriptState,
           m_textureUnits[m_activeTextureUnit].m_textureCubeMapBinding.get());
+    case GL_TEXTURE_BINDING_EXTERNAL_OES:
+      return WebGLAny(scriptState, m_textureUnits[m_activeTextureUnit]
+                                       .m_textureExternalOESBinding.get());
     case GL_UNPACK_ALIGNMENT:
       return getIntParameter(scriptState, pname);
     case GC3D_UNPACK_FLIP_Y_WEBGL:
@@ -4866,11 +4913,36 @@ void WebGLRenderingContextBase::texImageHelperVRSeeThroughCamera(
   GLint zoffset, 
   VRSeeThroughCamera* seeThroughCamera)
 {
-  if (m_cameraImageTextureId != 0) 
-  {
-    contextGL()->UpdateTextureExternalOes(m_cameraImageTextureId);
-    // contextGL()->Finish();
+  updateCameraTextureHelper(getTexImageFunctionName(functionID), target,
+                            seeThroughCamera ? seeThroughCamera->frameId() : 0);
+}
+
+void WebGLRenderingContextBase::updateCameraTextureHelper(
+    const char* funcName,
+    GLenum target,
+    GLuint cameraFrameId) {
+  if (isContextLost())
+    return;
+  // The camera image is written into the texture bound to the target, like
+  // any other texImage2D. It is an external image, a 2D texture cannot hold
+  // it.
+  if (target == GL_TEXTURE_2D) {
+    synthesizeGLError(GL_INVALID_OPERATION, funcName,
+                      "the camera image needs a TEXTURE_EXTERNAL_OES texture");
+    return;
+  }
+  if (target != GL_TEXTURE_EXTERNAL_OES) {
+    synthesizeGLError(GL_INVALID_ENUM, funcName, "invalid texture target");
+    return;
+  }
+  WebGLTexture* texture =
+      m_textureUnits[m_activeTextureUnit].m_textureExternalOESBinding.get();
+  if (!texture) {
+    synthesizeGLError(GL_INVALID_OPERATION, funcName,
+                      "no texture bound to target");
+    return;
   }
+  contextGL()->UpdateTextureExternalOes(texture->object(), cameraFrameId);
 }
 
 void WebGLRenderingContextBase::texImage2D(GLenum target, 
@@ -4883,6 +4955,17 @@ void WebGLRenderingContextBase::texImage2D(GLenum target,
   texImageHelperVRSeeThroughCamera(TexImage2D, target, level, internalformat, 0, format, type, 1, 0, 0, 0, seeThroughCamera);
 }
 
+void WebGLRenderingContextBase::updateCameraTexture(GLenum target,
+                                                    GLuint cameraFrameId) {
+  updateCameraTextureHelper("updateCameraTexture", target, cameraFrameId);
+}
+
+void WebGLRenderingContextBase::updateCameraUnderlay(GLuint cameraFrameId) {
+  if (isContextLost())
+    return;
+  contextGL()->UpdateCameraUnderlay(cameraFrameId);
+}
+
 void WebGLRenderingContextBase::texImageHelperHTMLImageElement(
     TexImageFunctionID functionID,
     GLenum target,
@@ -6346,6 +6429,8 @@ void WebGLRenderingContextBase::visitChildDOMWrappers(
         wrapper, unit.m_texture3DBinding, isolate);
     DOMWrapperWorld::setWrapperReferencesInAllWorlds(
         wrapper, unit.m_texture2DArrayBinding, isolate);
+    DOMWrapperWorld::setWrapperReferencesInAllWorlds(
+        wrapper, unit.m_textureExternalOESBinding, isolate);
   }
 
   DOMWrapperWorld::setWrapperReferencesInAllWorlds(
@@ -6609,6 +6694,10 @@ WebGLTexture* WebGLRenderingContextBase::validateTextureBinding(
       }
       tex = m_textureUnits[m_activeTextureUnit].m_texture2DArrayBinding.get();
       break;
+    case GL_TEXTURE_EXTERNAL_OES:
+      tex = m_textureUnits[m_activeTextureUnit]
+                .m_textureExternalOESBinding.get();
+      break;
     default:
       synthesizeGLError(GL_INVALID_ENUM, functionName,
                         "invalid texture target");
@@ -7775,7 +7864,8 @@ void WebGLRenderingContextBase::findNewMaxNonDefaultTextureUnit() {
   int startIndex = m_onePlusMaxNonDefaultTextureUnit - 1;
   for (int i = startIndex; i >= 0; --i) {
     if (m_textureUnits[i].m_texture2DBinding ||
-        m_textureUnits[i].m_textureCubeMapBinding) {
+        m_textureUnits[i].m_textureCubeMapBinding ||
+        m_textureUnits[i].m_textureExternalOESBinding) {
       m_onePlusMaxNonDefaultTextureUnit = i + 1;
       return;
     }
@@ -7788,6 +7878,7 @@ DEFINE_TRACE(WebGLRenderingContextBase::TextureUnitState) {
   visitor->trace(m_textureCubeMapBinding);
   visitor->trace(m_texture3DBinding);
   visitor->trace(m_texture2DArrayBinding);
+  visitor->trace(m_textureExternalOESBinding);
 }
 
 DEFINE_TRACE(WebGLRenderingContextBase) {
@@ -7817,6 +7908,7 @@ DEFINE_TRACE_WRAPPERS(WebGLRenderingContextBase) {
     visitor->traceWrappers(unit.m_textureCubeMapBinding);
     visitor->traceWrappers(unit.m_texture3DBinding);
     visitor->traceWrappers(unit.m_texture2DArrayBinding);
+    visitor->traceWrappers(unit.m_textureExternalOESBinding);
   }
   for (ExtensionTracker* tracker : m_extensions) {
     visitor->traceWrappers(tracker);
@@ -102,6 +102,7 @@ class WebGLVertexArrayObjectBase;
 
 class WebGLRenderingContextErrorMessageCallback;
 
+class VRPointCloud;
 class VRSeeThroughCamera;
 
 // This class uses the color mask to prevent drawing to the alpha channel, if
@@ -173,6 +174,12 @@ class MODULES_EXPORT WebGLRenderingContextBase : public CanvasRenderingContext,
   void bufferSubData(GLenum target,
                      long long offset,
                      const FlexibleArrayBufferView& data);
+  // Fills the bound buffer from offset to its end with the latest point
+  // cloud, 3 floats per point. The points are written by the GPU process so
+  // they never go through the renderer. The unused points hold FLT_MAX
+  // (VRPointCloud.points has no such values), only the valid ones and the
+  // ones the previous point cloud used are written.
+  void bufferSubData(GLenum target, long long offset, VRPointCloud*);
 
   GLenum checkFramebufferStatus(GLenum target);
   void clear(GLbitfield mask);
@@ -224,6 +231,10 @@ class MODULES_EXPORT WebGLRenderingContextBase : public CanvasRenderingContext,
   WebGLRenderbuffer* createRenderbuffer();
   WebGLShader* createShader(GLenum type);
   WebGLTexture* createTexture();
+  // Creates a texture that can only be bound to TEXTURE_EXTERNAL_OES, sampled
+  // with a samplerExternalOES and updated with the see through camera image
+  // using texImage2D(TEXTURE_EXTERNAL_OES, ..., VRSeeThroughCamera).
+  WebGLTexture* createCameraTexture();
 
   void cullFace(GLenum mode);
 
@@ -382,12 +393,22 @@ class MODULES_EXPORT WebGLRenderingContextBase : public CanvasRenderingContext,
                   GLenum type,
                   ImageBitmap*,
                   ExceptionState&);
+  // Updates the texture bound to target, which has to be
+  // TEXTURE_EXTERNAL_OES, with the camera frame that matches the latest pose.
   void texImage2D(GLenum target, 
                   GLint level, 
                   GLint internalformat,
                   GLenum format, 
                   GLenum type, 
                   VRSeeThroughCamera*);
+  // The same with the id of the camera frame, as in VRSeeThroughCamera.frameId.
+  // The VRDisplay only lives on the document, so a worker rendering into an
+  // OffscreenCanvas gets the frame id posted along with the pose instead.
+  void updateCameraTexture(GLenum target, GLuint cameraFrameId);
+  // Has the embedder draw the camera frame beneath the page instead of the
+  // page drawing it into the canvas. Called once per frame, the canvas and the
+  // page background need to be transparent for the camera to show.
+  void updateCameraUnderlay(GLuint cameraFrameId);
 
   void texParameterf(GLenum target, GLenum pname, GLfloat param);
   void texParameteri(GLenum target, GLenum pname, GLint param);
@@ -575,6 +596,7 @@ class MODULES_EXPORT WebGLRenderingContextBase : public CanvasRenderingContext,
     TraceWrapperMember<WebGLTexture> m_textureCubeMapBinding;
     TraceWrapperMember<WebGLTexture> m_texture3DBinding;
     TraceWrapperMember<WebGLTexture> m_texture2DArrayBinding;
+    TraceWrapperMember<WebGLTexture> m_textureExternalOESBinding;
 
     DECLARE_TRACE();
     // Wrappers are traced by parent since TextureUnitState is not a heap
@@ -1626,6 +1648,9 @@ class MODULES_EXPORT WebGLRenderingContextBase : public CanvasRenderingContext,
                                  GLsizei,
                                  GLint,
                                  ExceptionState&);
+  void updateCameraTextureHelper(const char* funcName,
+                                 GLenum target,
+                                 GLuint cameraFrameId);
   void texImageHelperVRSeeThroughCamera(TexImageFunctionID, 
                                         GLenum, 
                                         GLint, 
@@ -1678,7 +1703,6 @@ class MODULES_EXPORT WebGLRenderingContextBase : public CanvasRenderingContext,
   sk_sp<SkImage> makeImageSnapshot(SkImageInfo&);
 
   uint8_t* m_cameraImageRGB;
-  GLuint m_cameraImageTextureId;
   
   const unsigned m_version;
 
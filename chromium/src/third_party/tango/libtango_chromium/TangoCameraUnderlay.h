@@ -0,0 +1,86 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TANGO_CAMERA_UNDERLAY_H_
+#define _TANGO_CAMERA_UNDERLAY_H_
+
+#include "TangoLazySensor.h"
+
+#include <stdint.h>
+
+#include <atomic>
+
+// The time, in seconds, the underlay is still drawn after the last page frame
+// that used it, so a page that drops a few frames does not make it flicker.
+#define TANGO_CAMERA_UNDERLAY_IDLE_TIMEOUT 0.5
+
+namespace tango_chromium {
+
+// TangoCameraUnderlay draws the color camera image over the whole viewport of
+// the embedder, beneath the web contents. The pages that use it render only
+// the virtual content on a transparent canvas. The canvas is then blended over
+// the camera image, so the fill rate is about the same as drawing the camera
+// into an opaque canvas (see tango_camera_underlay_perftests); only a hardware
+// overlay plane, which the embedder does not have, would save it.
+//
+// The pages set the camera frame of each of their frames with
+// setCameraFrameId, on the GPU thread and in order with the rest of their GL
+// commands. The embedder draws the latest one it has been given on its own GL
+// context right before compositing the web contents. The camera frame is not
+// tied to the compositor frame that is drawn: when the page is a frame ahead
+// of the compositor, the image is a frame newer than the virtual content. The
+// pages that need the image to match their pose exactly draw it themselves
+// with a camera texture. The GL types are kept out of this header as it is
+// shared by the backends.
+class TangoCameraUnderlay {
+public:
+	TangoCameraUnderlay();
+
+	void setCameraFrameId(uint32_t cameraFrameId);
+	// Whether a page has set a camera frame lately.
+	bool isInUse();
+
+	// Returns the texture for target (GL_TEXTURE_EXTERNAL_OES or
+	// GL_TEXTURE_2D) to update with the camera image, creating the GL objects
+	// on the current context the first time. Returns 0 on failure.
+	uint32_t getTexture(uint32_t target);
+	// Returns the camera frame to upload into the texture before drawing, or
+	// 0 if the texture already holds it.
+	uint32_t getCameraFrameIdToUpload();
+	// Draws the texture over the width x height viewport, rotated from the
+	// sensor orientation (in degrees) to the activity orientation (the Android
+	// display rotation). Only the (0, 0) - (u, v) part of the texture holds
+	// the camera image.
+	void draw(int width, int height, int activityOrientation, int sensorOrientation, float u, float v);
+
+private:
+	bool createGLResources(uint32_t target);
+
+	std::atomic<uint32_t> cameraFrameId;
+	TangoLazySensor usage;
+
+	// Only accessed on the GL thread of the embedder.
+	uint32_t target;
+	uint32_t program;
+	uint32_t texture;
+	int positionAttribute;
+	int textureCoordAttribute;
+	uint32_t uploadedCameraFrameId;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _TANGO_CAMERA_UNDERLAY_H_
@@ -20,25 +20,28 @@
 #include "tango_client_api.h"   // NOLINT
 #include "tango_support_api.h"  // NOLINT
 
+#include "TangoBackend.h"
+#include "TangoCameraUnderlay.h"
+#include "TangoLazySensor.h"
+#include "TangoLog.h"
+
 #include <pthread.h>
+#include <atomic>
+#include <memory>
 
 #include <ctime>
 
 #include <jni.h>
-#include <android/log.h>
 
 #include <string>
 #include <vector>
-#include <queue>
-
-#define LOG_TAG "Tango Chromium"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#include <deque>
 
 // Some preprocessor symbols that allow to control some of the TangoHandler features/capabilities.
 #define TANGO_USE_POINT_CLOUD
 #define TANGO_USE_POINT_CLOUD_CALLBACK
 #define TANGO_USE_CAMERA
+#define TANGO_USE_SESSION_RECORDING
 // #define TANGO_USE_DRIFT_CORRECTION
 // #define TANGO_USE_AREA_DESCRIPTION
 
@@ -48,38 +51,74 @@
 #define TANGO_COORDINATE_FRAME TANGO_COORDINATE_FRAME_START_OF_SERVICE
 #endif
 
-#define MAX_NUMBER_OF_TANGO_BUFFER_IDS 1
+#define MAX_NUMBER_OF_TANGO_FRAME_PAIRS 1
+
+// The default depth framerate while the point cloud is being used (see
+// configureSensors). Depth is turned off at runtime (framerate 0) when it is
+// not.
+#define TANGO_DEPTH_FRAMERATE TANGO_MAX_DEPTH_FRAMERATE
+
+// The size of the grid used to sample the color camera undistortion.
+#define CAMERA_UNDISTORTION_LUT_WIDTH 32
+#define CAMERA_UNDISTORTION_LUT_HEIGHT 24
+
+// The session recording queues at most this amount of data before dropping
+// samples and records the camera frames at half the resolution.
+#define TANGO_SESSION_RECORDING_MAX_QUEUED_BYTES (64 * 1024 * 1024)
+#define TANGO_SESSION_RECORDING_CAMERA_FRAME_DOWNSCALE 2
+
+#ifdef TANGO_USE_SESSION_RECORDING
+#include "TangoSessionRecorder.h"
+#endif
 
 namespace tango_chromium {
 
-class ADF {
-public:
-	ADF(const std::string& uuid, const std::string& name, unsigned long long creationTime): uuid(uuid), name(name), creationTime(creationTime)
-	{
-	}
-
-	inline const std::string& getUUID() const
-	{
-		return uuid;
-	}
-
-	inline const std::string& getName() const
-	{
-		return name;
-	}
-	
-	inline unsigned long long getCreationTime() const
-	{
-		return creationTime;
-	}
-private:
-	std::string uuid;
-	std::string name;
-	unsigned long long creationTime;
+// A locked color camera buffer together with the pose that was calculated
+// for the exact timestamp of that buffer. The frameId is handed out along
+// with the pose so the camera texture update can resolve the very same
+// buffer later on and the image and the pose always match.
+struct TangoFramePair {
+	uint32_t frameId;
+	TangoBufferId bufferId;
+	double timestamp;
+	TangoPoseData pose;
+};
+
+// Everything about the connection, the color camera and the latest camera
+// frame that the browser (device/vr) and the GPU (camera texture update)
+// threads read. A published snapshot is never modified: the writers
+// (connection, disconnection, device rotation and the pose requests that lock
+// a new camera frame) copy the current one, change the copy and publish it as
+// a whole, so readers get a consistent view on any thread without a lock.
+struct TangoHandlerState {
+	TangoHandlerState();
+
+	TangoConnectionState connectionState;
+	// Only set for TANGO_CONNECTION_STATE_FAILED.
+	std::string connectionError;
+	bool connected;
+	// The area description of the connection, empty if there is none.
+	std::string areaDescriptionUUID;
+	int activityOrientation;
+	int sensorOrientation;
+	uint32_t cameraImageWidth;
+	uint32_t cameraImageHeight;
+	uint32_t cameraImageTextureWidth;
+	uint32_t cameraImageTextureHeight;
+	TangoCameraIntrinsics cameraIntrinsics;
+	TangoCameraIntrinsics rotatedCameraIntrinsics;
+	// Shared by the snapshots as it only changes with the intrinsics. It is
+	// kept while disconnected to be reused on resume.
+	std::shared_ptr<const std::vector<float> > cameraUndistortionLUT;
+	uint32_t cameraIntrinsicsGeneration;
+	// The latest frame pair handed out by getPose, 0 if there is none. Its
+	// camera buffer may already have been consumed, only the pose and the
+	// frame id can be read from it.
+	std::shared_ptr<const TangoFramePair> latestFramePair;
 };
 
 // TangoHandler provides functionality to communicate with the Tango Service.
-class TangoHandler {
+class TangoHandler : public TangoBackend {
 public:
 	static TangoHandler* getInstance();
 	static void releaseInstance();
@@ -89,72 +128,176 @@ public:
 	// TangoHandler(const TangoHandler& other) = delete;
 	// TangoHandler& operator=(const TangoHandler& other) = delete;
 
-	~TangoHandler();
+	~TangoHandler() override;
 
 	void onCreate(JNIEnv* env, jobject activity, int activityOrientation, int sensorOrientation);
 	void onTangoServiceConnected(JNIEnv* env, jobject binder);
 	void onPause();
 	void onDeviceRotationChanged(int activityOrientation, int sensorOrientation);
 
-	bool isConnected() const;
+	bool isConnected() const override;
+	TangoConnectionState getConnectionState(std::string* error) const override;
 
-	bool getPose(TangoPoseData* tangoPoseData);
+	bool getPose(TangoPoseData* tangoPoseData, uint32_t* cameraFrameId) override;
+	bool getLatestPose(TangoPoseData* tangoPoseData) override;
+	bool getLatestCameraFramePose(TangoPoseData* tangoPoseData, uint32_t* cameraFrameId) override;
 	bool getPoseMatrix(float* matrix);
 
-	unsigned getMaxNumberOfPointsInPointCloud() const;
-	bool getPointCloud(uint32_t* numberOfPoints, float* points, bool justUpdatePointCloud, unsigned pointsToSkip);
-	bool getPickingPointAndPlaneInPointCloud(float x, float y, double* point, double* plane);
-
-	bool getCameraImageSize(uint32_t* width, uint32_t* height);
-	bool getCameraImageTextureSize(uint32_t* width, uint32_t* height);
-	bool getCameraFocalLength(double* focalLengthX, double* focalLengthY);
-	bool getCameraPoint(double* x, double* y);
-	bool updateCameraImageIntoTexture(uint32_t textureId);
+	unsigned getMaxNumberOfPointsInPointCloud() const override;
+	uint32_t getPointCloudGeneration() const override;
+	uint32_t getLatestCameraFrameId() const override;
+	bool getPointCloud(uint32_t* numberOfPoints, float* points, unsigned maxNumberOfPoints, bool justUpdatePointCloud, unsigned pointsToSkip) override;
+	bool getPickingPointAndPlaneInPointCloud(float x, float y, double* point, double* plane) override;
+
+	bool getCameraImageSize(uint32_t* width, uint32_t* height) override;
+	bool getCameraImageTextureSize(uint32_t* width, uint32_t* height) override;
+	bool getCameraFocalLength(double* focalLengthX, double* focalLengthY) override;
+	bool getCameraPoint(double* x, double* y) override;
+	uint32_t getCameraIntrinsicsGeneration() const override;
+	bool getRotatedCameraIntrinsics(uint32_t* width, uint32_t* height, double* focalLengthX, double* focalLengthY, double* pointX, double* pointY) override;
+	// The undistortion lookup table is only calculated again when the
+	// intrinsics change, which they do not across pause and resume.
+	bool getCameraUndistortionLUT(uint32_t* width, uint32_t* height, std::vector<float>& lut) const override;
+	bool updateCameraImageIntoTexture(uint32_t textureId, uint32_t cameraFrameId) override;
+	void setCameraUnderlayFrameId(uint32_t cameraFrameId) override;
+	bool drawCameraUnderlay(int width, int height) override;
 
 #ifdef TANGO_USE_POINT_CLOUD_CALLBACK
 	void onPointCloudAvailable(const TangoPointCloud* pointCloud);
 #endif
+	void onPoseAvailable(const TangoPoseData* pose);
 	
 	void onCameraFrameAvailable(const TangoImageBuffer* buffer);
+	void onTextureAvailable();
+	// Called on the connection thread.
+	void runConnectThread();
+
+#ifdef TANGO_USE_SESSION_RECORDING
+	// Records the session into the file at path until stopRecording is called.
+	// Reconnects to the Tango service if needed to get access to the camera
+	// frames and the Tango events.
+	bool startRecording(const std::string& path);
+	void stopRecording();
+	void onTangoEventAvailable(const TangoEvent* event);
+#endif
+
+	int getSensorOrientation() const override;
+	void getSensorUsage(double* depthTime, double* cameraTime) const override;
+	void updateSensors() override;
 
-	int getSensorOrientation() const;
+	bool getADFs(std::vector<ADF>& adfs) const override;
+	void enableADF(const std::string& uuid) override;
+	void disableADF() override;
 
-	bool getADFs(std::vector<ADF>& adfs) const;
-	void enableADF(const std::string& uuid);
-	void disableADF();
+	bool configureSensors(const TangoSensorConfiguration& configuration, std::string* error) override;
 
 private:
-	void connect(const std::string& uuid);
+	// Connects on a separate thread, the progress is notified with
+	// onConnectionStateChanged. connectAsync, joinConnectThread and
+	// disconnect are called with connectionMutex held.
+	void connectAsync(const std::string& uuid);
+	bool connect(const std::string& uuid, std::string* error);
+	// On failure tangoConfig is freed so a half configured one is never
+	// reused.
+	bool createConfig(const std::string& uuid, std::string* error);
+	bool setUpConfig(const std::string& uuid, std::string* error);
+	bool connectionFailed(std::string* error, const char* format, ...);
+	void joinConnectThread();
+	void setConnectionState(TangoConnectionState state, const std::string& error);
 	void disconnect();
+	// Returns the latest published state, which stays valid as long as the
+	// caller holds it.
+	std::shared_ptr<const TangoHandlerState> getState() const;
+	// Returns a copy of the latest state to be modified and published with
+	// publishState. The writers are serialized in between.
+	std::shared_ptr<TangoHandlerState> beginStateUpdate();
+	void publishState(const std::shared_ptr<TangoHandlerState>& newState);
+	bool getPoseAtTime(double timestamp, const TangoHandlerState& state, TangoPoseData* tangoPoseData);
+	static void updateRotatedCameraIntrinsics(TangoHandlerState& state);
+	static std::shared_ptr<const std::vector<float> > calculateCameraUndistortionLUT(const TangoCameraIntrinsics& intrinsics);
 	bool hasLastTangoImageBufferTimestampChangedLately();
+	void setDepthFramerate(int framerate);
+	// Called with tangoFramePairsMutex held. Locks the latest camera buffer,
+	// calculates its pose and publishes the pair. Returns 0 on failure.
+	std::shared_ptr<const TangoFramePair> lockFramePair();
+	// Called with tangoFramePairsMutex held. Takes the pair of cameraFrameId
+	// (or the oldest one if it is not there) out of the queue, along with the
+	// older ones that will never be rendered, for the caller to unlock.
+	// Returns false if the queue is empty.
+	bool takeFramePair(uint32_t cameraFrameId, TangoBufferId* tangoBufferId, std::vector<TangoBufferId>* skippedTangoBufferIds);
+	void unlockCameraBuffers();
 
 	static TangoHandler* instance;
 
-	bool connected;
+	// Only accessed with std::atomic_load and std::atomic_store.
+	std::shared_ptr<const TangoHandlerState> state;
+	pthread_mutex_t stateWriteMutex;
+	// The connection is started and stopped from the JNI, the UI and the
+	// device/vr worker threads. connectionMutex serializes them and guards
+	// the connection thread, the uuids and the configuration. The connection
+	// thread is always joined before connecting again or disconnecting, it
+	// only reads connectUUID and the configuration while it runs.
+	pthread_mutex_t connectionMutex;
+	pthread_t connectThread;
+	bool connectThreadRunning;
+	std::string connectUUID;
+	// Written by the pose callback thread and on disconnection, which can
+	// happen while a callback is still running.
+	std::atomic<bool> tracking;
+	// The configuration is kept across pause and resume for the same area
+	// description.
 	TangoConfig tangoConfig;
-	TangoCameraIntrinsics tangoCameraIntrinsics;
-	double lastTangoImageBufferTimestamp;
-	std::time_t lastTangoImagebufferTimestampTime;
+	std::string tangoConfigUUID;
+	// Written by the pose and the camera texture updates, read by the
+	// picking on other threads.
+	std::atomic<double> lastTangoImageBufferTimestamp;
+	std::atomic<std::time_t> lastTangoImagebufferTimestampTime;
 
 	unsigned maxNumberOfPointsInPointCloud;
 	TangoSupportPointCloudManager* pointCloudManager;
-	TangoPointCloud* latestTangoPointCloud;
-	bool latestTangoPointCloudRetrieved;
-
-	uint32_t cameraImageWidth;
-	uint32_t cameraImageHeight;
-	uint32_t cameraImageTextureWidth;
-	uint32_t cameraImageTextureHeight;
+	// The point cloud manager hands out its latest point cloud to a single
+	// consumer at a time (the point cloud and the picking requests can come
+	// from different threads).
+	pthread_mutex_t pointCloudManagerMutex;
+	std::atomic<uint32_t> pointCloudGeneration;
 
-	bool textureIdConnected;
-
-	int activityOrientation;
-	int sensorOrientation;
+	std::atomic<bool> textureIdConnected;
 
+	// Guarded by connectionMutex. The pose threads use the uuid of the
+	// published state instead.
 	std::string lastEnabledADFUUID;
 
-	pthread_mutex_t tangoBufferIdsMutex;
-	std::queue<TangoBufferId> tangoBufferIds;
+	// A locked camera buffer has a single owner: the queue until a camera
+	// texture update takes it out to upload and unlock it. The mutex guards
+	// the queue and nextCameraFrameId. Locking a buffer, calculating its pose
+	// and publishing the pair is a single step under it, so concurrent pose
+	// requests never lock more buffers than MAX_NUMBER_OF_TANGO_FRAME_PAIRS.
+	// Readers of the pose and the frame id of the latest pair use the
+	// published state instead.
+	pthread_mutex_t tangoFramePairsMutex;
+	std::deque<TangoFramePair> tangoFramePairs;
+	uint32_t nextCameraFrameId;
+	// The buffer of the latest camera underlay frame, taken out of the queue
+	// on the GPU thread and handed to the embedder thread, which uploads and
+	// unlocks it. Guarded by tangoFramePairsMutex.
+	TangoBufferId underlayTangoBufferId;
+	bool hasUnderlayTangoBuffer;
+
+	// Depth is enabled with the first getPointCloud and the camera buffers are
+	// locked from the first camera texture update on. Both are turned off
+	// again when they are not used for a while.
+	TangoLazySensor depthSensor;
+	TangoLazySensor cameraSensor;
+
+	TangoCameraUnderlay cameraUnderlay;
+
+	// Set with configureSensors, read from the point cloud threads.
+	std::atomic<int> depthFramerate;
+	std::atomic<unsigned> maxNumberOfPointsInPointCloudLimit;
+
+#ifdef TANGO_USE_SESSION_RECORDING
+	TangoSessionRecorder sessionRecorder;
+#endif
 };
 }  // namespace tango_4_chromium
 
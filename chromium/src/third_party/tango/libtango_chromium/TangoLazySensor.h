@@ -0,0 +1,134 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TANGO_LAZY_SENSOR_H_
+#define _TANGO_LAZY_SENSOR_H_
+
+#include <pthread.h>
+#include <time.h>
+
+// The time, in seconds, a sensor stream stays enabled after its last use.
+#define TANGO_SENSOR_IDLE_TIMEOUT 5.0
+
+namespace tango_chromium {
+
+// TangoLazySensor keeps track of the use of a sensor stream (depth, color
+// camera) so it is only enabled while the pages need it. The backend calls
+// use() every time it needs the stream and update() regularly (see
+// TangoBackend::updateSensors) to know when the stream has been idle long
+// enough to turn it off. It also accumulates the time the stream has been
+// enabled so the savings can be measured. The Tango service cannot turn the
+// color camera off without reconnecting, so for the camera only the locking
+// of the camera buffers is lazy: its time is the time they were locked.
+class TangoLazySensor {
+public:
+	explicit TangoLazySensor(double idleTimeout = TANGO_SENSOR_IDLE_TIMEOUT): idleTimeout(idleTimeout)
+		, enabled(false)
+		, lastUseTime(0)
+		, enabledSince(0)
+		, enabledTime(0)
+	{
+		pthread_mutex_init(&mutex, 0);
+	}
+
+	~TangoLazySensor()
+	{
+		pthread_mutex_destroy(&mutex);
+	}
+
+	// Returns true if the stream was disabled and has to be enabled now.
+	bool use()
+	{
+		double currentTime = now();
+		pthread_mutex_lock(&mutex);
+		bool enable = !enabled;
+		if (enable)
+		{
+			enabled = true;
+			enabledSince = currentTime;
+		}
+		lastUseTime = currentTime;
+		pthread_mutex_unlock(&mutex);
+		return enable;
+	}
+
+	// Returns true if the stream was enabled and has not been used for the
+	// idle timeout so it has to be disabled now.
+	bool update()
+	{
+		double currentTime = now();
+		pthread_mutex_lock(&mutex);
+		bool disable = enabled && currentTime - lastUseTime > idleTimeout;
+		if (disable)
+		{
+			enabled = false;
+			enabledTime += currentTime - enabledSince;
+		}
+		pthread_mutex_unlock(&mutex);
+		return disable;
+	}
+
+	// Marks the stream as disabled without asking to disable it, when the
+	// whole connection goes away.
+	void reset()
+	{
+		double currentTime = now();
+		pthread_mutex_lock(&mutex);
+		if (enabled)
+		{
+			enabled = false;
+			enabledTime += currentTime - enabledSince;
+		}
+		pthread_mutex_unlock(&mutex);
+	}
+
+	bool isEnabled() const
+	{
+		pthread_mutex_lock(&mutex);
+		bool result = enabled;
+		pthread_mutex_unlock(&mutex);
+		return result;
+	}
+
+	// The total time, in seconds, the stream has been enabled.
+	double getEnabledTime() const
+	{
+		double currentTime = now();
+		pthread_mutex_lock(&mutex);
+		double result = enabledTime + (enabled ? currentTime - enabledSince : 0);
+		pthread_mutex_unlock(&mutex);
+		return result;
+	}
+
+private:
+	static double now()
+	{
+		struct timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return time.tv_sec + time.tv_nsec / 1000000000.0;
+	}
+
+	mutable pthread_mutex_t mutex;
+	double idleTimeout;
+	bool enabled;
+	double lastUseTime;
+	double enabledSince;
+	double enabledTime;
+};
+
+}  // namespace tango_chromium
+
+#endif  // _TANGO_LAZY_SENSOR_H_
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TANGO_LOG_H_
+#define _TANGO_LOG_H_
+
+#define LOG_TAG "Tango Chromium"
+
+#ifdef __ANDROID__
+
+#include <android/log.h>
+
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+#else
+
+// The replay backend runs on desktop platforms too.
+#include <cstdio>
+
+#define LOGI(...) (std::fprintf(stderr, "I/" LOG_TAG ": " __VA_ARGS__), std::fputc('\n', stderr))
+#define LOGE(...) (std::fprintf(stderr, "E/" LOG_TAG ": " __VA_ARGS__), std::fputc('\n', stderr))
+
+#endif
+
+#endif  // _TANGO_LOG_H_
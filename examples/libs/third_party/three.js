@@ -17770,6 +17770,14 @@
 
 		function setTexture2D( texture, slot ) {
 
+			// Added by WebAR: the see through camera image can only be held by a camera texture.
+			if ( texture.WebAR_isSeeThroughCamera === true ) {
+
+				setTextureExternalOES( texture, slot );
+				return;
+
+			}
+
 			var textureProperties = properties.get( texture );
 
 			if ( texture.version > 0 && textureProperties.__version !== texture.version ) {
@@ -17798,6 +17806,36 @@
 
 		}
 
+		// Added by WebAR: the texture is created with createCameraTexture, bound to TEXTURE_EXTERNAL_OES and sampled with a samplerExternalOES.
+		function setTextureExternalOES( texture, slot ) {
+
+			var textureProperties = properties.get( texture );
+
+			if ( textureProperties.__webglInit === undefined ) {
+
+				textureProperties.__webglInit = true;
+
+				texture.addEventListener( 'dispose', onTextureDispose );
+
+				textureProperties.__webglTexture = _gl.createCameraTexture();
+
+				_infoMemory.textures ++;
+
+			}
+
+			state.activeTexture( _gl.TEXTURE0 + slot );
+			state.bindTexture( _gl.TEXTURE_EXTERNAL_OES, textureProperties.__webglTexture );
+
+			if ( texture.version > 0 && textureProperties.__version !== texture.version ) {
+
+				_gl.texImage2D( _gl.TEXTURE_EXTERNAL_OES, 0, _gl.RGB, _gl.RGB, _gl.UNSIGNED_BYTE, texture.image );
+
+				textureProperties.__version = texture.version;
+
+			}
+
+		}
+
 		function setTextureCube( texture, slot ) {
 
 			var textureProperties = properties.get( texture );